@@ -43,12 +43,68 @@
 // This requires defining the logic in keymap.c
 #define BILATERAL_COMBINATIONS
 
+// Let the bilateral engine settle home row mods before the tapping term:
+// same-hand key = tap, opposite-hand key = hold once past the roll window
+#define HOLD_ON_OTHER_KEY_PRESS_PER_KEY
+#define BILATERAL_ROLL_MIN_MS 50   // Roll window bounds, adapted to typing speed
+#define BILATERAL_ROLL_MAX_MS 100
+
+// Typing flow: a home row mod pressed within this time of the previous
+// letter on the same hand is a tap right away; holds need a short pause
+#define BILATERAL_FLOW_MS 150
+
+// Learn a tapping term per home row mod from live typing (stored in EEPROM)
+#define ADAPTIVE_TAPPING_TERM
+#define ADAPTIVE_TT_MIN 128  // Learned terms stay within these bounds
+#define ADAPTIVE_TT_MAX 240
+
 // ============================================================================
 // Tap Dance Configuration
 // ============================================================================
 
 #define TAPPING_TOGGLE 2  // How many taps to toggle a layer
 
+// ============================================================================
+// Macro Configuration
+// ============================================================================
+
+// Play M_IDLE/M_AREA/M_FULL from a queue, one report per USB poll, instead
+// of blocking the scan loop with SEND_STRING
+#define MACRO_QUEUE_ENABLE
+#define MACRO_QUEUE_DEPTH 4  // Macros waiting at once (pointers only)
+
+// ============================================================================
+// Vial Keymap Writes
+// ============================================================================
+
+// Whole-layer keymap uploads over raw HID (scripts/hrmods-hid.py keymap
+// load), staged in RAM and committed once per batch
+#define KEYMAP_BATCH_ENABLE
+#define KEYMAP_BATCH_IDLE_MS 500  // Commit staged keys after this much quiet
+
+// ============================================================================
+// Idle Power Mode
+// ============================================================================
+
+// Scan and refresh the indicators less often once a half has been idle,
+// freezing the LED frame after 30 s; any key edge restores full rate at
+// once. RGB_MATRIX_TIMEOUT below still turns the LEDs off after 10 minutes.
+#define POWER_MODE_ENABLE
+#define POWER_MODE_STEPS {{5000, 10, 100}, {30000, 50, 0}}  // {idle ms, scan ms, indicator ms}
+
+// ============================================================================
+// Diagnostics
+// ============================================================================
+
+// Latency and scan-rate histograms in RAM, read with scripts/hrmods-hid.py
+// over Vial raw HID (~384 bytes RAM, a few us of overhead per key event)
+#define LATENCY_STATS_ENABLE
+
+// Typing trace recorder for offline tuning; idle until started over raw
+// HID with scripts/hrmods-hid.py (comment out to compile it out)
+#define TRACE_RECORDER_ENABLE
+#define TRACE_RECORDER_SIZE 8192  // Ring buffer bytes, ~4000 events
+
 // ============================================================================
 // RGB Matrix Configuration
 // ============================================================================
@@ -102,9 +158,11 @@
 // Combo Configuration
 // ============================================================================
 
-// Combos disabled for now - no combos defined in keymap
-// #define VIAL_COMBO_ENTRIES 8  // Number of combos defined (VIAL uses VIAL_COMBO_ENTRIES instead of COMBO_COUNT)
-// #define COMBO_TERM 50  // Time window for combo activation (ms)
+// Combos from combos.def through features/combo_engine.c; keys in no combo
+// are never delayed. The combos edited in Vial (.vil "combo") still go
+// through QMK's combo feature, and keys the engine held back reach it too.
+#define COMBO_ENGINE_ENABLE
+#define COMBO_ENGINE_TERM 30  // Max time between the presses of a combo (ms)
 
 // ============================================================================
 // Firmware Size Optimization
@@ -133,9 +191,13 @@
 #    undef SERIAL_USART_RX_PIN
 #endif
 #define SERIAL_USART_RX_PIN GP1
-#define SPLIT_POINTING_ENABLE
 #define ROTARY_ENCODER_RESOLUTION 4
 
+// Master sends the RGB layer indicator state (layer + active key mask,
+// 9 bytes) to the slave over a user RPC, only when it changes
+#define INDICATOR_SYNC_ENABLE
+#define SPLIT_TRANSACTION_IDS_USER RPC_ID_USER_INDICATORS
+
 // ============================================================================
 // USB Configuration
 // ============================================================================
@@ -146,4 +208,6 @@
 // Debounce Configuration
 // ============================================================================
 
+// With DEBOUNCE_TYPE = custom (rules.mk) presses are reported on the first
+// edge and only releases wait for the contact to stay open this long
 #define DEBOUNCE 5  // Default debounce time in ms
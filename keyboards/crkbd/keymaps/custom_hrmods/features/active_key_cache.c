@@ -0,0 +1,103 @@
+/* Copyright 2024
+ * Active Key Cache for RGB Layer Indicators
+ *
+ * The layer indicator needs to know, for every LED on every scan, whether
+ * its key does something on the current layer. With Vial the keymap lives
+ * in emulated EEPROM on flash, so asking keymap_key_to_keycode() for each
+ * LED each scan is the most expensive part of the indicator.
+ *
+ * Instead, keep one bit per LED per layer in RAM (4 x 8 bytes) and only
+ * rebuild it when the keymap actually changes: on boot, after a Vial
+ * keymap write and after an EEPROM reset. Without a dynamic keymap the
+ * rebuild reads the masks generated from layout.yaml instead.
+ */
+
+#include QMK_KEYBOARD_H
+#include "active_key_cache.h"
+#include "layout.gen.h"
+
+#ifdef RGB_MATRIX_ENABLE
+
+_Static_assert(RGB_MATRIX_LED_COUNT <= 64, "active key cache holds at most 64 LEDs");
+
+static uint64_t active_leds[ACTIVE_KEY_CACHE_LAYERS];
+static uint64_t key_leds;
+static bool     cache_valid = false;
+
+// Transparent and KC_NO keys do nothing on a layer
+static bool is_key_active(uint8_t layer, uint8_t row, uint8_t col) {
+#    ifdef DYNAMIC_KEYMAP_ENABLE
+    // Vial may have remapped the key: ask the live keymap
+    uint16_t keycode = keymap_key_to_keycode(layer, (keypos_t){col, row});
+
+    return keycode != KC_TRNS && keycode != KC_NO;
+#    else
+    // The compiled keymap is all there is: use the generated masks
+    return layer < LAYOUT_LAYER_COUNT && (layout_active_keys[layer] & LAYOUT_KEY_BIT(row, col));
+#    endif
+}
+
+static void active_key_cache_rebuild(void) {
+    memset(active_leds, 0, sizeof(active_leds));
+    key_leds = 0;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint8_t led = g_led_config.matrix_co[row][col];
+
+            if (led == NO_LED || led >= RGB_MATRIX_LED_COUNT) {
+                continue;
+            }
+            key_leds |= (uint64_t)1 << led;
+
+            for (uint8_t layer = 0; layer < ACTIVE_KEY_CACHE_LAYERS; layer++) {
+                if (is_key_active(layer, row, col)) {
+                    active_leds[layer] |= (uint64_t)1 << led;
+                }
+            }
+        }
+    }
+    cache_valid = true;
+}
+
+uint64_t active_key_cache_layer(uint8_t layer) {
+    if (layer >= ACTIVE_KEY_CACHE_LAYERS) {
+        return 0;
+    }
+    if (!cache_valid) {
+        active_key_cache_rebuild();
+    }
+    return active_leds[layer];
+}
+
+uint64_t active_key_cache_key_leds(void) {
+    if (!cache_valid) {
+        active_key_cache_rebuild();
+    }
+    return key_leds;
+}
+
+void active_key_cache_invalidate(void) {
+    cache_valid = false;
+}
+
+#    ifdef VIA_ENABLE
+void active_key_cache_via_command(const uint8_t *data, uint8_t length) {
+    if (length == 0) {
+        return;
+    }
+
+    // Called before VIA handles the command; the rebuild happens lazily
+    // on the next indicator pass, after the write has landed
+    switch (data[0]) {
+        case id_dynamic_keymap_set_keycode:
+        case id_dynamic_keymap_reset:
+        case id_dynamic_keymap_set_buffer:
+        case id_eeprom_reset:
+            active_key_cache_invalidate();
+            break;
+    }
+}
+#    endif
+
+#endif // RGB_MATRIX_ENABLE
@@ -0,0 +1,33 @@
+/* Copyright 2024
+ * Active Key Cache for RGB Layer Indicators - Header
+ */
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+#include "layout.gen.h"
+
+#ifdef RGB_MATRIX_ENABLE
+
+// Layers covered by the cache (the layers in layout.yaml)
+#ifndef ACTIVE_KEY_CACHE_LAYERS
+#    define ACTIVE_KEY_CACHE_LAYERS LAYOUT_LAYER_COUNT
+#endif
+
+// Bitmask of LEDs whose key is active (not KC_NO/KC_TRNS) on a layer.
+// Bit n corresponds to LED index n in g_led_config order.
+uint64_t active_key_cache_layer(uint8_t layer);
+
+// Bitmask of LEDs that belong to a key at all
+uint64_t active_key_cache_key_leds(void);
+
+// Mark the cache stale after the keymap changed (Vial write, EEPROM reset).
+// The next lookup rebuilds it.
+void active_key_cache_invalidate(void);
+
+#    ifdef VIA_ENABLE
+// Inspect a raw HID command and invalidate the cache if it changes the keymap
+void active_key_cache_via_command(const uint8_t *data, uint8_t length);
+#    endif
+
+#endif // RGB_MATRIX_ENABLE
@@ -0,0 +1,208 @@
+/* Copyright 2024
+ * Adaptive Tapping Terms for Home Row Mods
+ *
+ * Pinky and index fingers tap at very different speeds, so one term for
+ * all eight home row mods is either too long for T/N or too short for A/O.
+ * This learns a term per key from live typing:
+ *
+ *   - Every tap of a home row mod made during continuous typing (the
+ *     previous key press was less than ADAPTIVE_TT_BURST_MS ago) updates a
+ *     fixed-point running mean and mean deviation of its tap duration
+ *     (EWMA, weight 1/8, 4 fractional bits).
+ *   - A hold released without any other key pressed in between was a tap
+ *     that came too slowly; it is learned as a tap too, which pulls a term
+ *     that got too tight back up.
+ *   - The key's term is mean + 4 x deviation, clamped to
+ *     [ADAPTIVE_TT_MIN, ADAPTIVE_TT_MAX].
+ *
+ * Terms are stored in the 32-bit EEPROM user word as 3-bit steps up from
+ * ADAPTIVE_TT_MIN (bits 0-23, three per key) next to a learned bit per key
+ * (bits 24-31), so both bounds survive a power cycle. The word is written
+ * at most once per ADAPTIVE_TT_SAVE_INTERVAL, only when it changed.
+ */
+
+#include QMK_KEYBOARD_H
+#include "adaptive_tapping_term.h"
+#include "layout.gen.h"
+
+#ifdef ADAPTIVE_TAPPING_TERM
+
+#    ifndef ADAPTIVE_TT_MIN
+#        define ADAPTIVE_TT_MIN 128
+#    endif
+#    ifndef ADAPTIVE_TT_MAX
+#        define ADAPTIVE_TT_MAX 240
+#    endif
+#    ifndef ADAPTIVE_TT_BURST_MS
+#        define ADAPTIVE_TT_BURST_MS 500
+#    endif
+#    ifndef ADAPTIVE_TT_SAVE_INTERVAL
+#        define ADAPTIVE_TT_SAVE_INTERVAL 300000  // 5 minutes, limits flash wear
+#    endif
+
+#    define ADAPTIVE_TT_KEYS 8       // A step and a learned bit each in the 32-bit user word
+#    define ADAPTIVE_TT_STEP_BITS 3  // Steps 0-7, from ADAPTIVE_TT_MIN up to ADAPTIVE_TT_MAX
+#    define ADAPTIVE_TT_STEP_MASK ((1 << ADAPTIVE_TT_STEP_BITS) - 1)
+#    define ADAPTIVE_TT_STEP ((ADAPTIVE_TT_MAX - ADAPTIVE_TT_MIN) / ADAPTIVE_TT_STEP_MASK)
+#    define ADAPTIVE_TT_LEARNED_SHIFT (ADAPTIVE_TT_KEYS * ADAPTIVE_TT_STEP_BITS)
+#    define ADAPTIVE_TT_FRAC 4  // Fixed-point fractional bits
+#    define ADAPTIVE_TT_GAIN 3  // EWMA weight 1/2^3
+#    define ADAPTIVE_TT_DEV_INIT (10 << ADAPTIVE_TT_FRAC)
+#    define ADAPTIVE_TT_MIN_SAMPLE 20  // Shorter "taps" are chatter
+
+_Static_assert(LAYOUT_HOME_ROW_MODS <= ADAPTIVE_TT_KEYS, "one EEPROM step per home row mod");
+_Static_assert(ADAPTIVE_TT_LEARNED_SHIFT + ADAPTIVE_TT_KEYS <= 32, "steps and learned bits fit the user word");
+_Static_assert((ADAPTIVE_TT_MAX - ADAPTIVE_TT_MIN) % ADAPTIVE_TT_STEP_MASK == 0, "term range must split into 7 equal steps");
+
+typedef struct {
+    int32_t  mean;       // Tap duration, ms << ADAPTIVE_TT_FRAC
+    int32_t  dev;        // Mean absolute deviation, same scale
+    uint16_t term;       // 0 = not learned, use the fallback
+    uint16_t pressed;    // Timestamp of the last press
+    uint8_t  press_seq;  // press_count at the last press
+    bool     in_burst;   // Last press was part of continuous typing
+} key_estimate_t;
+
+static key_estimate_t estimates[ADAPTIVE_TT_KEYS];
+static uint16_t       last_press_time;
+static uint8_t        press_count;
+static uint32_t       saved_word;
+static uint32_t       last_save;
+
+// Slot of a home row mod, from the layout tables (LAYOUT order: A R S T N E I O)
+static int8_t key_index(uint16_t keycode, keypos_t key) {
+    uint8_t flags = layout_key_flags[key.row][key.col];
+
+    if (!IS_QK_MOD_TAP(keycode) || !(flags & LAYOUT_KEY_HOME_ROW_MOD)) {
+        return -1;
+    }
+    return LAYOUT_KEY_HRM_INDEX(flags);
+}
+
+// Nearest step; learned terms are always within the bounds
+static uint8_t term_to_step(uint16_t term) {
+    return (uint8_t)((term - ADAPTIVE_TT_MIN + ADAPTIVE_TT_STEP / 2) / ADAPTIVE_TT_STEP);
+}
+
+static uint16_t step_to_term(uint8_t step) {
+    return ADAPTIVE_TT_MIN + step * ADAPTIVE_TT_STEP;
+}
+
+static uint32_t encode_terms(void) {
+    uint32_t word = 0;
+
+    for (uint8_t i = 0; i < ADAPTIVE_TT_KEYS; i++) {
+        if (estimates[i].term) {
+            word |= (uint32_t)term_to_step(estimates[i].term) << (ADAPTIVE_TT_STEP_BITS * i);
+            word |= (uint32_t)1 << (ADAPTIVE_TT_LEARNED_SHIFT + i);
+        }
+    }
+    return word;
+}
+
+static uint16_t decode_term(uint32_t word, uint8_t index) {
+    if (!(word >> (ADAPTIVE_TT_LEARNED_SHIFT + index) & 1)) {
+        return 0;
+    }
+    return step_to_term((word >> (ADAPTIVE_TT_STEP_BITS * index)) & ADAPTIVE_TT_STEP_MASK);
+}
+
+static void seed_estimate(key_estimate_t *estimate, uint16_t term) {
+    // Pick mean/deviation so the very next sample starts from the stored term
+    estimate->term = term;
+    estimate->dev  = ADAPTIVE_TT_DEV_INIT;
+    estimate->mean = term ? ((int32_t)term << ADAPTIVE_TT_FRAC) - 4 * ADAPTIVE_TT_DEV_INIT : 0;
+}
+
+void adaptive_tapping_term_init(void) {
+    saved_word = eeconfig_read_user();
+    last_save  = timer_read32();
+
+    for (uint8_t i = 0; i < ADAPTIVE_TT_KEYS; i++) {
+        seed_estimate(&estimates[i], decode_term(saved_word, i));
+    }
+}
+
+void adaptive_tapping_term_reset(void) {
+    memset(estimates, 0, sizeof(estimates));
+    saved_word = 0;
+    eeconfig_update_user(saved_word);
+}
+
+static void learn(key_estimate_t *estimate, uint16_t duration) {
+    int32_t sample = (int32_t)duration << ADAPTIVE_TT_FRAC;
+
+    if (!estimate->term) {
+        // First sample seeds the estimator
+        estimate->mean = sample;
+        estimate->dev  = ADAPTIVE_TT_DEV_INIT;
+    } else {
+        int32_t error = sample - estimate->mean;
+
+        estimate->mean += error >> ADAPTIVE_TT_GAIN;
+        estimate->dev += ((error < 0 ? -error : error) - estimate->dev) >> ADAPTIVE_TT_GAIN;
+    }
+
+    int32_t term = (estimate->mean + 4 * estimate->dev) >> ADAPTIVE_TT_FRAC;
+    if (term < ADAPTIVE_TT_MIN) {
+        term = ADAPTIVE_TT_MIN;
+    } else if (term > ADAPTIVE_TT_MAX) {
+        term = ADAPTIVE_TT_MAX;
+    }
+    estimate->term = (uint16_t)term;
+}
+
+void adaptive_tapping_term_record(uint16_t keycode, keyrecord_t *record) {
+    int8_t   index = key_index(keycode, record->event.key);
+    uint16_t now   = record->event.time;
+
+    if (record->event.pressed) {
+        press_count++;
+        if (index >= 0) {
+            // Only learn from taps made while typing, not isolated presses
+            estimates[index].pressed   = now;
+            estimates[index].press_seq = press_count;
+            estimates[index].in_burst  = (uint16_t)(now - last_press_time) < ADAPTIVE_TT_BURST_MS;
+        }
+        last_press_time = now;
+        return;
+    }
+
+    if (index < 0 || !estimates[index].in_burst) {
+        return;
+    }
+
+    key_estimate_t *estimate = &estimates[index];
+    uint16_t        duration = now - estimate->pressed;
+    bool            lone     = estimate->press_seq == press_count;
+
+    // Taps, and holds that modified nothing (a tap that came too slowly)
+    if ((record->tap.count > 0 || (lone && duration < ADAPTIVE_TT_MAX)) && duration >= ADAPTIVE_TT_MIN_SAMPLE) {
+        learn(estimate, duration);
+    }
+    estimate->in_burst = false;
+}
+
+uint16_t adaptive_tapping_term_get(uint16_t keycode, keypos_t key, uint16_t fallback) {
+    int8_t index = key_index(keycode, key);
+
+    if (index < 0 || !estimates[index].term) {
+        return fallback;
+    }
+    return estimates[index].term;
+}
+
+void adaptive_tapping_term_task(void) {
+    if (timer_elapsed32(last_save) < ADAPTIVE_TT_SAVE_INTERVAL) {
+        return;
+    }
+    last_save = timer_read32();
+
+    uint32_t word = encode_terms();
+    if (word != saved_word) {
+        saved_word = word;
+        eeconfig_update_user(word);
+    }
+}
+
+#endif // ADAPTIVE_TAPPING_TERM
@@ -0,0 +1,26 @@
+/* Copyright 2024
+ * Adaptive Tapping Terms for Home Row Mods - Header
+ */
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifdef ADAPTIVE_TAPPING_TERM
+
+// Restore learned terms from EEPROM; call from keyboard_post_init_user
+void adaptive_tapping_term_init(void);
+
+// Forget learned terms; call from eeconfig_init_user
+void adaptive_tapping_term_reset(void);
+
+// Learn from tap durations; call from process_record_user
+void adaptive_tapping_term_record(uint16_t keycode, keyrecord_t *record);
+
+// Learned term for a home row mod, or fallback for any other key
+uint16_t adaptive_tapping_term_get(uint16_t keycode, keypos_t key, uint16_t fallback);
+
+// Persist changed terms (rate limited); call from housekeeping_task_user
+void adaptive_tapping_term_task(void);
+
+#endif // ADAPTIVE_TAPPING_TERM
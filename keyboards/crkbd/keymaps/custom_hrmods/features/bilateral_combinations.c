@@ -6,102 +6,401 @@
  * trigger Ctrl+Shift unless you intended it.
  *
  * Cross-hand combinations (left Ctrl + right key) work normally.
+ *
+ * On top of that, undecided home row mods are settled early instead of
+ * waiting out the tapping term:
+ *
+ *   - A same-hand key press settles the mod as a tap right away
+ *     ("st" rolls on the left hand type immediately).
+ *   - An opposite-hand key press settles it as a hold, unless it arrives
+ *     so soon after the mod that it is more likely a cross-hand roll.
+ *     That roll window follows the typist: half the median gap between
+ *     recent key presses, clamped to BILATERAL_ROLL_MIN/MAX_MS.
+ *
+ * Thumb keys never settle anything, so layer keys and Space behave as
+ * before. Whatever the engine leaves open is resolved by QMK as usual
+ * (PERMISSIVE_HOLD or the tapping term).
+ *
+ * With BILATERAL_FLOW_MS, fast typing skips the hold/tap decision
+ * altogether: a home row mod pressed within BILATERAL_FLOW_MS of the
+ * previous letter on the same hand is a tap, sent on the press with no
+ * buffering. Holds come back once that hand pauses. A mod is only sent
+ * this way while no other mod-tap or layer-tap is down, tracked here or
+ * not, so letters never overtake one that is still waiting in QMK's
+ * hold/tap logic.
  */
 
 #include QMK_KEYBOARD_H
+#include "bilateral_combinations.h"
+#include "layout.gen.h"
+#include "adaptive_tapping_term.h"
 
 #ifdef BILATERAL_COMBINATIONS
 
-// Track which hand's mods are currently pressed
-static uint8_t left_mods_down = 0;
-static uint8_t right_mods_down = 0;
+#    ifndef BILATERAL_ROLL_MIN_MS
+#        define BILATERAL_ROLL_MIN_MS 50
+#    endif
+#    ifndef BILATERAL_ROLL_MAX_MS
+#        define BILATERAL_ROLL_MAX_MS 100
+#    endif
+
+// Gaps longer than this are pauses, not typing rhythm
+#    define BILATERAL_PAUSE_MS 1000
+
+// Recent key events per hand (power of two)
+#    define BILATERAL_HISTORY 8
+
+// Home row mods that can be undecided at the same time
+#    define BILATERAL_PENDING 4
+
+typedef enum {
+    HAND_LEFT  = LAYOUT_HAND_LEFT,
+    HAND_RIGHT = LAYOUT_HAND_RIGHT,
+    HAND_THUMB = LAYOUT_HAND_THUMB,
+} hand_t;
+
+typedef enum {
+    DECISION_NONE = 0,
+    DECISION_TAP,
+    DECISION_HOLD,
+} decision_t;
+
+typedef struct {
+    uint16_t time;
+    bool     pressed;
+} key_stamp_t;
+
+typedef struct {
+    key_stamp_t events[BILATERAL_HISTORY];
+    uint8_t     head;
+    uint8_t     count;
+} hand_history_t;
+
+typedef struct {
+    keypos_t   key;
+    uint16_t   time;
+    hand_t     hand;
+    decision_t decision;
+    bool       active;
+} pending_mod_t;
+
+static hand_history_t history[2];
+static pending_mod_t  pending[BILATERAL_PENDING];
+
+// Home row mods currently held as modifiers, per hand
+static uint8_t mods_held[2];
 
-// Define which keys are on which hand (for Corne split keyboard)
-// Row 0-2 are left hand, Row 3-5 are right hand (in split configuration)
-static bool is_left_hand_key(keyrecord_t *record) {
-    // For split keyboards, check if the key is on the left half
-    return record->event.key.row < MATRIX_ROWS / 2;
+// Keys whose hold was turned into their tap keycode; released by position
+static matrix_row_t tapped_instead[MATRIX_ROWS];
+
+#    ifdef BILATERAL_FLOW_MS
+// Last letter press per hand, and home row mods sent as taps mid-streak
+static uint16_t     last_letter[2];
+static bool         letter_seen[2];
+static matrix_row_t flow_keys[MATRIX_ROWS];
+
+// Mod-taps and layer-taps down, home row or not: QMK may still be deciding them
+static matrix_row_t tap_hold_keys[MATRIX_ROWS];
+#    endif
+
+// Hand of a key, from the layout tables (rows 0-3 left, 4-7 right, the
+// last row of each half is the thumb cluster)
+static hand_t key_hand(keypos_t key) {
+    return (hand_t)LAYOUT_KEY_HAND(layout_key_flags[key.row][key.col]);
 }
 
-// Per-key tapping term configuration
+// Per-key tapping term from layout.yaml: home row mods get slightly longer
 uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record) {
-    switch (keycode) {
-        // Home row mods get slightly longer tapping term
-        case MT(MOD_LGUI, KC_A):
-        case MT(MOD_LALT, KC_R):
-        case MT(MOD_LCTL, KC_S):
-        case MT(MOD_LSFT, KC_T):
-        case MT(MOD_RSFT, KC_N):
-        case MT(MOD_RCTL, KC_E):
-        case MT(MOD_RALT, KC_I):
-        case MT(MOD_RGUI, KC_O):
-            return TAPPING_TERM + 25;  // 200ms for home row mods
-        default:
-            return TAPPING_TERM;  // 175ms for everything else
-    }
-}
-
-// Check if a keycode is a home row mod-tap
-static bool is_home_row_mod(uint16_t keycode) {
-    switch (keycode) {
-        case MT(MOD_LGUI, KC_A):
-        case MT(MOD_LALT, KC_R):
-        case MT(MOD_LCTL, KC_S):
-        case MT(MOD_LSFT, KC_T):
-        case MT(MOD_RSFT, KC_N):
-        case MT(MOD_RCTL, KC_E):
-        case MT(MOD_RALT, KC_I):
-        case MT(MOD_RGUI, KC_O):
-            return true;
-        default:
-            return false;
+    keypos_t key  = record->event.key;
+    uint16_t term = layout_tapping_term[key.row][key.col];
+
+#    ifdef ADAPTIVE_TAPPING_TERM
+    // Learned per home row mod, the layout's term until enough taps were seen
+    return adaptive_tapping_term_get(keycode, key, term);
+#    else
+    return term;
+#    endif
+}
+
+// Check if a keycode is a home row mod-tap at its layout position
+static bool is_home_row_mod(uint16_t keycode, keypos_t key) {
+    return IS_QK_MOD_TAP(keycode) && (layout_key_flags[key.row][key.col] & LAYOUT_KEY_HOME_ROW_MOD);
+}
+
+// ============================================================================
+// Timing History
+// ============================================================================
+
+static void history_add(hand_t hand, uint16_t time, bool pressed) {
+    hand_history_t *h = &history[hand];
+
+    h->events[h->head] = (key_stamp_t){.time = time, .pressed = pressed};
+    h->head            = (h->head + 1) & (BILATERAL_HISTORY - 1);
+    if (h->count < BILATERAL_HISTORY) {
+        h->count++;
     }
 }
 
-// Process bilateral combinations logic
-bool process_bilateral_combinations(uint16_t keycode, keyrecord_t *record) {
-    // Only process home row mods
-    if (!is_home_row_mod(keycode)) {
-        return true;  // Continue normal processing
+// Roll window derived from the median gap between recent presses of both hands
+static uint16_t roll_window(uint16_t now) {
+    uint16_t ages[2 * BILATERAL_HISTORY];
+    uint16_t gaps[2 * BILATERAL_HISTORY];
+    uint8_t  age_count = 0;
+    uint8_t  gap_count = 0;
+
+    for (uint8_t hand = HAND_LEFT; hand <= HAND_RIGHT; hand++) {
+        for (uint8_t i = 0; i < history[hand].count; i++) {
+            key_stamp_t *stamp = &history[hand].events[i];
+            uint16_t     age   = now - stamp->time;
+
+            if (!stamp->pressed || age > BILATERAL_PAUSE_MS) {
+                continue;
+            }
+
+            // Insertion sort, newest first
+            uint8_t j = age_count++;
+            while (j > 0 && ages[j - 1] > age) {
+                ages[j] = ages[j - 1];
+                j--;
+            }
+            ages[j] = age;
+        }
     }
 
-    bool is_left = is_left_hand_key(record);
+    for (uint8_t i = 1; i < age_count; i++) {
+        uint16_t gap = ages[i] - ages[i - 1];
 
-    if (record->event.pressed) {
-        // Key pressed - track which hand's mods are down
-        if (is_left) {
-            left_mods_down++;
-        } else {
-            right_mods_down++;
+        uint8_t j = gap_count++;
+        while (j > 0 && gaps[j - 1] > gap) {
+            gaps[j] = gaps[j - 1];
+            j--;
         }
+        gaps[j] = gap;
+    }
 
-        // If both hands have mods pressed simultaneously, this is likely intentional
-        // (e.g., left Ctrl + right Shift for a cross-hand shortcut)
-        // Allow it to proceed normally
-        if (left_mods_down > 0 && right_mods_down > 0) {
-            return true;
+    // Not enough rhythm yet: be conservative
+    if (gap_count < 2) {
+        return BILATERAL_ROLL_MAX_MS;
+    }
+
+    uint16_t window = gaps[gap_count / 2] / 2;
+    if (window < BILATERAL_ROLL_MIN_MS) {
+        return BILATERAL_ROLL_MIN_MS;
+    }
+    if (window > BILATERAL_ROLL_MAX_MS) {
+        return BILATERAL_ROLL_MAX_MS;
+    }
+    return window;
+}
+
+// ============================================================================
+// Early Hold/Tap Decisions
+// ============================================================================
+
+static pending_mod_t *find_pending(keypos_t key) {
+    for (uint8_t i = 0; i < BILATERAL_PENDING; i++) {
+        if (pending[i].active && pending[i].key.row == key.row && pending[i].key.col == key.col) {
+            return &pending[i];
+        }
+    }
+    return NULL;
+}
+
+// Another key went down: settle every home row mod still waiting on one
+static void decide_pending(hand_t hand, uint16_t now) {
+    uint16_t window = 0;
+
+    for (uint8_t i = 0; i < BILATERAL_PENDING; i++) {
+        pending_mod_t *mod = &pending[i];
+
+        if (!mod->active || mod->decision != DECISION_NONE) {
+            continue;
+        }
+        if (hand == mod->hand) {
+            mod->decision = DECISION_TAP;
+            continue;
+        }
+        if (!window) {
+            window = roll_window(now);
+        }
+        if ((uint16_t)(now - mod->time) >= window) {
+            mod->decision = DECISION_HOLD;
         }
+    }
+}
 
-        // If this is a same-hand combination (e.g., S+T both on left hand)
-        // and they're pressed very close together, treat it as accidental
-        if (is_left && left_mods_down > 1) {
-            // Check if another mod from the same hand is already held
-            // If so, this might be accidental - prevent mod activation
-            // by treating it as a tap instead
-            return false;  // Block the mod, treat as tap
+static void track_pending(keypos_t key, uint16_t time, hand_t hand) {
+    for (uint8_t i = 0; i < BILATERAL_PENDING; i++) {
+        if (!pending[i].active) {
+            pending[i] = (pending_mod_t){.key = key, .time = time, .hand = hand, .active = true};
+            return;
         }
+    }
+    // Out of slots: this mod is left to QMK's own hold/tap logic
+}
+
+// ============================================================================
+// Typing Flow
+// ============================================================================
+
+#    ifdef BILATERAL_FLOW_MS
+static bool is_letter(uint16_t keycode) {
+    if (IS_QK_MOD_TAP(keycode)) {
+        keycode = QK_MOD_TAP_GET_TAP_KEYCODE(keycode);
+    }
+    return keycode >= KC_A && keycode <= KC_Z;
+}
+
+static void flow_track(uint16_t keycode, keyrecord_t *record) {
+    keypos_t     key  = record->event.key;
+    matrix_row_t mask = (matrix_row_t)1 << key.col;
+
+    if (!record->event.pressed) {
+        tap_hold_keys[key.row] &= ~mask;
+    } else if (IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode)) {
+        tap_hold_keys[key.row] |= mask;
+    }
+}
 
-        if (!is_left && right_mods_down > 1) {
-            return false;  // Block the mod, treat as tap
+// Any tap-hold key down besides this one that was not sent as a tap
+static bool other_tap_hold_down(keypos_t key) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        matrix_row_t keys = tap_hold_keys[row] & ~flow_keys[row];
+
+        if (row == key.row) {
+            keys &= ~((matrix_row_t)1 << key.col);
         }
+        if (keys) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Note a press; true if it is a home row mod to be sent as a tap
+static bool flow_press(uint16_t keycode, keypos_t key, hand_t hand, uint16_t now) {
+    matrix_row_t mask   = (matrix_row_t)1 << key.col;
+    bool         streak = letter_seen[hand] && (uint16_t)(now - last_letter[hand]) < BILATERAL_FLOW_MS;
+
+    if (is_letter(keycode)) {
+        last_letter[hand] = now;
+        letter_seen[hand] = true;
+    }
+
+    flow_keys[key.row] &= ~mask;
+    if (!streak || !is_home_row_mod(keycode, key) || other_tap_hold_down(key)) {
+        return false;
+    }
+    flow_keys[key.row] |= mask;
+    return true;
+}
+
+bool pre_process_record_flow(uint16_t keycode, keyrecord_t *record) {
+    keypos_t     key  = record->event.key;
+    matrix_row_t mask = (matrix_row_t)1 << key.col;
+
+    if (record->event.type != KEY_EVENT || !(flow_keys[key.row] & mask)) {
+        return true;
+    }
+    if (!record->event.pressed) {
+        flow_keys[key.row] &= ~mask;
+    }
+
+    // Already a tap: skip the hold/tap logic and process it as one
+    record->tap.count       = 1;
+    record->tap.interrupted = false;
+    process_record(record);
+    return false;
+}
+#    endif
+
+bool pre_process_record_bilateral(uint16_t keycode, keyrecord_t *record) {
+    keypos_t key = record->event.key;
+    uint16_t now = record->event.time;
+
+    // Fired Vial combos come through here too, with no matrix position
+    if (record->event.type != KEY_EVENT) {
+        return true;
+    }
+    hand_t hand = key_hand(key);
+#    ifdef BILATERAL_FLOW_MS
+    flow_track(keycode, record);
+#    endif
+    if (hand == HAND_THUMB) {
+        return true;
+    }
 
+    if (record->event.pressed) {
+        decide_pending(hand, now);
+        bool undecided = is_home_row_mod(keycode, key);
+#    ifdef BILATERAL_FLOW_MS
+        // Mid-streak home row mods are taps already
+        if (flow_press(keycode, key, hand, now)) {
+            undecided = false;
+        }
+#    endif
+        if (undecided) {
+            track_pending(key, now, hand);
+        }
     } else {
-        // Key released - update tracking
-        if (is_left) {
-            left_mods_down = (left_mods_down > 0) ? left_mods_down - 1 : 0;
-        } else {
-            right_mods_down = (right_mods_down > 0) ? right_mods_down - 1 : 0;
+        pending_mod_t *mod = find_pending(key);
+        if (mod) {
+            mod->active = false;
+        }
+    }
+    history_add(hand, now, record->event.pressed);
+    return true;
+}
+
+// Called by QMK when another key is pressed while this mod-tap is undecided
+bool get_hold_on_other_key_press(uint16_t keycode, keyrecord_t *record) {
+    pending_mod_t *mod = find_pending(record->event.key);
+
+    return mod && mod->decision != DECISION_NONE;
+}
+
+// ============================================================================
+// Same-Hand Mod Suppression
+// ============================================================================
+
+// Process bilateral combinations logic
+bool process_bilateral_combinations(uint16_t keycode, keyrecord_t *record) {
+    keypos_t     key  = record->event.key;
+    matrix_row_t mask = (matrix_row_t)1 << key.col;
+
+    // Release of a hold we turned into a tap
+    if (!record->event.pressed && (tapped_instead[key.row] & mask)) {
+        tapped_instead[key.row] &= ~mask;
+        unregister_code(QK_MOD_TAP_GET_TAP_KEYCODE(keycode));
+        return false;
+    }
+
+    // Only process home row mods
+    if (!is_home_row_mod(keycode, key)) {
+        return true;  // Continue normal processing
+    }
+
+    // Taps go through untouched
+    if (record->tap.count > 0) {
+        return true;
+    }
+
+    hand_t hand = key_hand(key);
+
+    if (record->event.pressed) {
+        pending_mod_t *mod = find_pending(key);
+
+        // QMK settled this as a hold. Type the letter instead when a
+        // same-hand key forced the decision, or when a mod from the same
+        // hand is already held (S held + T must not become Ctrl+Shift).
+        if ((mod && mod->decision == DECISION_TAP) || mods_held[hand] > 0) {
+            tapped_instead[key.row] |= mask;
+            register_code(QK_MOD_TAP_GET_TAP_KEYCODE(keycode));
+            return false;
         }
+        mods_held[hand]++;
+    } else if (mods_held[hand] > 0) {
+        mods_held[hand]--;
     }
 
     return true;  // Continue normal processing
@@ -11,6 +11,18 @@
 // Per-key tapping term function
 uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record);
 
+// Early hold/tap decision per home row mod (HOLD_ON_OTHER_KEY_PRESS_PER_KEY)
+bool get_hold_on_other_key_press(uint16_t keycode, keyrecord_t *record);
+
+// Track key timing; call from pre_process_record_user
+bool pre_process_record_bilateral(uint16_t keycode, keyrecord_t *record);
+
+#    ifdef BILATERAL_FLOW_MS
+// Send mid-streak home row mods as taps; call from pre_process_record_user
+// after anything that holds presses back, and for the presses it replays
+bool pre_process_record_flow(uint16_t keycode, keyrecord_t *record);
+#    endif
+
 // Process bilateral combinations
 bool process_record_bilateral(uint16_t keycode, keyrecord_t *record);
 
@@ -0,0 +1,230 @@
+/* Copyright 2024
+ * Indexed Combo Engine
+ *
+ * Replaces QMK's combo feature, which holds back every key press for up
+ * to COMBO_TERM and scans every combo on each event.
+ *
+ *   - combos.def is expanded at compile time into a per-key bitmask of the
+ *     combos that contain the key, so each event costs one table lookup
+ *     and a mask AND.
+ *   - A key that is in no combo goes straight through, so ordinary letters
+ *     are never delayed.
+ *   - A key that could start a combo is held back only until the next
+ *     event tells it apart: another key of a candidate combo narrows the
+ *     candidates, and a combo fires the moment it is complete and no
+ *     larger candidate remains. Anything else (a key outside the
+ *     candidates, a release, COMBO_ENGINE_TERM) fires a complete combo or
+ *     replays the held keys into the hold/tap logic with their original
+ *     timestamps.
+ *
+ * It runs in pre_process_record_user, before action_tapping, so home row
+ * mod keys can be combo members; replayed keys skip that hook, apart from
+ * the bilateral engine's typing flow, but still reach QMK's combo feature
+ * (Vial's combos) as they would have without the engine.
+ */
+
+#include QMK_KEYBOARD_H
+#include "combo_engine.h"
+#include "bilateral_combinations.h"
+
+#ifdef COMBO_ENGINE_ENABLE
+
+#    define COMBO_MAX_KEYS 3
+
+// ============================================================================
+// Compile-Time Index
+// ============================================================================
+
+#    include "combos.def"
+
+#    define COMBO_ENUM(arg, name, keycode, k1, k2, k3) name,
+#    define COMBO_RESULT(arg, name, keycode, k1, k2, k3) [name] = keycode,
+#    define COMBO_SIZE(arg, name, keycode, k1, k2, k3) [name] = 2 + ((k3) != COMBO_KEY_NONE),
+#    define COMBO_BIT(key, name, keycode, k1, k2, k3) | ((k1) == (key) || (k2) == (key) || (k3) == (key) ? (combo_mask_t)1 << name : 0)
+
+enum combo_ids { COMBO_LIST(COMBO_ENUM, 0) COMBO_COUNT };
+
+typedef uint16_t combo_mask_t;
+
+_Static_assert(COMBO_COUNT <= 16, "combo_mask_t holds 16 combos");
+_Static_assert(MATRIX_ROWS == 8 && MATRIX_COLS == 7, "combo index is laid out for the Corne matrix");
+
+static const uint16_t combo_results[COMBO_COUNT] = {COMBO_LIST(COMBO_RESULT, 0)};
+static const uint8_t  combo_sizes[COMBO_COUNT]   = {COMBO_LIST(COMBO_SIZE, 0)};
+
+// Combos each key belongs to
+#    define INDEX_KEY(row, col) (0 COMBO_LIST(COMBO_BIT, COMBO_KEY(row, col)))
+#    define INDEX_ROW(row) \
+        { INDEX_KEY(row, 0), INDEX_KEY(row, 1), INDEX_KEY(row, 2), INDEX_KEY(row, 3), INDEX_KEY(row, 4), INDEX_KEY(row, 5), INDEX_KEY(row, 6) }
+
+static const combo_mask_t combo_index[MATRIX_ROWS][MATRIX_COLS] = {
+    INDEX_ROW(0), INDEX_ROW(1), INDEX_ROW(2), INDEX_ROW(3), INDEX_ROW(4), INDEX_ROW(5), INDEX_ROW(6), INDEX_ROW(7),
+};
+
+// ============================================================================
+// State
+// ============================================================================
+
+// Presses held back while a combo is possible
+static keyrecord_t  held[COMBO_MAX_KEYS];
+static uint8_t      held_count;
+static combo_mask_t candidates;
+
+// Keys of the fired combo; their releases are swallowed
+static matrix_row_t fired_keys[MATRIX_ROWS];
+static uint16_t     fired_keycode;
+
+static bool is_held(keypos_t key) {
+    for (uint8_t i = 0; i < held_count; i++) {
+        if (held[i].event.key.row == key.row && held[i].event.key.col == key.col) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A candidate containing exactly the held keys, or COMBO_COUNT
+static uint8_t complete_combo(void) {
+    for (uint8_t i = 0; i < COMBO_COUNT; i++) {
+        if ((candidates & ((combo_mask_t)1 << i)) && combo_sizes[i] == held_count) {
+            return i;
+        }
+    }
+    return COMBO_COUNT;
+}
+
+// True if some candidate still needs more keys
+static bool can_grow(void) {
+    for (uint8_t i = 0; i < COMBO_COUNT; i++) {
+        if ((candidates & ((combo_mask_t)1 << i)) && combo_sizes[i] > held_count) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Fire / Replay
+// ============================================================================
+
+static void release_fired(void) {
+    if (fired_keycode) {
+        unregister_code16(fired_keycode);
+        fired_keycode = 0;
+    }
+}
+
+static void fire(uint8_t combo) {
+    release_fired();
+    for (uint8_t i = 0; i < held_count; i++) {
+        fired_keys[held[i].event.key.row] |= (matrix_row_t)1 << held[i].event.key.col;
+    }
+    held_count = 0;
+    candidates = 0;
+
+    fired_keycode = combo_results[combo];
+    register_code16(fired_keycode);
+}
+
+// Hand the held presses to the hold/tap logic, oldest first
+static void replay(void) {
+    keyrecord_t records[COMBO_MAX_KEYS];
+    uint8_t     count = held_count;
+
+    memcpy(records, held, sizeof(records));
+    held_count = 0;
+    candidates = 0;
+    for (uint8_t i = 0; i < count; i++) {
+#    if defined(BILATERAL_COMBINATIONS) && defined(BILATERAL_FLOW_MS)
+        // Mid-streak home row mods still skip the hold/tap logic
+        if (!pre_process_record_flow(get_record_keycode(&records[i], false), &records[i])) {
+            continue;
+        }
+#    endif
+#    ifdef COMBO_ENABLE
+        // The rest of pre_process_record_quantum
+        if (!process_combo(get_record_keycode(&records[i], false), &records[i])) {
+            continue;
+        }
+#    endif
+        action_tapping_process(records[i]);
+    }
+}
+
+// The combo cannot grow any further: fire what is complete, replay the rest
+static void settle(void) {
+    uint8_t combo = complete_combo();
+
+    if (combo < COMBO_COUNT) {
+        fire(combo);
+    } else {
+        replay();
+    }
+}
+
+static void hold_back(keyrecord_t *record, combo_mask_t mask) {
+    if (!held_count) {
+        candidates = mask;
+    }
+    held[held_count++] = *record;
+
+    if (!can_grow() && complete_combo() < COMBO_COUNT) {
+        settle();
+    }
+}
+
+// ============================================================================
+// Hooks
+// ============================================================================
+
+bool pre_process_record_combo(uint16_t keycode, keyrecord_t *record) {
+    keypos_t     key  = record->event.key;
+    matrix_row_t mask = (matrix_row_t)1 << key.col;
+
+    if (record->event.type != KEY_EVENT) {
+        return true;
+    }
+
+    if (!record->event.pressed) {
+        if (held_count && is_held(key)) {
+            settle();
+        }
+        if (fired_keys[key.row] & mask) {
+            fired_keys[key.row] &= ~mask;
+            release_fired();
+            return false;
+        }
+        // Releases of keys pressed before the held ones pass right away
+        return true;
+    }
+
+    combo_mask_t combos = get_highest_layer(layer_state) == COMBO_ENGINE_LAYER ? combo_index[key.row][key.col] : 0;
+
+    if (held_count) {
+        if (held_count < COMBO_MAX_KEYS && (candidates & combos)) {
+            candidates &= combos;
+            hold_back(record, combos);
+            return false;
+        }
+        settle();
+    }
+
+    // In no combo: no delay at all
+    if (!combos) {
+        return true;
+    }
+    hold_back(record, combos);
+    return false;
+}
+
+bool combo_engine_busy(void) {
+    return held_count > 0;
+}
+
+void combo_engine_task(void) {
+    if (held_count && timer_elapsed(held[0].event.time) >= COMBO_ENGINE_TERM) {
+        settle();
+    }
+}
+
+#endif // COMBO_ENGINE_ENABLE
@@ -0,0 +1,34 @@
+/* Copyright 2024
+ * Indexed Combo Engine - Header
+ */
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifdef COMBO_ENGINE_ENABLE
+
+// Time the keys of a combo may be pressed apart
+#    ifndef COMBO_ENGINE_TERM
+#        define COMBO_ENGINE_TERM 30
+#    endif
+
+// Combos only fire while this is the highest active layer
+#    ifndef COMBO_ENGINE_LAYER
+#        define COMBO_ENGINE_LAYER 0
+#    endif
+
+// Matrix position as used in combos.def
+#    define COMBO_KEY(row, col) (((row) << 3) | (col))
+#    define COMBO_KEY_NONE 0xFF
+
+// Hold back possible combo keys; call from pre_process_record_user
+bool pre_process_record_combo(uint16_t keycode, keyrecord_t *record);
+
+// Settle combos whose term ran out; call from housekeeping_task_user
+void combo_engine_task(void);
+
+// True while presses are held back waiting for the rest of a combo
+bool combo_engine_busy(void);
+
+#endif // COMBO_ENGINE_ENABLE
@@ -0,0 +1,134 @@
+/* Copyright 2024
+ * Eager Press / Deferred Release Debounce
+ *
+ * QMK's default debounce (sym_defer_g) passes a matrix change on only
+ * after the whole matrix has been quiet for DEBOUNCE ms, so every key
+ * press reaches the keymap DEBOUNCE ms late, and later still while other
+ * keys are bouncing.
+ *
+ * Here a press is reported on the first closed contact, per key. Bounce
+ * after the press can't end it: a key is released only once its contact
+ * has stayed open for DEBOUNCE ms, and any closed reading meanwhile
+ * restarts the wait. Release bounce is over by the time the release is
+ * reported, so it can't turn into a second press.
+ *
+ * The per-key release countdowns are bit-sliced: bit plane i of a row
+ * holds bit i of every column's counter, so one scan updates a whole row
+ * with a handful of word operations and the state stays a few bytes per
+ * row. Selected with DEBOUNCE_TYPE = custom in rules.mk.
+ */
+
+#include QMK_KEYBOARD_H
+#include "debounce.h"
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+_Static_assert(DEBOUNCE <= 255, "DEBOUNCE must fit in 8 bits");
+
+// Bit planes needed to count down from DEBOUNCE
+#if DEBOUNCE < 2
+#    define DEBOUNCE_PLANES 1
+#elif DEBOUNCE < 4
+#    define DEBOUNCE_PLANES 2
+#elif DEBOUNCE < 8
+#    define DEBOUNCE_PLANES 3
+#elif DEBOUNCE < 16
+#    define DEBOUNCE_PLANES 4
+#elif DEBOUNCE < 32
+#    define DEBOUNCE_PLANES 5
+#elif DEBOUNCE < 64
+#    define DEBOUNCE_PLANES 6
+#elif DEBOUNCE < 128
+#    define DEBOUNCE_PLANES 7
+#else
+#    define DEBOUNCE_PLANES 8
+#endif
+
+static matrix_row_t releasing[MATRIX_ROWS];                // Open while reported pressed
+static matrix_row_t countdown[DEBOUNCE_PLANES][MATRIX_ROWS];  // ms left, bit-sliced
+static uint16_t     last_tick;
+static bool         counting = false;  // Any bit set in releasing
+
+void debounce_init(uint8_t num_rows) {
+    memset(releasing, 0, sizeof(releasing));
+    memset(countdown, 0, sizeof(countdown));
+    last_tick = timer_read();
+    counting  = false;
+}
+
+void debounce_free(void) {}
+
+// Start the release wait for the keys in mask
+static void countdown_load(uint8_t row, matrix_row_t mask) {
+    for (uint8_t plane = 0; plane < DEBOUNCE_PLANES; plane++) {
+        if ((DEBOUNCE >> plane) & 1) {
+            countdown[plane][row] |= mask;
+        } else {
+            countdown[plane][row] &= ~mask;
+        }
+    }
+}
+
+// Subtract one from the counters in mask and return the ones now at zero
+static matrix_row_t countdown_tick(uint8_t row, matrix_row_t mask) {
+    matrix_row_t borrow = mask;
+    matrix_row_t left   = 0;
+
+    for (uint8_t plane = 0; plane < DEBOUNCE_PLANES; plane++) {
+        matrix_row_t bits     = countdown[plane][row];
+        countdown[plane][row] = bits ^ borrow;
+        borrow &= ~bits;
+        left |= countdown[plane][row];
+    }
+    return mask & ~left;
+}
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    bool cooked_changed = false;
+
+    // Whole milliseconds since the last call; several scans share one
+    uint16_t now     = timer_read();
+    uint16_t elapsed = now - last_tick;
+    last_tick        = now;
+
+    if (!changed && !counting) {
+        return false;
+    }
+    if (elapsed > DEBOUNCE) {
+        elapsed = DEBOUNCE;
+    }
+
+    counting = false;
+    for (uint8_t row = 0; row < num_rows; row++) {
+        matrix_row_t pressed = raw[row] & ~cooked[row];
+        matrix_row_t opened  = cooked[row] & ~raw[row];
+
+        // Presses go out on the first edge
+        if (pressed) {
+            cooked[row] |= pressed;
+            cooked_changed = true;
+        }
+
+        // Closed again: forget the release
+        releasing[row] &= opened;
+        matrix_row_t fresh = opened & ~releasing[row];
+
+        // Keys that were already waiting count down the time since the last call
+        for (uint16_t ms = 0; ms < elapsed && releasing[row]; ms++) {
+            matrix_row_t done = countdown_tick(row, releasing[row]);
+            if (done) {
+                releasing[row] &= ~done;
+                cooked[row] &= ~done;
+                cooked_changed = true;
+            }
+        }
+
+        // Newly open: start waiting
+        countdown_load(row, fresh);
+        releasing[row] |= fresh;
+        counting |= releasing[row] != 0;
+    }
+    return cooked_changed;
+}
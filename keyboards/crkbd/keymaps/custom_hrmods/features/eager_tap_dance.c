@@ -0,0 +1,57 @@
+/* Copyright 2024
+ * Eager Tap Dance
+ *
+ * ACTION_TAP_DANCE_DOUBLE only knows what a tap meant once the dance is
+ * over, so a single-tapped Esc leaves the keyboard a full tapping term
+ * late (or when the next key interrupts the dance).
+ *
+ * The eager variant sends the single-tap keycode on the first press and
+ * releases it with the key, exactly like a plain key. When a second tap
+ * follows within the tapping term, the early keycode is optionally taken
+ * back with an undo keycode, and the double-tap keycode is held for as
+ * long as the key is.
+ *
+ * Use it per dance, where sending the single tap early is harmless (Esc
+ * before Ctrl/GUI). Dances whose single tap cannot be taken back (Del,
+ * screenshots) stay on ACTION_TAP_DANCE_DOUBLE.
+ */
+
+#include QMK_KEYBOARD_H
+#include "eager_tap_dance.h"
+
+#ifdef TAP_DANCE_ENABLE
+
+void tap_dance_eager_on_each_tap(tap_dance_state_t *state, void *user_data) {
+    tap_dance_eager_t *dance = (tap_dance_eager_t *)user_data;
+
+    if (state->count == 1) {
+        register_code16(dance->kc1);
+        return;
+    }
+    if (state->count == 2) {
+        if (dance->undo != KC_NO) {
+            tap_code16(dance->undo);
+        }
+        register_code16(dance->kc2);
+    }
+    // Nothing is left to decide; reset runs on release
+    state->finished = true;
+}
+
+void tap_dance_eager_on_each_release(tap_dance_state_t *state, void *user_data) {
+    tap_dance_eager_t *dance = (tap_dance_eager_t *)user_data;
+
+    if (state->count == 1) {
+        unregister_code16(dance->kc1);
+    }
+}
+
+void tap_dance_eager_reset(tap_dance_state_t *state, void *user_data) {
+    tap_dance_eager_t *dance = (tap_dance_eager_t *)user_data;
+
+    if (state->count >= 2) {
+        unregister_code16(dance->kc2);
+    }
+}
+
+#endif // TAP_DANCE_ENABLE
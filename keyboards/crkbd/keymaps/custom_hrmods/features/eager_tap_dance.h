@@ -0,0 +1,26 @@
+/* Copyright 2024
+ * Eager Tap Dance - Header
+ */
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifdef TAP_DANCE_ENABLE
+
+typedef struct {
+    uint16_t kc1;   // Sent on the first press
+    uint16_t kc2;   // Double tap (held while the key is)
+    uint16_t undo;  // Tapped before kc2 to take back kc1, or KC_NO to keep it
+} tap_dance_eager_t;
+
+void tap_dance_eager_on_each_tap(tap_dance_state_t *state, void *user_data);
+void tap_dance_eager_on_each_release(tap_dance_state_t *state, void *user_data);
+void tap_dance_eager_reset(tap_dance_state_t *state, void *user_data);
+
+// Like ACTION_TAP_DANCE_DOUBLE, but kc1 goes out on the first press instead
+// of when the dance ends. Only for keys that are harmless to send early.
+#    define ACTION_TAP_DANCE_EAGER(kc1, kc2, undo) \
+        { .fn = {tap_dance_eager_on_each_tap, NULL, tap_dance_eager_reset, tap_dance_eager_on_each_release}, .user_data = (void *)&((tap_dance_eager_t){kc1, kc2, undo}), }
+
+#endif // TAP_DANCE_ENABLE
@@ -0,0 +1,76 @@
+/* Copyright 2024
+ * Split Indicator Sync
+ *
+ * Both halves used to run the RGB layer indicators from their own copy of
+ * the layer state and keymap: the slave recomputed the highest layer and
+ * the active key mask every scan, from a keymap that Vial never writes on
+ * the slave (dynamic keymap changes only reach the master's EEPROM).
+ *
+ * Now the master sends the result instead: the highest layer and the
+ * active key LED mask in one 9 byte split RPC, only when it changed (plus
+ * a slow refresh so a restarted slave catches up). The slave stores the
+ * last packet and draws from it.
+ */
+
+#include QMK_KEYBOARD_H
+#include "indicator_sync.h"
+#include "active_key_cache.h"
+#include "power_mode.h"
+
+#if defined(INDICATOR_SYNC_ENABLE) && defined(RGB_MATRIX_ENABLE)
+
+#    include "transactions.h"
+
+static indicator_state_t local;     // Computed on this half
+static indicator_state_t received;  // Last packet from the master (slave)
+static bool              synced = false;
+
+static indicator_state_t sent;  // Last state the slave acknowledged (master)
+static bool              sent_valid = false;
+static uint16_t          sent_time  = 0;
+
+static void indicator_sync_slave_handler(uint8_t in_len, const void *in_data, uint8_t out_len, void *out_data) {
+    if (in_len != sizeof(received)) {
+        return;  // Other firmware build on the master, keep drawing locally
+    }
+#    ifdef POWER_MODE_ENABLE
+    // A sleeping slave must redraw changes (the periodic refresh is no change)
+    if (!synced || memcmp(&received, in_data, sizeof(received)) != 0) {
+        power_mode_wake();
+    }
+#    endif
+    memcpy(&received, in_data, sizeof(received));
+    synced = true;
+}
+
+void indicator_sync_init(void) {
+    transaction_register_rpc(RPC_ID_USER_INDICATORS, indicator_sync_slave_handler);
+}
+
+const indicator_state_t *indicator_sync_state(void) {
+    if (!is_keyboard_master() && synced) {
+        return &received;
+    }
+    local.layer  = get_highest_layer(layer_state);
+    local.active = active_key_cache_layer(local.layer);
+    return &local;
+}
+
+void indicator_sync_task(void) {
+    if (!is_keyboard_master()) {
+        return;
+    }
+
+    const indicator_state_t *state = indicator_sync_state();
+    if (sent_valid && memcmp(state, &sent, sizeof(sent)) == 0 && timer_elapsed(sent_time) < INDICATOR_SYNC_REFRESH_MS) {
+        return;
+    }
+    // A failed transfer leaves the state unsent, so the next scan retries
+    if (transaction_rpc_send(RPC_ID_USER_INDICATORS, sizeof(*state), state)) {
+        sent       = *state;
+        sent_valid = true;
+        sent_time  = timer_read();
+    }
+}
+
+#endif // INDICATOR_SYNC_ENABLE && RGB_MATRIX_ENABLE
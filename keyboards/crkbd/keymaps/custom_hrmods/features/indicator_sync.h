@@ -0,0 +1,32 @@
+/* Copyright 2024
+ * Split Indicator Sync - Header
+ */
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#if defined(INDICATOR_SYNC_ENABLE) && defined(RGB_MATRIX_ENABLE)
+
+// Resend an unchanged state this often, so a half that restarted catches up
+#    ifndef INDICATOR_SYNC_REFRESH_MS
+#        define INDICATOR_SYNC_REFRESH_MS 500
+#    endif
+
+// What the RGB layer indicators need, as sent over the split link (9 bytes)
+typedef struct __attribute__((packed)) {
+    uint8_t  layer;   // Highest active layer
+    uint64_t active;  // active_key_cache_layer(layer) on the master
+} indicator_state_t;
+
+// Register the slave side RPC handler; call from keyboard_post_init_user
+void indicator_sync_init(void);
+
+// Send the state to the slave when it changed; call from housekeeping_task_user
+void indicator_sync_task(void);
+
+// Indicator state for this half: computed on the master, received on the
+// slave (computed locally until the first packet arrives)
+const indicator_state_t *indicator_sync_state(void);
+
+#endif // INDICATOR_SYNC_ENABLE && RGB_MATRIX_ENABLE
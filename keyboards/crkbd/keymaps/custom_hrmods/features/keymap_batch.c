@@ -0,0 +1,200 @@
+/* Copyright 2024
+ * Batched Keymap Writes
+ *
+ * Vial uploads a layout one key at a time: a raw HID round trip and two
+ * eeprom_update_byte() calls per key, and every key acts as soon as it
+ * lands, so the keymap is half old, half new while a .vil loads. On the
+ * RP2040 the EEPROM is emulated on flash by QMK's wear leveling: each
+ * changed byte appends its own entry to the write log, and a full log
+ * costs a sector erase and a rewrite of the whole image.
+ *
+ * The batch command takes up to 13 keys per raw HID packet and only
+ * stages them in RAM. On commit, explicit or after KEYMAP_BATCH_IDLE_MS of
+ * quiet, each layer with changes gets a single dynamic_keymap_set_buffer()
+ * over the span from its first to its last changed key, and the active key
+ * cache is invalidated once. Staged keys do not take effect before the
+ * commit. QMK keeps the keymap's EEPROM address to its nvm backend, so the
+ * buffer call is as close to one block write as the public API gets: it
+ * still updates byte by byte, but bytes that did not change cost nothing.
+ * scripts/hrmods-hid.py "keymap load" uploads .vil files this way.
+ *
+ * Leave KEYMAP_BATCH_ENABLE undefined to compile it out.
+ */
+
+#include QMK_KEYBOARD_H
+#include "keymap_batch.h"
+#include "active_key_cache.h"
+
+#ifdef KEYMAP_BATCH_ENABLE
+
+#    include "dynamic_keymap.h"
+#    include "raw_hid.h"
+#    include "via.h"
+
+#    define BATCH_KEYS (MATRIX_ROWS * MATRIX_COLS)
+#    define STAGE_HEADER 5
+
+_Static_assert(BATCH_KEYS <= 64, "staged keys are tracked in a 64 bit mask per layer");
+_Static_assert(BATCH_KEYS <= UINT8_MAX, "stage requests address keys with one byte");
+
+enum keymap_batch_op {
+    BATCH_OP_INFO    = 0x00,
+    BATCH_OP_STAGE   = 0x01,
+    BATCH_OP_COMMIT  = 0x02,
+    BATCH_OP_DISCARD = 0x03,
+};
+
+static uint16_t staged[DYNAMIC_KEYMAP_LAYER_COUNT][BATCH_KEYS];
+static uint64_t dirty[DYNAMIC_KEYMAP_LAYER_COUNT];  // Keys with a staged keycode
+static bool     pending;
+static uint32_t last_command;
+
+// ============================================================================
+// Commit
+// ============================================================================
+
+static uint16_t stored_keycode(uint8_t layer, uint8_t key) {
+    return dynamic_keymap_get_keycode(layer, key / MATRIX_COLS, key % MATRIX_COLS);
+}
+
+// Write a layer's changed keys with one buffer update; returns how many changed
+static uint8_t commit_layer(uint8_t layer) {
+    uint8_t first   = BATCH_KEYS;
+    uint8_t last    = 0;
+    uint8_t changed = 0;
+
+    for (uint8_t key = 0; key < BATCH_KEYS; key++) {
+        if ((dirty[layer] >> key & 1) && staged[layer][key] != stored_keycode(layer, key)) {
+            if (first == BATCH_KEYS) {
+                first = key;
+            }
+            last = key;
+            changed++;
+        }
+    }
+    if (!changed) {
+        return 0;
+    }
+
+    // The dynamic keymap stores big-endian keycodes, row after row, so the
+    // span is contiguous; unchanged keys inside it keep their stored value
+    uint8_t buffer[BATCH_KEYS * 2];
+    uint8_t length = 0;
+
+    for (uint8_t key = first; key <= last; key++) {
+        uint16_t keycode = (dirty[layer] >> key & 1) ? staged[layer][key] : stored_keycode(layer, key);
+
+        buffer[length++] = keycode >> 8;
+        buffer[length++] = keycode & 0xFF;
+    }
+    dynamic_keymap_set_buffer((layer * BATCH_KEYS + first) * 2, length, buffer);
+    return changed;
+}
+
+static uint16_t commit(void) {
+    uint16_t changed = 0;
+
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        if (dirty[layer]) {
+            changed += commit_layer(layer);
+            dirty[layer] = 0;
+        }
+    }
+    pending = false;
+#    ifdef RGB_MATRIX_ENABLE
+    if (changed) {
+        active_key_cache_invalidate();
+    }
+#    endif
+    return changed;
+}
+
+static void discard(void) {
+    memset(dirty, 0, sizeof(dirty));
+    pending = false;
+}
+
+void keymap_batch_task(void) {
+    if (pending && timer_elapsed32(last_command) >= KEYMAP_BATCH_IDLE_MS) {
+        commit();
+    }
+}
+
+// ============================================================================
+// Raw HID
+// ============================================================================
+
+static void put_u16(uint8_t *out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static bool stage(const uint8_t *data, uint8_t length) {
+    uint8_t layer = data[2];
+    uint8_t first = data[3];
+    uint8_t count = data[4];
+
+    if (layer >= DYNAMIC_KEYMAP_LAYER_COUNT || STAGE_HEADER + count * 2 > length || first + count > BATCH_KEYS) {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t *keycode = &data[STAGE_HEADER + i * 2];
+
+        staged[layer][first + i] = keycode[0] | keycode[1] << 8;
+        dirty[layer] |= 1ULL << (first + i);
+    }
+    return true;
+}
+
+bool keymap_batch_via_command(uint8_t *data, uint8_t length) {
+    if (data[0] != KEYMAP_BATCH_COMMAND_ID) {
+        // Anything else touching the keymap sees the staged keys in place
+        if (pending) {
+            switch (data[0]) {
+                case id_dynamic_keymap_get_keycode:
+                case id_dynamic_keymap_set_keycode:
+                case id_dynamic_keymap_get_buffer:
+                case id_dynamic_keymap_set_buffer:
+                    commit();
+                    break;
+                case id_dynamic_keymap_reset:
+                case id_eeprom_reset:
+                    discard();
+                    break;
+            }
+        }
+        return false;
+    }
+
+    last_command = timer_read32();
+    switch (data[1]) {
+        case BATCH_OP_INFO:
+            data[2] = KEYMAP_BATCH_VERSION;
+            data[3] = DYNAMIC_KEYMAP_LAYER_COUNT;
+            data[4] = MATRIX_ROWS;
+            data[5] = MATRIX_COLS;
+            data[6] = (length - STAGE_HEADER) / 2;
+            break;
+        case BATCH_OP_STAGE:
+            if (stage(data, length)) {
+                pending = true;
+            } else {
+                data[0] = id_unhandled;
+            }
+            break;
+        case BATCH_OP_COMMIT:
+            put_u16(&data[2], commit());
+            break;
+        case BATCH_OP_DISCARD:
+            discard();
+            break;
+        default:
+            data[0] = id_unhandled;
+            break;
+    }
+
+    raw_hid_send(data, length);
+    return true;
+}
+
+#endif // KEYMAP_BATCH_ENABLE
@@ -0,0 +1,39 @@
+/* Copyright 2024
+ * Batched Keymap Writes - Header
+ */
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifdef KEYMAP_BATCH_ENABLE
+
+// Staged keys are committed this long after the last batch command
+#    ifndef KEYMAP_BATCH_IDLE_MS
+#        define KEYMAP_BATCH_IDLE_MS 500
+#    endif
+
+// Raw HID command, next to the trace recorder one
+//
+//   request  [0xF2, op, ...]
+//   op 0x00  info    -> [0xF2, 0x00, version, layers, rows, cols, max keys per stage]
+//   op 0x01  stage   [0xF2, 0x01, layer, first, n, n keycodes u16]
+//                    -> echoed; keys first..first+n-1, key = row * cols + col
+//   op 0x02  commit  -> [0xF2, 0x02, changed keys u16]
+//   op 0x03  discard -> [0xF2, 0x03]  drops everything staged
+//
+// Multi-byte fields are little-endian. A stage outside the keymap is
+// answered with id_unhandled and stages nothing. Staged keys stay in RAM
+// until a commit, KEYMAP_BATCH_IDLE_MS without batch commands, or any
+// other VIA keymap command, which sees them committed first (a keymap or
+// EEPROM reset drops them instead).
+#    define KEYMAP_BATCH_COMMAND_ID 0xF2
+#    define KEYMAP_BATCH_VERSION 1
+
+// Commit staged keys once the host went quiet; call from housekeeping_task_user
+void keymap_batch_task(void);
+
+// Handle the batch command. Returns true (and replies) if it was one.
+bool keymap_batch_via_command(uint8_t *data, uint8_t length);
+
+#endif // KEYMAP_BATCH_ENABLE
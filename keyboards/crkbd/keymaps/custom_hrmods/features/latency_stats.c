@@ -0,0 +1,169 @@
+/* Copyright 2024
+ * On-Device Latency Histograms
+ *
+ * Counts how long the keymap's hot paths take on the real keyboard, so
+ * tuning (tapping terms, the bilateral engine, RGB indicators) can be
+ * judged on measurements instead of guesses:
+ *
+ *   - press latency: debounced press -> keycode reaches process_record_user,
+ *     which includes any hold/tap wait (ms)
+ *   - scan interval: time between keyboard task passes (us)
+ *   - cost of process_record_user, the bilateral engine and the RGB
+ *     indicator callback (us)
+ *   - wake-up latency: end of an idle sleep -> the key that ended it
+ *     reaches pre_process_record_user (us, features/power_mode.c)
+ *
+ * Samples go into fixed log2-bucketed histograms in RAM (no allocation,
+ * one increment per sample) and are read or cleared over Vial's raw HID
+ * channel; scripts/hrmods-hid.py decodes them on the host.
+ *
+ * The RP2040 TIMER free-runs at 1 MHz, which is cheap to read and fine
+ * enough for per-callback costs. The host simulator provides its own
+ * LATENCY_STATS_CLOCK_US.
+ */
+
+#include QMK_KEYBOARD_H
+#include "latency_stats.h"
+
+#ifdef VIA_ENABLE
+#    include "raw_hid.h"
+#    include "via.h"
+#endif
+
+#ifdef LATENCY_STATS_ENABLE
+
+#    ifndef LATENCY_STATS_CLOCK_US
+#        define LATENCY_STATS_CLOCK_US() (TIMER->TIMERAWL)
+#    endif
+
+// Values per read reply: 5 header bytes + 6 x uint32 fit a 32 byte report
+#    define LATENCY_STATS_PER_READ 6
+
+enum latency_stats_op {
+    STATS_OP_INFO  = 0x00,
+    STATS_OP_READ  = 0x01,
+    STATS_OP_RESET = 0x02,
+};
+
+enum latency_stats_unit {
+    STATS_UNIT_US = 0,
+    STATS_UNIT_MS = 1,
+};
+
+static const uint8_t stat_units[STATS_COUNT] = {
+    [STATS_KEY_LATENCY]    = STATS_UNIT_MS,
+    [STATS_SCAN_INTERVAL]  = STATS_UNIT_US,
+    [STATS_PROCESS_RECORD] = STATS_UNIT_US,
+    [STATS_BILATERAL]      = STATS_UNIT_US,
+    [STATS_RGB_INDICATORS] = STATS_UNIT_US,
+    [STATS_WAKE_LATENCY]   = STATS_UNIT_US,
+};
+
+static uint32_t histograms[STATS_COUNT][LATENCY_STATS_BUCKETS];
+static uint32_t last_scan;
+static bool     scanned;
+
+// ============================================================================
+// Sampling
+// ============================================================================
+
+uint32_t latency_stats_now(void) {
+    return LATENCY_STATS_CLOCK_US();
+}
+
+// 0 -> 0, 1 -> 1, 2..3 -> 2, 4..7 -> 3, ... (no CLZ on the Cortex-M0+)
+static uint8_t bucket_for(uint32_t value) {
+    uint8_t bucket = 0;
+
+    while (value && bucket < LATENCY_STATS_BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void latency_stats_add(latency_stat_t stat, uint32_t value) {
+    uint32_t *count = &histograms[stat][bucket_for(value)];
+
+    if (*count != UINT32_MAX) {
+        (*count)++;
+    }
+}
+
+void latency_stats_scan(void) {
+    uint32_t now = latency_stats_now();
+
+    if (scanned) {
+        latency_stats_add(STATS_SCAN_INTERVAL, now - last_scan);
+    }
+    last_scan = now;
+    scanned   = true;
+}
+
+void latency_stats_record(keyrecord_t *record) {
+    if (record->event.pressed) {
+        latency_stats_add(STATS_KEY_LATENCY, timer_elapsed(record->event.time));
+    }
+}
+
+void latency_stats_reset(void) {
+    memset(histograms, 0, sizeof(histograms));
+    scanned = false;
+}
+
+// ============================================================================
+// Raw HID
+// ============================================================================
+
+#    ifdef VIA_ENABLE
+
+static void put_u32(uint8_t *out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = value >> 24;
+}
+
+bool latency_stats_via_command(uint8_t *data, uint8_t length) {
+    if (data[0] != LATENCY_STATS_COMMAND_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case STATS_OP_INFO:
+            data[2] = LATENCY_STATS_VERSION;
+            data[3] = STATS_COUNT;
+            data[4] = LATENCY_STATS_BUCKETS;
+            memcpy(&data[5], stat_units, STATS_COUNT);
+            break;
+        case STATS_OP_READ: {
+            uint8_t stat  = data[2];
+            uint8_t first = data[3];
+            uint8_t n     = 0;
+
+            if (stat >= STATS_COUNT || first >= LATENCY_STATS_BUCKETS) {
+                data[0] = id_unhandled;
+                break;
+            }
+            while (n < LATENCY_STATS_PER_READ && first + n < LATENCY_STATS_BUCKETS && 5 + 4 * (n + 1) <= length) {
+                put_u32(&data[5 + 4 * n], histograms[stat][first + n]);
+                n++;
+            }
+            data[4] = n;
+            break;
+        }
+        case STATS_OP_RESET:
+            latency_stats_reset();
+            break;
+        default:
+            data[0] = id_unhandled;
+            break;
+    }
+
+    raw_hid_send(data, length);
+    return true;
+}
+
+#    endif // VIA_ENABLE
+
+#endif // LATENCY_STATS_ENABLE
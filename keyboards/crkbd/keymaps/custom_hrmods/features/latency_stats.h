@@ -0,0 +1,71 @@
+/* Copyright 2024
+ * On-Device Latency Histograms - Header
+ */
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// Histograms kept in RAM
+typedef enum {
+    STATS_KEY_LATENCY = 0,  // Debounced press -> keycode processed (ms)
+    STATS_SCAN_INTERVAL,    // Time between keyboard task passes (us)
+    STATS_PROCESS_RECORD,   // process_record_user (us)
+    STATS_BILATERAL,        // Bilateral engine, pre_process + process (us)
+    STATS_RGB_INDICATORS,   // rgb_matrix_indicators_advanced_user (us)
+    STATS_WAKE_LATENCY,     // Idle sleep end -> waking key pre-processed (us)
+    STATS_COUNT
+} latency_stat_t;
+
+#ifdef LATENCY_STATS_ENABLE
+
+// Log2 buckets per histogram: 0, 1, 2-3, 4-7, ... and a final catch-all
+#    define LATENCY_STATS_BUCKETS 16
+
+// Raw HID command, outside the VIA and Vial ranges
+//
+//   request  [0xF0, op, ...]
+//   op 0x00  info   -> [0xF0, 0x00, version, STATS_COUNT, buckets, unit per stat (0 = us, 1 = ms)]
+//   op 0x01  read   [0xF0, 0x01, stat, first] -> [0xF0, 0x01, stat, first, n, n x uint32 LE]
+//   op 0x02  reset  -> [0xF0, 0x02]
+//
+// Unknown ops and stats answer with 0xFF in the first byte, like VIA.
+#    define LATENCY_STATS_COMMAND_ID 0xF0
+#    define LATENCY_STATS_VERSION 1
+
+// Microsecond timestamp
+uint32_t latency_stats_now(void);
+
+// Count one sample
+void latency_stats_add(latency_stat_t stat, uint32_t value);
+
+// Scan rate sample; call once per housekeeping_task_user
+void latency_stats_scan(void);
+
+// Press latency sample; call at the top of process_record_user
+void latency_stats_record(keyrecord_t *record);
+
+// Clear every histogram
+void latency_stats_reset(void);
+
+#    ifdef VIA_ENABLE
+// Handle the stats command. Returns true (and replies) if it was one.
+bool latency_stats_via_command(uint8_t *data, uint8_t length);
+#    endif
+
+// Run a statement and count how long it took
+#    define LATENCY_STATS_TIME(stat, statement)                           \
+        do {                                                              \
+            uint32_t latency_t0_ = latency_stats_now();                   \
+            statement;                                                    \
+            latency_stats_add((stat), latency_stats_now() - latency_t0_); \
+        } while (0)
+
+#else
+
+#    define LATENCY_STATS_TIME(stat, statement) \
+        do {                                    \
+            statement;                          \
+        } while (0)
+
+#endif // LATENCY_STATS_ENABLE
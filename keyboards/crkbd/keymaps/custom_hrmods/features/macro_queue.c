@@ -0,0 +1,151 @@
+/* Copyright 2024
+ * Non-Blocking Macro Queue
+ *
+ * SEND_STRING sends every report of a string back to back and waits for
+ * the USB endpoint each time, so the scan loop stalls for the whole
+ * macro. Keys pressed meanwhile are late, and a long macro can outlast
+ * the tapping term of a home row mod held during it.
+ *
+ * Here macros are queued instead and played from housekeeping, one
+ * report per MACRO_QUEUE_INTERVAL_MS (the USB poll interval): a key press
+ * (with Shift when needed) in one report, its release in the next. The
+ * scan loop, the bilateral engine and tap/hold decisions keep running in
+ * between.
+ *
+ * Only pointers to the flash-resident strings are queued, so memory is
+ * fixed at MACRO_QUEUE_DEPTH entries. The SS_TAP/SS_DOWN/SS_UP/SS_DELAY
+ * codes of SEND_STRING are understood.
+ */
+
+#include QMK_KEYBOARD_H
+#include "macro_queue.h"
+
+#ifdef MACRO_QUEUE_ENABLE
+
+#    ifndef MACRO_QUEUE_INTERVAL_MS
+#        define MACRO_QUEUE_INTERVAL_MS USB_POLLING_INTERVAL_MS
+#    endif
+
+static const char *queue[MACRO_QUEUE_DEPTH];
+static uint8_t     queue_head  = 0;
+static uint8_t     queue_count = 0;
+
+static const char *cursor     = NULL;   // Next byte of the playing macro
+static uint8_t     held_key   = KC_NO;  // Pressed by the last step, released by the next
+static bool        held_shift = false;  // Shift added by the player, not the user
+static uint16_t    next_step  = 0;
+
+bool macro_queue_send(const char *string) {
+    if (queue_count >= MACRO_QUEUE_DEPTH) {
+        return false;
+    }
+    queue[(queue_head + queue_count) % MACRO_QUEUE_DEPTH] = string;
+    queue_count++;
+    return true;
+}
+
+bool macro_queue_busy(void) {
+    return cursor != NULL || queue_count > 0 || held_key != KC_NO;
+}
+
+static void release_held(void) {
+    if (held_shift) {
+        del_mods(MOD_BIT(KC_LSFT));
+        held_shift = false;
+    }
+    // unregister_code sends the report, mods included
+    unregister_code(held_key);
+    held_key = KC_NO;
+}
+
+void macro_queue_clear(void) {
+    if (held_key != KC_NO) {
+        release_held();
+    }
+    queue_count = 0;
+    cursor      = NULL;
+}
+
+static void press(uint8_t keycode, bool shifted) {
+    // Leave a Shift the user is holding alone
+    if (shifted && !(get_mods() & MOD_BIT(KC_LSFT))) {
+        add_mods(MOD_BIT(KC_LSFT));
+        held_shift = true;
+    }
+    held_key = keycode;
+    register_code(keycode);
+}
+
+// Advance through the macro until one report went out (or the macro paused)
+static void step(void) {
+    while (true) {
+        if (!cursor) {
+            if (!queue_count) {
+                return;
+            }
+            cursor     = queue[queue_head];
+            queue_head = (queue_head + 1) % MACRO_QUEUE_DEPTH;
+            queue_count--;
+        }
+
+        char ascii_code = (char)pgm_read_byte(cursor);
+        if (ascii_code == '\0') {
+            cursor = NULL;
+            continue;
+        }
+        cursor++;
+
+        if (ascii_code != SS_QMK_PREFIX) {
+            uint8_t c = (uint8_t)ascii_code & 0x7F;
+            press(pgm_read_byte(&ascii_to_keycode_lut[c]), PGM_LOADBIT(ascii_to_shift_lut, c));
+            return;
+        }
+
+        char    code    = (char)pgm_read_byte(cursor++);
+        uint8_t keycode = pgm_read_byte(cursor);
+        switch (code) {
+            case SS_TAP_CODE:
+                cursor++;
+                press(keycode, false);
+                return;
+            case SS_DOWN_CODE:
+                cursor++;
+                register_code(keycode);
+                return;
+            case SS_UP_CODE:
+                cursor++;
+                unregister_code(keycode);
+                return;
+            case SS_DELAY_CODE: {
+                uint16_t ms = 0;
+                while ((keycode = pgm_read_byte(cursor)) >= '0' && keycode <= '9') {
+                    ms = ms * 10 + (keycode - '0');
+                    cursor++;
+                }
+                if (keycode == '|') {
+                    cursor++;
+                }
+                next_step = timer_read() + ms;
+                return;
+            }
+            default:
+                // Unknown code, skip it like send_string does
+                break;
+        }
+    }
+}
+
+void macro_queue_task(void) {
+    if (!macro_queue_busy() || (int16_t)(timer_read() - next_step) < 0) {
+        return;
+    }
+    next_step = timer_read() + MACRO_QUEUE_INTERVAL_MS;
+
+    if (held_key != KC_NO) {
+        release_held();
+    } else {
+        step();
+    }
+}
+
+#endif // MACRO_QUEUE_ENABLE
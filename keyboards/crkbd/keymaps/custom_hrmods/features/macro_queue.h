@@ -0,0 +1,31 @@
+/* Copyright 2024
+ * Non-Blocking Macro Queue - Header
+ */
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifdef MACRO_QUEUE_ENABLE
+
+// Macros that can wait in the queue at once (strings stay in flash)
+#    ifndef MACRO_QUEUE_DEPTH
+#        define MACRO_QUEUE_DEPTH 4
+#    endif
+
+// Queue a PROGMEM string with SEND_STRING syntax. Returns false if full.
+bool macro_queue_send(const char *string);
+
+// Drop everything queued and release anything the player holds
+void macro_queue_clear(void);
+
+// True while a macro is still playing
+bool macro_queue_busy(void);
+
+// Play the next keystroke when due; call from housekeeping_task_user
+void macro_queue_task(void);
+
+// Drop-in replacement for SEND_STRING
+#    define MACRO_QUEUE_SEND(string) macro_queue_send(PSTR(string))
+
+#endif // MACRO_QUEUE_ENABLE
@@ -0,0 +1,299 @@
+/* Copyright 2024
+ * Idle Power Mode
+ *
+ * QMK scans the matrix and redraws the RGB indicators as fast as the main
+ * loop turns, whether anyone types or not; RGB_MATRIX_TIMEOUT only turns
+ * the LEDs off after ten minutes. Here each half steps down on its own
+ * once its matrix has been quiet for a while (POWER_MODE_STEPS): the main
+ * loop sleeps between scans, which lets the RP2040 idle in WFI, and the
+ * indicators recompute their frame less often or not at all.
+ *
+ * Sleeping must not cost the first key anything. While asleep every row
+ * is driven low, so a key going down pulls its column low and the edge
+ * interrupt ends the sleep at once; the scan that follows sees the key.
+ * Keys on the other half cannot wake the master that way, so a connected
+ * master never sleeps longer than a USB poll (POWER_MODE_MASTER_SCAN_MS).
+ * Nothing sleeps while a key is held down.
+ *
+ * The time spent in each state and the number of wake-ups are readable
+ * over raw HID (scripts/hrmods-hid.py power); the wake-up latency, from
+ * the end of a sleep to the waking key reaching the keymap, goes into the
+ * latency histograms. The host simulator provides its own POWER_MODE_WAIT.
+ * Leave POWER_MODE_ENABLE undefined to compile it out.
+ */
+
+#include QMK_KEYBOARD_H
+#include "power_mode.h"
+#include "latency_stats.h"
+
+#ifdef VIA_ENABLE
+#    include "raw_hid.h"
+#    include "via.h"
+#endif
+
+#ifdef POWER_MODE_ENABLE
+
+static const power_mode_step_t steps[] = POWER_MODE_STEPS;
+
+#    define STEP_COUNT (sizeof(steps) / sizeof(steps[0]))
+#    define STATE_COUNT (STEP_COUNT + 1)
+
+// Status reply: 9 header bytes + one uint32 per state in a 32 byte report
+_Static_assert(STATE_COUNT <= 5, "at most 4 power mode steps fit the status reply");
+
+enum power_mode_op {
+    POWER_OP_STATUS = 0x00,
+    POWER_OP_RESET  = 0x01,
+};
+
+static matrix_row_t  last_rows[MATRIX_ROWS];
+static uint8_t       state;  // 0 = full rate, k = steps[k - 1]
+static uint32_t      last_activity;
+static uint32_t      last_task;
+static uint32_t      last_indicators;
+static uint32_t      state_ms[STATE_COUNT];
+static uint32_t      wakes;
+static volatile bool wake_requested;
+static bool          waking;  // Slept at the end of the previous pass
+#    ifdef LATENCY_STATS_ENABLE
+static uint32_t wake_us;
+#    endif
+
+// ============================================================================
+// Sleeping
+// ============================================================================
+
+#    if !defined(POWER_MODE_WAIT) && defined(PROTOCOL_CHIBIOS)
+
+// Any key edge ends the sleep: with every row driven low (COL2ROW diodes)
+// a pressed key pulls its column low, and the columns raise PAL events
+#        if DIODE_DIRECTION != COL2ROW
+#            error "power mode wakes on column edges and needs a COL2ROW matrix"
+#        endif
+
+static const pin_t left_rows[]  = MATRIX_ROW_PINS;
+static const pin_t left_cols[]  = MATRIX_COL_PINS;
+#        ifdef MATRIX_ROW_PINS_RIGHT
+static const pin_t right_rows[] = MATRIX_ROW_PINS_RIGHT;
+#        else
+#            define right_rows left_rows
+#        endif
+#        ifdef MATRIX_COL_PINS_RIGHT
+static const pin_t right_cols[] = MATRIX_COL_PINS_RIGHT;
+#        else
+#            define right_cols left_cols
+#        endif
+
+_Static_assert(sizeof(left_rows) == sizeof(right_rows) && sizeof(left_cols) == sizeof(right_cols), "both halves need the same pin count");
+
+#        define HAND_ROWS (sizeof(left_rows) / sizeof(left_rows[0]))
+#        define HAND_COLS (sizeof(left_cols) / sizeof(left_cols[0]))
+
+#        ifndef POWER_MODE_RECOVER_MS
+#            define POWER_MODE_RECOVER_MS 2  // Longest wait for the columns after a sleep
+#        endif
+
+static thread_reference_t sleeper = NULL;
+
+static void edge_callback(void *arg) {
+    chSysLockFromISR();
+    chThdResumeI(&sleeper, MSG_OK);
+    chSysUnlockFromISR();
+}
+
+static void edge_wait(uint16_t ms) {
+    const pin_t *rows = is_keyboard_left() ? left_rows : right_rows;
+    const pin_t *cols = is_keyboard_left() ? left_cols : right_cols;
+
+    for (uint8_t row = 0; row < HAND_ROWS; row++) {
+        gpio_set_pin_output(rows[row]);
+        gpio_write_pin_low(rows[row]);
+    }
+    matrix_output_select_delay();
+    for (uint8_t col = 0; col < HAND_COLS; col++) {
+        palSetLineCallback(cols[col], edge_callback, NULL);
+        palEnableLineEvent(cols[col], PAL_EVENT_MODE_BOTH_EDGES);
+    }
+
+    // An edge between the last scan and here left its column low already;
+    // one during the check is held off by the lock until we are suspended
+    chSysLock();
+    bool down = wake_requested;
+    for (uint8_t col = 0; col < HAND_COLS; col++) {
+        down |= !gpio_read_pin(cols[col]);
+    }
+    if (!down) {
+        chThdSuspendTimeoutS(&sleeper, TIME_MS2I(ms));
+    }
+    chSysUnlock();
+
+    // Leave the pins the way the matrix scan expects them
+    for (uint8_t col = 0; col < HAND_COLS; col++) {
+        palDisableLineEvent(cols[col]);
+    }
+    for (uint8_t row = 0; row < HAND_ROWS; row++) {
+        gpio_set_pin_input_high(rows[row]);
+    }
+
+    // A key that ended the sleep held its column low against every row.
+    // Let the pull-ups bring all columns back up first, or the next scan
+    // sees that column on row 0 as well (bounded in case a pin is stuck)
+    uint16_t released = timer_read();
+    for (uint8_t col = 0; col < HAND_COLS; col++) {
+        while (!gpio_read_pin(cols[col]) && timer_elapsed(released) < POWER_MODE_RECOVER_MS) {
+        }
+    }
+    matrix_output_unselect_delay(0, true);
+}
+
+// Called from the split transport thread, not from an interrupt
+static void edge_wake(void) {
+    chSysLock();
+    chThdResumeS(&sleeper, MSG_RESET);
+    chSysUnlock();
+}
+
+#        define POWER_MODE_WAIT(ms) edge_wait(ms)
+#        define POWER_MODE_WAKE() edge_wake()
+
+#    elif !defined(POWER_MODE_WAIT)
+#        error "power mode needs POWER_MODE_WAIT on this platform"
+#    endif
+
+// ============================================================================
+// States
+// ============================================================================
+
+// Matrix edges since the last pass; *held is set while any key is down
+static bool matrix_activity(bool *held) {
+    bool changed = false;
+
+    *held = false;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        matrix_row_t rows = matrix_get_row(row);
+
+        changed |= rows != last_rows[row];
+        *held |= rows != 0;
+        last_rows[row] = rows;
+    }
+    return changed;
+}
+
+static uint16_t scan_interval(void) {
+    uint16_t scan_ms = steps[state - 1].scan_ms;
+
+#    ifdef SPLIT_KEYBOARD
+    if (is_keyboard_master() && is_transport_connected() && scan_ms > POWER_MODE_MASTER_SCAN_MS) {
+        scan_ms = POWER_MODE_MASTER_SCAN_MS;
+    }
+#    endif
+    return scan_ms;
+}
+
+void power_mode_task(void) {
+    uint32_t now = timer_read32();
+    bool     held;
+
+    state_ms[state] += now - last_task;
+    last_task = now;
+    waking    = false;
+
+    if (matrix_activity(&held) || held || wake_requested) {
+        wake_requested = false;
+        last_activity  = now;
+    }
+
+    uint8_t next = 0;
+    while (next < STEP_COUNT && now - last_activity >= steps[next].idle_ms) {
+        next++;
+    }
+    if (state && !next) {
+        wakes++;
+    }
+    state = next;
+    if (!state) {
+        return;
+    }
+
+    POWER_MODE_WAIT(scan_interval());
+    waking = true;
+#    ifdef LATENCY_STATS_ENABLE
+    wake_us = latency_stats_now();
+#    endif
+}
+
+void power_mode_wake(void) {
+    wake_requested = true;
+#    ifdef POWER_MODE_WAKE
+    POWER_MODE_WAKE();
+#    endif
+}
+
+void power_mode_record(keyrecord_t *record) {
+#    ifdef LATENCY_STATS_ENABLE
+    // The key that ended the sleep, seen in the first pass after it
+    if (waking && record->event.pressed) {
+        latency_stats_add(STATS_WAKE_LATENCY, latency_stats_now() - wake_us);
+    }
+#    endif
+    waking = false;
+}
+
+bool power_mode_indicators_due(void) {
+    // A wake-up from the master is only seen by the next power_mode_task()
+    if (state && !wake_requested) {
+        uint16_t every = steps[state - 1].indicator_ms;
+        if (!every || timer_elapsed32(last_indicators) < every) {
+            return false;  // Keep drawing the last frame
+        }
+    }
+    last_indicators = timer_read32();
+    return true;
+}
+
+// ============================================================================
+// Raw HID
+// ============================================================================
+
+#    ifdef VIA_ENABLE
+
+static void put_u32(uint8_t *out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = value >> 24;
+}
+
+bool power_mode_via_command(uint8_t *data, uint8_t length) {
+    if (data[0] != POWER_MODE_COMMAND_ID) {
+        // A host talking to the keyboard wants its replies at full rate
+        power_mode_wake();
+        return false;
+    }
+
+    switch (data[1]) {
+        case POWER_OP_STATUS:
+            data[2] = POWER_MODE_VERSION;
+            data[3] = state;
+            data[4] = STATE_COUNT;
+            put_u32(&data[5], wakes);
+            for (uint8_t i = 0; i < STATE_COUNT; i++) {
+                put_u32(&data[9 + i * 4], state_ms[i]);
+            }
+            break;
+        case POWER_OP_RESET:
+            memset(state_ms, 0, sizeof(state_ms));
+            wakes = 0;
+            break;
+        default:
+            data[0] = id_unhandled;
+            break;
+    }
+
+    raw_hid_send(data, length);
+    return true;
+}
+
+#    endif // VIA_ENABLE
+
+#endif // POWER_MODE_ENABLE
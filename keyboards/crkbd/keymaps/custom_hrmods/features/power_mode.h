@@ -0,0 +1,61 @@
+/* Copyright 2024
+ * Idle Power Mode - Header
+ */
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifdef POWER_MODE_ENABLE
+
+// Idle steps, in increasing order: {ms without a key edge, ms between
+// scans, ms between indicator refreshes (0 = freeze the LED frame)}
+#    ifndef POWER_MODE_STEPS
+#        define POWER_MODE_STEPS {{5000, 10, 100}, {30000, 50, 0}}
+#    endif
+
+// Longest scan interval of a master with the other half connected: keys
+// over there cannot wake it, so it keeps polling them at the USB rate
+#    ifndef POWER_MODE_MASTER_SCAN_MS
+#        define POWER_MODE_MASTER_SCAN_MS USB_POLLING_INTERVAL_MS
+#    endif
+
+typedef struct {
+    uint32_t idle_ms;
+    uint16_t scan_ms;
+    uint16_t indicator_ms;
+} power_mode_step_t;
+
+// Raw HID command, next to the keymap batch one
+//
+//   request  [0xF3, op]
+//   op 0x00  status -> [0xF3, 0x00, version, state, n, wake-ups u32, n x ms in state u32]
+//   op 0x01  reset  -> [0xF3, 0x01]     clears the counters
+//
+// Multi-byte fields are little-endian. State 0 is full rate, state k is
+// idle step k, so n is the number of steps plus one.
+#    define POWER_MODE_COMMAND_ID 0xF3
+#    define POWER_MODE_VERSION 1
+
+// Follow matrix activity and sleep until the next scan is due; call last
+// in housekeeping_task_user
+void power_mode_task(void);
+
+// Back to full rate without a key edge (indicator changes from the master,
+// raw HID commands)
+void power_mode_wake(void);
+
+// Wake-up latency sample; call at the top of pre_process_record_user
+void power_mode_record(keyrecord_t *record);
+
+// Whether the RGB indicators should recompute their frame this time
+// instead of redrawing the previous one; ask once per frame
+bool power_mode_indicators_due(void);
+
+#    ifdef VIA_ENABLE
+// Handle the power mode command. Returns true (and replies) if it was one;
+// any other command wakes the keyboard up.
+bool power_mode_via_command(uint8_t *data, uint8_t length);
+#    endif
+
+#endif // POWER_MODE_ENABLE
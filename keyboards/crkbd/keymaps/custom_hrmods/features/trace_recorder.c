@@ -0,0 +1,198 @@
+/* Copyright 2024
+ * Typing Trace Recorder
+ *
+ * Records real typing on the keyboard so TAPPING_TERM, PERMISSIVE_HOLD and
+ * the bilateral rules can be tuned offline against it (tools/hrmods-sim
+ * replays the traces).
+ *
+ * Every key event reaching process_record_user is appended to a RAM ring
+ * buffer as a varint of ms since the previous event plus one byte of
+ * position, press/release and tap/hold outcome. Tap-hold keys reach
+ * process_record_user when they settle, possibly after later keys were
+ * released, so the delta is signed (zigzag). Typing gaps are mostly under
+ * 64ms, so an event usually costs 2 bytes and the default 8 KB hold
+ * around 4000 events. When the buffer is full the oldest events are
+ * dropped and counted.
+ *
+ * Recording is off until the host starts it and costs nothing per scan:
+ * it only runs once per key event. scripts/hrmods-hid.py starts, stops and
+ * drains the recorder over Vial raw HID and writes hrmods-sim traces.
+ * Leave TRACE_RECORDER_ENABLE undefined to compile it out.
+ */
+
+#include QMK_KEYBOARD_H
+#include "trace_recorder.h"
+
+#ifdef VIA_ENABLE
+#    include "raw_hid.h"
+#    include "via.h"
+#endif
+
+#ifdef TRACE_RECORDER_ENABLE
+
+_Static_assert(MATRIX_ROWS <= 8 && MATRIX_COLS <= 8, "trace events pack row and column into 3 bits each");
+_Static_assert(TRACE_RECORDER_SIZE <= UINT16_MAX, "buffer offsets are 16 bit");
+
+#    define EVENT_TAPPED 0x80
+#    define EVENT_PRESSED 0x40
+
+// A varint of a 32 bit delta plus the key byte
+#    define EVENT_MAX_BYTES 6
+
+enum trace_recorder_op {
+    RECORDER_OP_STATUS = 0x00,
+    RECORDER_OP_START  = 0x01,
+    RECORDER_OP_STOP   = 0x02,
+    RECORDER_OP_READ   = 0x03,
+};
+
+static uint8_t  buffer[TRACE_RECORDER_SIZE];
+static uint16_t head;  // Next byte to write
+static uint16_t tail;  // Oldest byte
+static uint16_t used;
+static uint16_t dropped;
+static uint32_t last_time;
+static bool     has_last;
+static bool     recording;
+
+// ============================================================================
+// Ring Buffer
+// ============================================================================
+
+static uint16_t wrap(uint16_t pos) {
+    return pos >= TRACE_RECORDER_SIZE ? pos - TRACE_RECORDER_SIZE : pos;
+}
+
+// Bytes taken by the event starting at tail
+static uint8_t oldest_length(void) {
+    uint8_t length = 1;
+
+    while (buffer[wrap(tail + length - 1)] & 0x80) {
+        length++;
+    }
+    return length + 1;  // Key byte
+}
+
+static void drop_oldest(void) {
+    uint8_t length = oldest_length();
+
+    tail = wrap(tail + length);
+    used -= length;
+    if (dropped < UINT16_MAX) {
+        dropped++;
+    }
+}
+
+static void recorder_clear(void) {
+    head = tail = used = dropped = 0;
+    has_last                     = false;
+}
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+void trace_recorder_record(keyrecord_t *record) {
+    if (!recording || record->event.type != KEY_EVENT) {
+        return;
+    }
+
+    // The event may have waited in the tapping buffer: date it from its scan
+    uint32_t time  = timer_read32() - timer_elapsed(record->event.time);
+    int32_t  diff  = has_last ? (int32_t)(time - last_time) : 0;
+    uint32_t delta = ((uint32_t)diff << 1) ^ (uint32_t)(diff >> 31);  // Zigzag: small either way
+    uint8_t  event[EVENT_MAX_BYTES];
+    uint8_t  length = 0;
+
+    last_time = time;
+    has_last  = true;
+
+    do {
+        event[length] = delta & 0x7F;
+        delta >>= 7;
+        if (delta) {
+            event[length] |= 0x80;
+        }
+        length++;
+    } while (delta);
+
+    uint8_t key = (record->event.key.row << 3) | record->event.key.col;
+    if (record->event.pressed) {
+        key |= EVENT_PRESSED;
+        if (record->tap.count > 0) {
+            key |= EVENT_TAPPED;
+        }
+    }
+    event[length++] = key;
+
+    while (TRACE_RECORDER_SIZE - used < length) {
+        drop_oldest();
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        buffer[head] = event[i];
+        head         = wrap(head + 1);
+    }
+    used += length;
+}
+
+// ============================================================================
+// Raw HID
+// ============================================================================
+
+#    ifdef VIA_ENABLE
+
+static void put_u16(uint8_t *out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+bool trace_recorder_via_command(uint8_t *data, uint8_t length) {
+    if (data[0] != TRACE_RECORDER_COMMAND_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case RECORDER_OP_STATUS:
+            data[2] = TRACE_RECORDER_VERSION;
+            data[3] = recording;
+            put_u16(&data[4], used);
+            put_u16(&data[6], TRACE_RECORDER_SIZE);
+            put_u16(&data[8], dropped);
+            break;
+        case RECORDER_OP_START:
+            recorder_clear();
+            recording = true;
+            break;
+        case RECORDER_OP_STOP:
+            recording = false;
+            break;
+        case RECORDER_OP_READ: {
+            // Whole events only, so the stream can be drained while recording
+            uint8_t n = 0;
+
+            while (used) {
+                uint8_t event = oldest_length();
+                if (3 + n + event > length) {
+                    break;
+                }
+                for (uint8_t i = 0; i < event; i++) {
+                    data[3 + n++] = buffer[tail];
+                    tail          = wrap(tail + 1);
+                }
+                used -= event;
+            }
+            data[2] = n;
+            break;
+        }
+        default:
+            data[0] = id_unhandled;
+            break;
+    }
+
+    raw_hid_send(data, length);
+    return true;
+}
+
+#    endif // VIA_ENABLE
+
+#endif // TRACE_RECORDER_ENABLE
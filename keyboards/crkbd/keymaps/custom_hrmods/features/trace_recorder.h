@@ -0,0 +1,43 @@
+/* Copyright 2024
+ * Typing Trace Recorder - Header
+ */
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifdef TRACE_RECORDER_ENABLE
+
+// Ring buffer size in bytes; most events take 2 bytes
+#    ifndef TRACE_RECORDER_SIZE
+#        define TRACE_RECORDER_SIZE 8192
+#    endif
+
+// Raw HID command, next to the latency stats one
+//
+//   request  [0xF1, op, ...]
+//   op 0x00  status -> [0xF1, 0x00, version, recording, used u16, size u16, dropped u16]
+//   op 0x01  start  -> [0xF1, 0x01]     clears the buffer, then records
+//   op 0x02  stop   -> [0xF1, 0x02]     keeps the buffer for reading
+//   op 0x03  read   -> [0xF1, 0x03, n, n bytes of whole events]  and drops them
+//
+// Multi-byte fields are little-endian. Each event is a zigzag LEB128 varint
+// of ms since the previous event (negative when a tap-hold key settled
+// after later events), then one byte:
+//
+//   bit 7    tap-hold key settled as a tap (press events only)
+//   bit 6    pressed
+//   bits 5-3 matrix row
+//   bits 2-0 matrix column
+#    define TRACE_RECORDER_COMMAND_ID 0xF1
+#    define TRACE_RECORDER_VERSION 1
+
+// Record a key event; call at the top of process_record_user
+void trace_recorder_record(keyrecord_t *record);
+
+#    ifdef VIA_ENABLE
+// Handle the recorder command. Returns true (and replies) if it was one.
+bool trace_recorder_via_command(uint8_t *data, uint8_t length);
+#    endif
+
+#endif // TRACE_RECORDER_ENABLE
@@ -12,133 +12,120 @@
  */
 
 #include QMK_KEYBOARD_H
+#include "layout.gen.h"
 #include "features/bilateral_combinations.h"
+#include "features/active_key_cache.h"
+#include "features/adaptive_tapping_term.h"
+#include "features/macro_queue.h"
+#include "features/latency_stats.h"
+#include "features/trace_recorder.h"
+#include "features/keymap_batch.h"
+#include "features/combo_engine.h"
+#include "features/eager_tap_dance.h"
+#include "features/indicator_sync.h"
+#include "features/power_mode.h"
 
-// Layer definitions
-enum layers {
-    _BASE = 0,
-    _NUM,
-    _SYM,
-    _FN
-};
-
-// Custom keycodes
-enum custom_keycodes {
-    M_IDLE = SAFE_RANGE,
-    M_AREA,
-    M_FULL
-};
-
-// Tap Dance declarations
-enum {
-    TD_ESC_CTRL = 0,
-    TD_DEL_SHFT,
-    TD_ESC_GUI,
-    TD_MACRO_PSCR
-};
+// Macros play from a queue without stalling the scan loop when available
+#ifdef MACRO_QUEUE_ENABLE
+#    define MACRO_SEND(string) MACRO_QUEUE_SEND(string)
+#else
+#    define MACRO_SEND(string) SEND_STRING(string)
+#endif
 
 // Tap Dance definitions
+// Esc goes out on the first press (an extra Esc before Ctrl/GUI is harmless);
+// Del and the screenshot macro can't be taken back, so they wait for the dance
 tap_dance_action_t tap_dance_actions[] = {
-    [TD_ESC_CTRL] = ACTION_TAP_DANCE_DOUBLE(KC_ESC, KC_LCTL),
+    [TD_ESC_CTRL] = ACTION_TAP_DANCE_EAGER(KC_ESC, KC_LCTL, KC_NO),
     [TD_DEL_SHFT] = ACTION_TAP_DANCE_DOUBLE(KC_DEL, KC_LSFT),
-    [TD_ESC_GUI] = ACTION_TAP_DANCE_DOUBLE(KC_ESC, KC_LGUI),
+    [TD_ESC_GUI] = ACTION_TAP_DANCE_EAGER(KC_ESC, KC_LGUI, KC_NO),
     [TD_MACRO_PSCR] = ACTION_TAP_DANCE_DOUBLE(M_FULL, KC_PSCR)
 };
 
-const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
-    /* Layer 0: Base (Colemak-DH with home row mods)
-     * ┌─────┬─────┬─────┬─────┬─────┬─────┐               ┌─────┬─────┬─────┬─────┬─────┬─────┐
-     * │ Tab │  Q  │  W  │  F  │  P  │  B  │               │ Esc │ TD2 │  J  │  L  │  U  │  Y  │
-     * ├─────┼─────┼─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┼─────┼─────┤
-     * │ ;:  │BKSPC│LSPO │GUI/A│ALT/R│CTL/S│               │SFT/T│  G  │RCPC │ Alt │  M  │SFT/N│
-     * ├─────┼─────┼─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┼─────┼─────┤
-     * │CTL/E│ALT/I│GUI/O│ TD1 │LGui │  Z  │               │  X  │  C  │  D  │  V  │  K  │  H  │
-     * └─────┴─────┴─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┴─────┴─────┘
-     *                   │ ,   │  .  │  /  │               │  '  │LCtrl│MO(1)│
-     *                   └─────┴─────┴─────┘               └─────┴─────┴─────┘
-     *                                 ┌─────┬─────┐ ┌─────┬─────┐
-     *                                 │Space│SftEn││ │MO(2)│RCtrl│
-     *                                 └─────┴─────┘ └─────┴─────┘
-     */
-    [_BASE] = LAYOUT_split_3x6_3_ex2(
-        KC_TAB,  KC_Q,            KC_W,            KC_F,            KC_P,            KC_B,     QK_GESC, TD(TD_ESC_GUI), KC_J,    KC_L,            KC_U,            KC_Y,            KC_SCLN,         KC_BSPC,
-        SC_LSPO, MT(MOD_LGUI,KC_A), MT(MOD_LALT,KC_R), MT(MOD_LCTL,KC_S), MT(MOD_LSFT,KC_T), KC_G,     SC_RCPC, KC_RALT,        KC_M,    MT(MOD_RSFT,KC_N), MT(MOD_RCTL,KC_E), MT(MOD_RALT,KC_I), MT(MOD_RGUI,KC_O), TD(TD_DEL_SHFT),
-        KC_LGUI, KC_Z,            KC_X,            KC_C,            KC_D,            KC_V,     KC_K,    KC_H,           KC_COMM, KC_DOT,          KC_SLSH,         KC_QUOT,
-                                                   KC_LCTL,         MO(_NUM),        KC_SPC,   SC_SENT, MO(_SYM),     KC_RCTL
-    ),
-
-    /* Layer 1: Numbers & Navigation
-     * ┌─────┬─────┬─────┬─────┬─────┬─────┐               ┌─────┬─────┬─────┬─────┬─────┬─────┐
-     * │     │  1  │  2  │  3  │  4  │  5  │               │     │     │  6  │  7  │  8  │  9  │
-     * ├─────┼─────┼─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┼─────┼─────┤
-     * │  0  │BKSPC│     │     │     │     │               │     │     │     │     │ Left│ Down│
-     * ├─────┼─────┼─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┼─────┼─────┤
-     * │ Up  │Right│     │     │     │     │               │ TG3 │     │     │     │     │     │
-     * └─────┴─────┴─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┴─────┴─────┘
-     *                   │     │     │     │               │     │     │     │
-     *                   └─────┴─────┴─────┘               └─────┴─────┴─────┘
-     *                                 ┌─────┬─────┐ ┌─────┬─────┐
-     *                                 │LGui │     │ │Space│SftEn│
-     *                                 └─────┴─────┘ └─────┴─────┘
-     *                                            ┌─────┬─────┐
-     *                                            │     │RGui │
-     *                                            └─────┴─────┘
-     */
-    [_NUM] = LAYOUT_split_3x6_3_ex2(
-        KC_TRNS, KC_1,    KC_2,    KC_3,    KC_4,    KC_5,     KC_TRNS, KC_TRNS, KC_6,    KC_7,    KC_8,    KC_9,    KC_0,     KC_BSPC,
-        KC_TRNS, KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,    KC_TRNS, KC_TRNS, KC_NO,   KC_LEFT, KC_DOWN, KC_UP,   KC_RIGHT, KC_NO,
-        KC_TRNS, KC_NO,   KC_NO,   TG(_FN), KC_NO,   KC_NO,    KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,
-                                    KC_LGUI, KC_TRNS, KC_SPC,   SC_SENT, KC_TRNS, KC_RGUI
-    ),
-
-    /* Layer 2: Symbols & Programming
-     * ┌─────┬─────┬─────┬─────┬─────┬─────┐               ┌─────┬─────┬─────┬─────┬─────┬─────┐
-     * │ Tab │  !  │  @  │  #  │  $  │  %  │               │LCtrl│RCtrl│  *  │  "  │  ü  │  &  │
-     * ├─────┼─────┼─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┼─────┼─────┤
-     * │  ^  │BKSPC│LCtrl│  ä  │  ß  │  ö  │               │     │     │LAlt │ Alt │  -  │  =  │
-     * ├─────┼─────┼─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┼─────┼─────┤
-     * │  ]  │  [  │  ö  │  `  │LShft│  |  │               │  ?  │     │     │     │  _  │  +  │
-     * └─────┴─────┴─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┴─────┴─────┘
-     *                   │  }  │  {  │  \  │               │  ~  │LGui │     │
-     *                   └─────┴─────┴─────┘               └─────┴─────┴─────┘
-     *                                 ┌─────┬─────┐ ┌─────┬─────┐
-     *                                 │Space│SftEn│ │     │RGui │
-     *                                 └─────┴─────┘ └─────┴─────┘
-     */
-    [_SYM] = LAYOUT_split_3x6_3_ex2(
-        KC_TAB,  LSFT(KC_1), LSFT(KC_2), LSFT(KC_3), LSFT(KC_4), LSFT(KC_5),  KC_LCTL,   KC_RCTL,      LSFT(KC_8), LSFT(KC_QUOT), RALT(KC_U), LSFT(KC_7), LSFT(KC_6), KC_BSPC,
-        KC_LCTL, RALT(KC_A), RALT(KC_0), RALT(KC_S), KC_NO,      KC_NO,       KC_LALT,   KC_RALT,      KC_MINS,    KC_EQL,        KC_RBRC,    KC_LBRC,    RALT(KC_O), KC_GRV,
-        KC_LSFT, LSFT(KC_BSLS), LSFT(KC_SLSH), KC_NO, KC_NO,   KC_NO,       LSFT(KC_MINS), LSFT(KC_EQL), LSFT(KC_RBRC), LSFT(KC_LBRC), KC_BSLS, LSFT(KC_GRV),
-                                              KC_LGUI, KC_TRNS, KC_SPC,      SC_SENT, KC_TRNS,      KC_RGUI
-    ),
-
-    /* Layer 3: Function & System
-     * ┌─────┬─────┬─────┬─────┬─────┬─────┐               ┌─────┬─────┬─────┬─────┬─────┬─────┐
-     * │Reset│ F1  │ F2  │ F3  │ F4  │ F5  │               │ F6  │ F7  │ F8  │ F9  │ F10 │ F11 │
-     * ├─────┼─────┼─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┼─────┼─────┤
-     * │ F12 │ TD3 │RGB T│RGB H│RGB S│RGB V│               │IDLE │     │     │BriDn│BriUp│Mute │
-     * ├─────┼─────┼─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┼─────┼─────┤
-     * │Vol- │Vol+ │PgUp │Home │RGB M│RGB h│               │RGB s│RGB v│FULL │PScr │     │     │
-     * └─────┴─────┴─────┼─────┼─────┼─────┤               ├─────┼─────┼─────┼─────┴─────┴─────┘
-     *                   │     │     │PgDn │               │ End │LGui │     │
-     *                   └─────┴─────┴─────┘               └─────┴─────┴─────┘
-     *                                 ┌─────┬─────┐ ┌─────┬─────┐
-     *                                 │Space│SftEn│ │     │RGui │
-     *                                 └─────┴─────┘ └─────┴─────┘
-     */
-    [_FN] = LAYOUT_split_3x6_3_ex2(
-        QK_BOOT, KC_F1,   KC_F2,   KC_F3,   KC_F4,   KC_F5,    KC_F6,   KC_F7,   KC_F8,   KC_F9,   KC_F10,  KC_F11,  KC_F12,  TD(TD_MACRO_PSCR),
-        RGB_TOG, RGB_HUI, RGB_SAI, RGB_VAI, M_IDLE,  KC_NO,    KC_NO,   KC_BRID, KC_BRIU, KC_MUTE, KC_VOLD, KC_VOLU, KC_PGUP, KC_HOME,
-        RGB_MOD, RGB_HUD, RGB_SAD, RGB_VAD, M_FULL,  KC_PSCR,  KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_PGDN, KC_END,
-                                    KC_LGUI, KC_TRNS, KC_SPC,   SC_SENT, KC_TRNS, KC_RGUI
-    )
-};
+// The keymap, like the layer, keycode and tap dance names in layout.gen.h,
+// is generated from layout.yaml: run scripts/gen-layout.py after editing it
+#include "keymap.gen.h"
+
+// Runs before QMK's hold/tap logic sees the event
+bool pre_process_record_user(uint16_t keycode, keyrecord_t *record) {
+#ifdef POWER_MODE_ENABLE
+    // Wake-up latency of the key that ended an idle sleep
+    power_mode_record(record);
+#endif
+#ifdef BILATERAL_COMBINATIONS
+    // Feed key timing to the bilateral home row mod engine
+    bool keep;
+    LATENCY_STATS_TIME(STATS_BILATERAL, keep = pre_process_record_bilateral(keycode, record));
+    if (!keep) {
+        return false;
+    }
+#endif
+#ifdef COMBO_ENGINE_ENABLE
+    // Hold back possible combo keys (after the bilateral engine saw them)
+    if (!pre_process_record_combo(keycode, record)) {
+        return false;
+    }
+#endif
+#if defined(BILATERAL_COMBINATIONS) && defined(BILATERAL_FLOW_MS)
+    // Home row mods typed mid-streak skip the hold/tap decision
+    if (!pre_process_record_flow(keycode, record)) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+void keyboard_post_init_user(void) {
+#ifdef ADAPTIVE_TAPPING_TERM
+    // Restore learned home row mod tapping terms
+    adaptive_tapping_term_init();
+#endif
+#if defined(INDICATOR_SYNC_ENABLE) && defined(RGB_MATRIX_ENABLE)
+    // Slave side of the layer indicator channel
+    indicator_sync_init();
+#endif
+}
+
+void housekeeping_task_user(void) {
+#ifdef LATENCY_STATS_ENABLE
+    latency_stats_scan();
+#endif
+#ifdef COMBO_ENGINE_ENABLE
+    combo_engine_task();
+#endif
+#ifdef MACRO_QUEUE_ENABLE
+    // Play queued macros one report per USB poll
+    macro_queue_task();
+#endif
+#ifdef ADAPTIVE_TAPPING_TERM
+    adaptive_tapping_term_task();
+#endif
+#ifdef KEYMAP_BATCH_ENABLE
+    // Commit staged Vial keys once the host went quiet
+    keymap_batch_task();
+#endif
+#if defined(INDICATOR_SYNC_ENABLE) && defined(RGB_MATRIX_ENABLE)
+    // Master only: send layer indicator changes to the other half
+    indicator_sync_task();
+#endif
+#ifdef POWER_MODE_ENABLE
+    // Last: sleeps until the next scan once the matrix has been idle
+    power_mode_task();
+#endif
+}
 
 // Process custom keycodes (macros)
-bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+static bool process_record_keymap(uint16_t keycode, keyrecord_t *record) {
+#ifdef ADAPTIVE_TAPPING_TERM
+    // Learn tap durations before anything can swallow the event
+    adaptive_tapping_term_record(keycode, record);
+#endif
+
 #ifdef BILATERAL_COMBINATIONS
     // Process bilateral combinations for home row mods
-    if (!process_record_bilateral(keycode, record)) {
+    bool keep;
+    LATENCY_STATS_TIME(STATS_BILATERAL, keep = process_record_bilateral(keycode, record));
+    if (!keep) {
         return false;
     }
 #endif
@@ -146,23 +133,35 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
     switch (keycode) {
         case M_IDLE:  // Toggle vigiland idle inhibitor
             if (record->event.pressed) {
-                SEND_STRING("pkill -x vigiland || vigiland &" SS_TAP(X_ENTER));
+                MACRO_SEND("pkill -x vigiland || vigiland &" SS_TAP(X_ENTER));
             }
             return false;
         case M_AREA:  // Region screenshot
             if (record->event.pressed) {
-                SEND_STRING("screenshot-region" SS_TAP(X_ENTER));
+                MACRO_SEND("screenshot-region" SS_TAP(X_ENTER));
             }
             return false;
         case M_FULL:  // Full screenshot
             if (record->event.pressed) {
-                SEND_STRING("screenshot-full" SS_TAP(X_ENTER));
+                MACRO_SEND("screenshot-full" SS_TAP(X_ENTER));
             }
             return false;
     }
     return true;
 }
 
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+#ifdef LATENCY_STATS_ENABLE
+    latency_stats_record(record);
+#endif
+#ifdef TRACE_RECORDER_ENABLE
+    trace_recorder_record(record);
+#endif
+    bool keep;
+    LATENCY_STATS_TIME(STATS_PROCESS_RECORD, keep = process_record_keymap(keycode, record));
+    return keep;
+}
+
 #ifdef RGB_MATRIX_ENABLE
 
 // RGB color definitions for warm gradient scheme
@@ -171,27 +170,23 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
 // Layer 2 (Symbols): Yellow (255, 255, 0)
 // Layer 3 (Function): Red (255, 0, 0)
 
-// Helper function to determine if a key is active on the current layer
-bool is_key_active(uint8_t layer, uint8_t row, uint8_t col) {
-    uint16_t keycode = keymap_key_to_keycode(layer, (keypos_t){col, row});
-
-    // Transparent keys are not active on this layer
-    if (keycode == KC_TRNS) {
-        return false;
-    }
-
-    // KC_NO keys are explicitly disabled
-    if (keycode == KC_NO) {
-        return false;
-    }
-
-    // All other keys are active
-    return true;
-}
+// The frame being drawn; recomputed at the start of a frame, and less often
+// or not at all while the power mode idles (the LEDs keep the last one)
+static struct {
+    bool     lit;  // On layers 0-3
+    RGB      color;
+    uint64_t active;
+} frame;
+static bool frame_valid;
 
-// Main RGB indicator function - called on every matrix scan
-bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
+static void rgb_layer_frame(void) {
+#    ifdef INDICATOR_SYNC_ENABLE
+    // The slave draws what the master last sent instead of recomputing it
+    const indicator_state_t *state = indicator_sync_state();
+    uint8_t                  layer = state->layer;
+#    else
     uint8_t layer = get_highest_layer(layer_state);
+#    endif
 
     // Define colors for each layer (warm gradient scheme)
     RGB layer_colors[4] = {
@@ -202,25 +197,58 @@ bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
     };
 
     // Only highlight if we're on layers 0-3
-    if (layer > 3) {
+    frame.lit = layer <= 3;
+    if (!frame.lit) {
+        return;
+    }
+
+    frame.color = layer_colors[layer];
+
+    // Active keys per layer come from a RAM cache rebuilt only on keymap changes
+#    ifdef INDICATOR_SYNC_ENABLE
+    frame.active = state->active;
+#    else
+    frame.active = active_key_cache_layer(layer);
+#    endif
+}
+
+// Frames are drawn in chunks of LEDs; the first chunk decides
+static bool rgb_layer_frame_due(uint8_t led_min) {
+    if (!frame_valid) {
+        return true;
+    }
+    if (led_min != 0) {
         return false;
     }
+#    ifdef POWER_MODE_ENABLE
+    return power_mode_indicators_due();
+#    else
+    return true;
+#    endif
+}
+
+static void rgb_layer_indicators(uint8_t led_min, uint8_t led_max) {
+    if (rgb_layer_frame_due(led_min)) {
+        rgb_layer_frame();
+        frame_valid = true;
+    }
+    if (!frame.lit) {
+        return;
+    }
 
-    RGB current_color = layer_colors[layer];
+    RGB      current_color = frame.color;
+    uint64_t active        = frame.active;
+    uint64_t key_leds      = active_key_cache_key_leds();
 
-    // Iterate through all LEDs
     for (uint8_t led = led_min; led < led_max; led++) {
-        // Get the position of the LED
-        uint8_t row = g_led_config.matrix_co[led][0];
-        uint8_t col = g_led_config.matrix_co[led][1];
+        uint64_t bit = (uint64_t)1 << led;
 
-        // Skip if this LED doesn't correspond to a key
-        if (row == NO_LED || col == NO_LED) {
+        // Skip LEDs that don't belong to a key
+        if (!(key_leds & bit)) {
             continue;
         }
 
-        // Check if this key is active on the current layer
-        if (is_key_active(layer, row, col)) {
+        if (active & bit) {
             // Set the LED to the layer color
             rgb_matrix_set_color(led, current_color.r, current_color.g, current_color.b);
         } else {
@@ -228,8 +256,53 @@ bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
             rgb_matrix_set_color(led, 0, 0, 0);
         }
     }
+}
 
+// Main RGB indicator function - called on every matrix scan
+bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
+    LATENCY_STATS_TIME(STATS_RGB_INDICATORS, rgb_layer_indicators(led_min, led_max));
     return false;
 }
 
 #endif // RGB_MATRIX_ENABLE
+
+// EEPROM clear: forget everything derived from the old contents
+void eeconfig_init_user(void) {
+#ifdef RGB_MATRIX_ENABLE
+    active_key_cache_invalidate();
+#endif
+#ifdef ADAPTIVE_TAPPING_TERM
+    adaptive_tapping_term_reset();
+#endif
+}
+
+#ifdef VIA_ENABLE
+// Raw HID hook, runs before VIA/Vial handle the command
+bool via_command_kb(uint8_t *data, uint8_t length) {
+#    ifdef POWER_MODE_ENABLE
+    // Ahead of the others: any other command wakes the keyboard up
+    if (power_mode_via_command(data, length)) {
+        return true;
+    }
+#    endif
+#    ifdef LATENCY_STATS_ENABLE
+    if (latency_stats_via_command(data, length)) {
+        return true;  // Our own command, already answered
+    }
+#    endif
+#    ifdef TRACE_RECORDER_ENABLE
+    if (trace_recorder_via_command(data, length)) {
+        return true;
+    }
+#    endif
+#    ifdef KEYMAP_BATCH_ENABLE
+    if (keymap_batch_via_command(data, length)) {
+        return true;
+    }
+#    endif
+#    ifdef RGB_MATRIX_ENABLE
+    active_key_cache_via_command(data, length);
+#    endif
+    return false;  // Let VIA/Vial process the command as usual
+}
+#endif // VIA_ENABLE
@@ -0,0 +1,41 @@
+/* Copyright 2024
+ * Layout Tables
+ *
+ * Generated by scripts/gen-layout.py from layout.yaml; do not edit.
+ */
+
+#include QMK_KEYBOARD_H
+#include "layout.gen.h"
+
+_Static_assert(MATRIX_ROWS == 8 && MATRIX_COLS == 7, "layout.yaml is laid out for the Corne matrix");
+
+// clang-format off
+const uint16_t layout_tapping_term[MATRIX_ROWS][MATRIX_COLS] = {
+    {     TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM},
+    {     TAPPING_TERM, TAPPING_TERM + 25, TAPPING_TERM + 25, TAPPING_TERM + 25, TAPPING_TERM + 25,      TAPPING_TERM,      TAPPING_TERM},
+    {     TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM},
+    {     TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM},
+    {     TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM},
+    {     TAPPING_TERM, TAPPING_TERM + 25, TAPPING_TERM + 25, TAPPING_TERM + 25, TAPPING_TERM + 25,      TAPPING_TERM,      TAPPING_TERM},
+    {     TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM},
+    {     TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM,      TAPPING_TERM},
+};
+
+const uint8_t layout_key_flags[MATRIX_ROWS][MATRIX_COLS] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x00, 0x04, 0x14, 0x24, 0x34, 0x00, 0x00},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02},
+    {0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01},
+    {0x01, 0x75, 0x65, 0x55, 0x45, 0x01, 0x01},
+    {0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01},
+    {0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02},
+};
+
+const uint64_t layout_active_keys[LAYOUT_LAYER_COUNT] = {
+    [_BASE] = 0x70FFFFF70FFFFF,
+    [_NUM] = 0x5000F3F502003E,
+    [_SYM] = 0x50FFFFF501E7FF,
+    [_FN] = 0x500FFFF50FCFFF,
+};
+// clang-format on
@@ -0,0 +1,53 @@
+/* Copyright 2024
+ * Layout Tables - Header
+ *
+ * Generated by scripts/gen-layout.py from layout.yaml; do not edit.
+ */
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+enum layers {
+    _BASE = 0,
+    _NUM,
+    _SYM,
+    _FN,
+};
+
+#define LAYOUT_LAYER_COUNT 4
+
+enum custom_keycodes {
+    M_IDLE = SAFE_RANGE,
+    M_AREA,
+    M_FULL,
+};
+
+enum tap_dances {
+    TD_ESC_CTRL = 0,
+    TD_DEL_SHFT,
+    TD_ESC_GUI,
+    TD_MACRO_PSCR,
+};
+
+// layout_key_flags: hand in bits 0-1, home row mod flag, home row mod
+// index (0 .. LAYOUT_HOME_ROW_MODS - 1, in LAYOUT order) in bits 4-7
+#define LAYOUT_HAND_LEFT 0
+#define LAYOUT_HAND_RIGHT 1
+#define LAYOUT_HAND_THUMB 2
+#define LAYOUT_KEY_HOME_ROW_MOD 0x04
+#define LAYOUT_KEY_HAND(flags) ((flags) & 0x03)
+#define LAYOUT_KEY_HRM_INDEX(flags) ((flags) >> 4)
+#define LAYOUT_HOME_ROW_MODS 8
+
+// Bit of a matrix position in layout_active_keys
+#define LAYOUT_KEY_BIT(row, col) ((uint64_t)1 << ((row) * MATRIX_COLS + (col)))
+
+// Tapping term per matrix position
+extern const uint16_t layout_tapping_term[MATRIX_ROWS][MATRIX_COLS];
+
+// Hand and home row mod flags per matrix position (from _BASE)
+extern const uint8_t layout_key_flags[MATRIX_ROWS][MATRIX_COLS];
+
+// Keys that are neither KC_TRNS nor KC_NO, per layer (LAYOUT_KEY_BIT)
+extern const uint64_t layout_active_keys[LAYOUT_LAYER_COUNT];
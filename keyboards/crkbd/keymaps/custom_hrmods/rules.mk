@@ -23,12 +23,13 @@ RGB_MATRIX_DRIVER = ws2812
 # Features
 # ============================================================================
 
-COMBO_ENABLE = yes
+COMBO_ENABLE = yes            # Vial combos; combos.def runs in features/combo_engine.c
 TAP_DANCE_ENABLE = yes
 EXTRAKEY_ENABLE = yes        # Audio control and System control
 MOUSEKEY_ENABLE = yes        # Mouse keys
 NKRO_ENABLE = yes            # N-Key Rollover
 RGBLIGHT_ENABLE = no         # Disable old RGB underglow (we use RGB Matrix)
+DEBOUNCE_TYPE = custom       # features/eager_debounce.c: eager press, deferred release
 
 # ============================================================================
 # Size Optimization
@@ -59,4 +60,19 @@ BOOTLOADER = rp2040
 # Custom Code
 # ============================================================================
 
+SRC += layout.gen.c
 SRC += features/bilateral_combinations.c
+SRC += features/active_key_cache.c
+SRC += features/adaptive_tapping_term.c
+SRC += features/macro_queue.c
+SRC += features/latency_stats.c
+SRC += features/trace_recorder.c
+SRC += features/keymap_batch.c
+SRC += features/combo_engine.c
+SRC += features/eager_tap_dance.c
+SRC += features/indicator_sync.c
+SRC += features/power_mode.c
+
+ifeq ($(strip $(DEBOUNCE_TYPE)), custom)
+    SRC += features/eager_debounce.c
+endif
@@ -0,0 +1,426 @@
+#!/usr/bin/env python3
+"""Generate the keymap tables, vial.json and drawer legends from layout.yaml."""
+
+from __future__ import annotations
+
+import argparse
+import json
+import re
+import sys
+from dataclasses import dataclass
+from pathlib import Path
+
+import yaml
+
+
+REPO_DIR = Path(__file__).resolve().parent.parent
+KEYMAP_DIR = REPO_DIR / "keyboards/crkbd/keymaps/custom_hrmods"
+SPEC_PATH = KEYMAP_DIR / "layout.yaml"
+DRAWER_PATH = REPO_DIR / "keymap-drawer.yaml"
+
+LAYOUT_MACRO = "LAYOUT_split_3x6_3_ex2"
+MATRIX_ROWS = 8
+MATRIX_COLS = 7
+
+# Grid columns used by each row of the LAYOUT macro: 14 per row, the bottom
+# row has no inner keys and the thumbs sit under the inner columns
+GRID_WIDTH = 14
+ROW_GRID = (
+    tuple(range(14)),
+    tuple(range(14)),
+    tuple(range(6)) + tuple(range(8, 14)),
+    (3, 4, 5, 8, 9, 10),
+)
+
+# Hands as in layout.gen.h
+HAND_LEFT = 0
+HAND_RIGHT = 1
+HAND_THUMB = 2
+
+FLAG_HOME_ROW_MOD = 0x04
+HRM_INDEX_SHIFT = 4
+FINGERS = ("pinky", "ring", "middle", "index")  # Outermost home row mod first
+
+INACTIVE_KEYCODES = {"KC_TRNS", "KC_TRANSPARENT", "_______", "KC_NO", "XXXXXXX"}
+
+MOD_TAP_RE = re.compile(r"^MT\(([A-Z_|]+),(KC_[A-Z0-9_]+)\)$")
+MOD_GLYPHS = (("GUI", "⌘"), ("ALT", "⌥"), ("CTL", "⌃"), ("SFT", "⇧"))
+
+# Physical key positions for the Vial layout (keyboard units)
+COLUMN_STAGGER = (0.375, 0.375, 0.125, 0.0, 0.125, 0.25, 0.5)
+
+DRAWER_BEGIN = "    # BEGIN generated by scripts/gen-layout.py from layout.yaml"
+DRAWER_END = "    # END generated"
+
+GENERATED_NOTE = "Generated by scripts/gen-layout.py from layout.yaml; do not edit."
+
+
+class SpecError(Exception):
+    pass
+
+
+@dataclass(frozen=True)
+class Key:
+    row: int
+    col: int
+    grid_row: int
+    grid_col: int
+
+
+@dataclass(frozen=True)
+class Layer:
+    name: str
+    title: str
+    keycodes: tuple[tuple[str, ...], ...]  # Per grid row, LAYOUT order
+
+
+# ============================================================================
+# Spec
+# ============================================================================
+
+
+def layout_keys() -> list[list[Key]]:
+    """Matrix position of every LAYOUT argument, per grid row."""
+    rows = []
+    for grid_row, columns in enumerate(ROW_GRID):
+        keys = []
+        for grid_col in columns:
+            if grid_col < GRID_WIDTH // 2:
+                row, col = grid_row, grid_col
+            else:
+                # Right half is mirrored: its outer column is column 0
+                row, col = grid_row + MATRIX_ROWS // 2, GRID_WIDTH - 1 - grid_col
+            keys.append(Key(row, col, grid_row, grid_col))
+        rows.append(keys)
+    return rows
+
+
+def parse_layer(entry: dict, keys: list[list[Key]]) -> Layer:
+    name = entry["name"]
+    lines = [line.split() for line in entry["keys"].splitlines() if line.strip()]
+    if len(lines) != len(keys):
+        raise SpecError(f"{name}: expected {len(keys)} rows, got {len(lines)}")
+    for index, (line, row_keys) in enumerate(zip(lines, keys)):
+        if len(line) != len(row_keys):
+            raise SpecError(f"{name}: row {index} has {len(line)} keys, expected {len(row_keys)}")
+    return Layer(name, entry.get("title", name), tuple(tuple(line) for line in lines))
+
+
+def load_spec(path: Path) -> dict:
+    spec = yaml.safe_load(path.read_text(encoding="utf-8"))
+    keys = layout_keys()
+    spec["layers"] = [parse_layer(entry, keys) for entry in spec["layers"]]
+    if len(spec["layers"]) > 32:
+        raise SpecError("at most 32 layers")
+    return spec
+
+
+def hand_of(row: int) -> int:
+    if row in (MATRIX_ROWS // 2 - 1, MATRIX_ROWS - 1):
+        return HAND_THUMB
+    return HAND_LEFT if row < MATRIX_ROWS // 2 else HAND_RIGHT
+
+
+def is_home_row_mod(keycode: str) -> bool:
+    match = MOD_TAP_RE.match(keycode)
+    return bool(match) and re.fullmatch(r"KC_[A-Z]", match.group(2)) is not None
+
+
+def matrix_of(layer: Layer) -> dict[tuple[int, int], str]:
+    matrix = {}
+    for keycodes, keys in zip(layer.keycodes, layout_keys()):
+        for keycode, key in zip(keycodes, keys):
+            matrix[(key.row, key.col)] = keycode
+    return matrix
+
+
+# ============================================================================
+# C Output
+# ============================================================================
+
+
+def key_tables(spec: dict) -> tuple[list[list[str]], list[list[int]], int]:
+    """Tapping term expressions and flags per matrix position, home row mod count."""
+    base = matrix_of(spec["layers"][0])
+    terms = [[spec["tapping_term"]["default"]] * MATRIX_COLS for _ in range(MATRIX_ROWS)]
+    flags = [[hand_of(row)] * MATRIX_COLS for row in range(MATRIX_ROWS)]
+    home_row_mods = 0
+
+    # LAYOUT order, so the home row mod index is stable while keys stay put
+    positions = []
+    for keys in layout_keys():
+        for key in keys:
+            if key.row == MATRIX_ROWS // 2 - 1 or key.row == MATRIX_ROWS - 1:
+                continue
+            if is_home_row_mod(base[(key.row, key.col)]):
+                flags[key.row][key.col] |= FLAG_HOME_ROW_MOD | (home_row_mods << HRM_INDEX_SHIFT)
+                positions.append(key)
+                home_row_mods += 1
+    if home_row_mods > 16:
+        raise SpecError("at most 16 home row mods")
+
+    # One term for all home row mods, or one per finger (mirrored on both hands)
+    term = spec["tapping_term"]["home_row_mod"]
+    for index, key in enumerate(positions):
+        if not isinstance(term, dict):
+            terms[key.row][key.col] = term
+            continue
+        finger = min(index, home_row_mods - 1 - index)
+        if finger >= len(FINGERS) or FINGERS[finger] not in term:
+            raise SpecError(f"tapping_term.home_row_mod: no term for home row mod {index}")
+        terms[key.row][key.col] = term[FINGERS[finger]]
+    return terms, flags, home_row_mods
+
+
+def active_mask(layer: Layer) -> int:
+    mask = 0
+    for (row, col), keycode in matrix_of(layer).items():
+        if keycode not in INACTIVE_KEYCODES:
+            mask |= 1 << (row * MATRIX_COLS + col)
+    return mask
+
+
+def c_header(title: str, body: str) -> str:
+    return f"/* Copyright 2024\n * {title}\n *\n * {GENERATED_NOTE}\n */\n\n{body}"
+
+
+def enum_lines(names: list[str], first: str) -> list[str]:
+    return [f"    {name}{f' = {first}' if i == 0 else ''}," for i, name in enumerate(names)]
+
+
+def render_layout_h(spec: dict) -> str:
+    layers = [layer.name for layer in spec["layers"]]
+    custom = spec.get("custom_keycodes", [])
+    dances = [dance["name"] for dance in spec.get("tap_dances", [])]
+    _, _, home_row_mods = key_tables(spec)
+
+    lines = [
+        "#pragma once",
+        "",
+        "#include QMK_KEYBOARD_H",
+        "",
+        "enum layers {",
+        *enum_lines(layers, "0"),
+        "};",
+        "",
+        f"#define LAYOUT_LAYER_COUNT {len(layers)}",
+    ]
+    if custom:
+        lines += ["", "enum custom_keycodes {", *enum_lines(custom, "SAFE_RANGE"), "};"]
+    if dances:
+        lines += ["", "enum tap_dances {", *enum_lines(dances, "0"), "};"]
+    lines += [
+        "",
+        "// layout_key_flags: hand in bits 0-1, home row mod flag, home row mod",
+        "// index (0 .. LAYOUT_HOME_ROW_MODS - 1, in LAYOUT order) in bits 4-7",
+        f"#define LAYOUT_HAND_LEFT {HAND_LEFT}",
+        f"#define LAYOUT_HAND_RIGHT {HAND_RIGHT}",
+        f"#define LAYOUT_HAND_THUMB {HAND_THUMB}",
+        f"#define LAYOUT_KEY_HOME_ROW_MOD 0x{FLAG_HOME_ROW_MOD:02X}",
+        "#define LAYOUT_KEY_HAND(flags) ((flags) & 0x03)",
+        f"#define LAYOUT_KEY_HRM_INDEX(flags) ((flags) >> {HRM_INDEX_SHIFT})",
+        f"#define LAYOUT_HOME_ROW_MODS {home_row_mods}",
+        "",
+        "// Bit of a matrix position in layout_active_keys",
+        "#define LAYOUT_KEY_BIT(row, col) ((uint64_t)1 << ((row) * MATRIX_COLS + (col)))",
+        "",
+        "// Tapping term per matrix position",
+        "extern const uint16_t layout_tapping_term[MATRIX_ROWS][MATRIX_COLS];",
+        "",
+        "// Hand and home row mod flags per matrix position (from _BASE)",
+        "extern const uint8_t layout_key_flags[MATRIX_ROWS][MATRIX_COLS];",
+        "",
+        "// Keys that are neither KC_TRNS nor KC_NO, per layer (LAYOUT_KEY_BIT)",
+        "extern const uint64_t layout_active_keys[LAYOUT_LAYER_COUNT];",
+        "",
+    ]
+    return c_header("Layout Tables - Header", "\n".join(lines))
+
+
+def c_table(rows: list[list[str]]) -> list[str]:
+    width = max(len(cell) for row in rows for cell in row)
+    return ["    {" + ", ".join(cell.rjust(width) for cell in row) + "}," for row in rows]
+
+
+def render_layout_c(spec: dict) -> str:
+    terms, flags, _ = key_tables(spec)
+
+    lines = [
+        '#include QMK_KEYBOARD_H',
+        '#include "layout.gen.h"',
+        "",
+        f'_Static_assert(MATRIX_ROWS == {MATRIX_ROWS} && MATRIX_COLS == {MATRIX_COLS}, "layout.yaml is laid out for the Corne matrix");',
+        "",
+        "// clang-format off",
+        "const uint16_t layout_tapping_term[MATRIX_ROWS][MATRIX_COLS] = {",
+        *c_table(terms),
+        "};",
+        "",
+        "const uint8_t layout_key_flags[MATRIX_ROWS][MATRIX_COLS] = {",
+        *c_table([[f"0x{flag:02X}" for flag in row] for row in flags]),
+        "};",
+        "",
+        "const uint64_t layout_active_keys[LAYOUT_LAYER_COUNT] = {",
+        *[f"    [{layer.name}] = 0x{active_mask(layer):014X}," for layer in spec["layers"]],
+        "};",
+        "// clang-format on",
+        "",
+    ]
+    return c_header("Layout Tables", "\n".join(lines))
+
+
+def render_keymap_h(spec: dict) -> str:
+    lines = [
+        "// Included once, from keymap.c: QMK's keymap introspection expects",
+        "// keymaps[] in that file",
+        "",
+        "// clang-format off",
+        "const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {",
+    ]
+    for index, layer in enumerate(spec["layers"]):
+        cells = [[""] * GRID_WIDTH for _ in ROW_GRID]
+        for grid_row, (keycodes, keys) in enumerate(zip(layer.keycodes, layout_keys())):
+            for keycode, key in zip(keycodes, keys):
+                cells[grid_row][key.grid_col] = keycode
+        widths = [max(len(row[col]) + 1 for row in cells) for col in range(GRID_WIDTH)]
+
+        lines += [f"    // Layer {index}: {layer.title}", f"    [{layer.name}] = {LAYOUT_MACRO}("]
+        for grid_row, columns in enumerate(ROW_GRID):
+            last = grid_row == len(ROW_GRID) - 1
+            text = ""
+            for grid_col in range(GRID_WIDTH):
+                keycode = cells[grid_row][grid_col]
+                if grid_col in columns:
+                    final = last and grid_col == columns[-1]
+                    keycode += "" if final else ","
+                text += keycode.ljust(widths[grid_col] + 1)
+            lines.append("        " + text.rstrip())
+        lines.append("    )," if index < len(spec["layers"]) - 1 else "    )")
+    lines += ["};", "// clang-format on", ""]
+    return f"/* Copyright 2024\n * Keymap\n *\n * {GENERATED_NOTE}\n */\n\n" + "\n".join(lines)
+
+
+# ============================================================================
+# Vial and Drawer Output
+# ============================================================================
+
+
+def key_position(key: Key) -> tuple[float, float]:
+    left = key.grid_col < GRID_WIDTH // 2
+    col = key.grid_col if left else GRID_WIDTH - 1 - key.grid_col
+    if key.grid_row == len(ROW_GRID) - 1:
+        # Thumbs fan out under the inner columns
+        x = col + 0.5 if left else GRID_WIDTH - 0.5 - col
+        return x, 3.5
+    x = float(col) if left else float(GRID_WIDTH - 1 - col) + 1
+    return x, key.grid_row + COLUMN_STAGGER[col]
+
+
+def kle_number(value: float) -> float | int:
+    return int(value) if value == int(value) else value
+
+
+def render_vial_json(spec: dict) -> str:
+    # One KLE row per key: x is absolute within a row, y is relative to the
+    # row below the previous one
+    rows = []
+    previous_y = -1.0
+    for keys in layout_keys():
+        for key in keys:
+            x, y = key_position(key)
+            props = {}
+            if x:
+                props["x"] = kle_number(x)
+            if y != previous_y + 1:
+                props["y"] = kle_number(y - (previous_y + 1))
+            rows.append(([props] if props else []) + [f"{key.row},{key.col}"])
+            previous_y = y
+
+    vial = spec["vial"]
+    definition = {
+        "name": vial["name"],
+        "vendorId": vial["vendor_id"],
+        "productId": vial["product_id"],
+        "matrix": {"rows": MATRIX_ROWS, "cols": MATRIX_COLS},
+        "layouts": {"keymap": rows},
+    }
+    # Same shape as before: indented objects, one KLE row per line
+    text = json.dumps(definition, indent=4, ensure_ascii=False)
+    text = re.sub(r"\[\s+((?:\{[^\[\]]*?\},\s+)?\"\d,\d\")\s+\]", lambda m: "[" + re.sub(r"\s+", " ", m.group(1)) + "]", text)
+    text = re.sub(r"\{\s+(\"[xy]\": [-\d.]+(?:,\s+\"y\": [-\d.]+)?)\s+\}", lambda m: "{" + re.sub(r"\s+", " ", m.group(1)) + "}", text)
+    return text + "\n"
+
+
+def mod_glyphs(mods: str) -> str:
+    return "".join(glyph for name, glyph in MOD_GLYPHS if name in mods)
+
+
+def render_drawer(spec: dict, current: str) -> str:
+    lines = [DRAWER_BEGIN, "    # Mod-taps: tap on top, hold below"]
+    seen = set()
+    for layer in spec["layers"]:
+        for keycodes in layer.keycodes:
+            for keycode in keycodes:
+                match = MOD_TAP_RE.match(keycode)
+                if not match or keycode in seen:
+                    continue
+                seen.add(keycode)
+                legend = match.group(2)[3:] + "\n" + mod_glyphs(match.group(1))
+                lines.append(f"    {json.dumps(keycode)}: {json.dumps(legend, ensure_ascii=False)}")
+    # No TD(n) legends: the images are drawn from the .vil exports, where
+    # TD(n) is Vial's tap_dance table, not tap_dance_actions[]
+    lines.append(DRAWER_END)
+
+    start = current.find(DRAWER_BEGIN)
+    end = current.find(DRAWER_END)
+    if start < 0 or end < start:
+        raise SpecError(f"{DRAWER_PATH.name}: generated block markers not found")
+    return current[:start] + "\n".join(lines) + current[end + len(DRAWER_END) :]
+
+
+# ============================================================================
+# Main
+# ============================================================================
+
+
+def outputs(spec: dict) -> dict[Path, str]:
+    return {
+        KEYMAP_DIR / "layout.gen.h": render_layout_h(spec),
+        KEYMAP_DIR / "layout.gen.c": render_layout_c(spec),
+        KEYMAP_DIR / "keymap.gen.h": render_keymap_h(spec),
+        KEYMAP_DIR / "vial.json": render_vial_json(spec),
+        DRAWER_PATH: render_drawer(spec, DRAWER_PATH.read_text(encoding="utf-8")),
+    }
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--spec", type=Path, default=SPEC_PATH, help="layout spec (default: %(default)s)")
+    parser.add_argument("--check", action="store_true", help="fail if a generated file is out of date")
+    return parser.parse_args()
+
+
+def main() -> int:
+    args = parse_args()
+    try:
+        generated = outputs(load_spec(args.spec))
+    except (SpecError, KeyError, OSError, yaml.YAMLError) as exc:
+        print(f"ERROR: {exc}", file=sys.stderr)
+        return 1
+
+    stale = [path for path, text in generated.items() if not path.exists() or path.read_text(encoding="utf-8") != text]
+    if args.check:
+        for path in stale:
+            print(f"STALE: {path.relative_to(REPO_DIR)}", file=sys.stderr)
+        if stale:
+            print("Run scripts/gen-layout.py and commit the result", file=sys.stderr)
+        return 1 if stale else 0
+
+    for path in stale:
+        path.write_text(generated[path], encoding="utf-8")
+        print(f"wrote {path.relative_to(REPO_DIR)}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,708 @@
+#!/usr/bin/env python3
+"""Read on-device diagnostics from the keyboard over Vial raw HID."""
+
+from __future__ import annotations
+
+import argparse
+import json
+import shlex
+import subprocess
+import sys
+from dataclasses import dataclass
+from pathlib import Path
+
+
+PACKET_SIZE = 32
+
+# Vial's raw HID interface (usage page 0xFF60, usage 0x61) in a report descriptor
+RAW_HID_USAGE = bytes((0x06, 0x60, 0xFF, 0x09, 0x61))
+
+# features/latency_stats.h
+STATS_COMMAND_ID = 0xF0
+STATS_OP_INFO = 0x00
+STATS_OP_READ = 0x01
+STATS_OP_RESET = 0x02
+STATS_VERSION = 1
+STATS_NAMES = (
+    "key latency",
+    "scan interval",
+    "process_record_user",
+    "bilateral engine",
+    "rgb indicators",
+    "wake latency",
+)
+STATS_UNITS = ("us", "ms")
+
+# features/trace_recorder.h
+RECORDER_COMMAND_ID = 0xF1
+RECORDER_OP_STATUS = 0x00
+RECORDER_OP_START = 0x01
+RECORDER_OP_STOP = 0x02
+RECORDER_OP_READ = 0x03
+RECORDER_VERSION = 1
+EVENT_TAPPED = 0x80
+EVENT_PRESSED = 0x40
+
+# features/keymap_batch.h
+BATCH_COMMAND_ID = 0xF2
+BATCH_OP_INFO = 0x00
+BATCH_OP_STAGE = 0x01
+BATCH_OP_COMMIT = 0x02
+BATCH_OP_DISCARD = 0x03
+BATCH_VERSION = 1
+BATCH_STAGE_HEADER = 5
+
+# features/power_mode.h
+POWER_COMMAND_ID = 0xF3
+POWER_OP_STATUS = 0x00
+POWER_OP_RESET = 0x01
+POWER_VERSION = 1
+
+# VIA's own commands
+VIA_GET_KEYCODE = 0x04
+
+# Keycode names found in .vil files (old and new QMK spellings) -> values
+# of QMK's keycode table, which Vial's protocol 6 speaks
+NAMED_KEYCODES = (
+    (0x0000, "KC_NO", "XXXXXXX"),
+    (0x0001, "KC_TRNS", "KC_TRANSPARENT", "_______"),
+    (0x0028, "KC_ENTER", "KC_ENT"),
+    (0x0029, "KC_ESCAPE", "KC_ESC"),
+    (0x002A, "KC_BSPACE", "KC_BACKSPACE", "KC_BSPC"),
+    (0x002B, "KC_TAB"),
+    (0x002C, "KC_SPACE", "KC_SPC"),
+    (0x002D, "KC_MINUS", "KC_MINS"),
+    (0x002E, "KC_EQUAL", "KC_EQL"),
+    (0x002F, "KC_LBRACKET", "KC_LEFT_BRACKET", "KC_LBRC"),
+    (0x0030, "KC_RBRACKET", "KC_RIGHT_BRACKET", "KC_RBRC"),
+    (0x0031, "KC_BSLASH", "KC_BACKSLASH", "KC_BSLS"),
+    (0x0033, "KC_SCOLON", "KC_SEMICOLON", "KC_SCLN"),
+    (0x0034, "KC_QUOTE", "KC_QUOT"),
+    (0x0035, "KC_GRAVE", "KC_GRV"),
+    (0x0036, "KC_COMMA", "KC_COMM"),
+    (0x0037, "KC_DOT"),
+    (0x0038, "KC_SLASH", "KC_SLSH"),
+    (0x0039, "KC_CAPSLOCK", "KC_CAPS_LOCK", "KC_CAPS"),
+    (0x0046, "KC_PSCREEN", "KC_PRINT_SCREEN", "KC_PSCR"),
+    (0x0047, "KC_SCROLLLOCK", "KC_SCROLL_LOCK", "KC_SCRL"),
+    (0x0048, "KC_PAUSE", "KC_PAUS"),
+    (0x0049, "KC_INSERT", "KC_INS"),
+    (0x004A, "KC_HOME"),
+    (0x004B, "KC_PGUP", "KC_PAGE_UP"),
+    (0x004C, "KC_DELETE", "KC_DEL"),
+    (0x004D, "KC_END"),
+    (0x004E, "KC_PGDOWN", "KC_PAGE_DOWN", "KC_PGDN"),
+    (0x004F, "KC_RIGHT", "KC_RGHT"),
+    (0x0050, "KC_LEFT"),
+    (0x0051, "KC_DOWN"),
+    (0x0052, "KC_UP"),
+    (0x0056, "KC_KP_MINUS", "KC_PMNS"),
+    (0x0057, "KC_KP_PLUS", "KC_PPLS"),
+    (0x00A8, "KC_MUTE", "KC_AUDIO_MUTE"),
+    (0x00A9, "KC_VOLU", "KC_AUDIO_VOL_UP"),
+    (0x00AA, "KC_VOLD", "KC_AUDIO_VOL_DOWN"),
+    (0x00BD, "KC_BRIU", "KC_BRIGHTNESS_UP"),
+    (0x00BE, "KC_BRID", "KC_BRIGHTNESS_DOWN"),
+    (0x00E0, "KC_LCTRL", "KC_LCTL", "KC_LEFT_CTRL"),
+    (0x00E1, "KC_LSHIFT", "KC_LSFT", "KC_LEFT_SHIFT"),
+    (0x00E2, "KC_LALT", "KC_LEFT_ALT"),
+    (0x00E3, "KC_LGUI", "KC_LEFT_GUI"),
+    (0x00E4, "KC_RCTRL", "KC_RCTL", "KC_RIGHT_CTRL"),
+    (0x00E5, "KC_RSHIFT", "KC_RSFT", "KC_RIGHT_SHIFT"),
+    (0x00E6, "KC_RALT", "KC_RIGHT_ALT"),
+    (0x00E7, "KC_RGUI", "KC_RIGHT_GUI"),
+    (0x7820, "RGB_TOG"),
+    (0x7821, "RGB_MOD"),
+    (0x7822, "RGB_RMOD"),
+    (0x7823, "RGB_HUI"),
+    (0x7824, "RGB_HUD"),
+    (0x7825, "RGB_SAI"),
+    (0x7826, "RGB_SAD"),
+    (0x7827, "RGB_VAI"),
+    (0x7828, "RGB_VAD"),
+    (0x7C00, "RESET", "QK_BOOT"),
+    (0x7C16, "KC_GESC", "QK_GESC"),
+    (0x7C19, "KC_RCPC", "SC_RCPC"),
+    (0x7C1A, "KC_LSPO", "SC_LSPO"),
+    (0x7C1E, "KC_SFTENT", "SC_SENT"),
+    (0x7C53, "DYN_REC_START1"),
+    (0x7C54, "DYN_REC_START2"),
+    (0x7C55, "DYN_REC_STOP"),
+    (0x7C56, "DYN_MACRO_PLAY1"),
+    (0x7C57, "DYN_MACRO_PLAY2"),
+    (0x7C77, "FN_MO13", "TL_LOWR"),
+    (0x7C78, "FN_MO23", "TL_UPPR"),
+)
+MOD_BITS = {"CTL": 0x01, "SFT": 0x02, "ALT": 0x04, "GUI": 0x08}
+LAYER_KEYCODES = {"TO": 0x5200, "MO": 0x5220, "TG": 0x5260, "TD": 0x5700}
+QK_MODS_TAP = 0x2000
+QK_LAYER_TAP = 0x4000
+QK_MACRO = 0x7700
+
+UNHANDLED = 0xFF
+
+
+class HidError(Exception):
+    pass
+
+
+# ============================================================================
+# Transports
+# ============================================================================
+
+
+class HidrawTransport:
+    """A keyboard on /dev/hidrawN (Linux)."""
+
+    def __init__(self, path: Path) -> None:
+        self.path = path
+        self.fd = path.open("r+b", buffering=0)
+
+    def request(self, packet: bytes) -> bytes:
+        # No report IDs: hidraw wants a leading zero byte on writes
+        self.fd.write(b"\x00" + packet)
+        return self.fd.read(PACKET_SIZE)
+
+    def close(self) -> None:
+        self.fd.close()
+
+
+class SimTransport:
+    """tools/hrmods-sim --hid: one hex line per packet on stdin/stdout."""
+
+    def __init__(self, command: str) -> None:
+        self.proc = subprocess.Popen(
+            shlex.split(command),
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            text=True,
+        )
+
+    def request(self, packet: bytes) -> bytes:
+        assert self.proc.stdin and self.proc.stdout
+        self.proc.stdin.write(packet.hex() + "\n")
+        self.proc.stdin.flush()
+        line = self.proc.stdout.readline()
+        if not line:
+            raise HidError(f"simulator exited with status {self.proc.wait()}")
+        return bytes.fromhex(line.strip())
+
+    def close(self) -> None:
+        assert self.proc.stdin
+        self.proc.stdin.close()
+        self.proc.wait()
+
+
+def find_hidraw() -> Path:
+    for node in sorted(Path("/sys/class/hidraw").glob("hidraw*")):
+        descriptor = node / "device" / "report_descriptor"
+        try:
+            if RAW_HID_USAGE in descriptor.read_bytes():
+                return Path("/dev") / node.name
+        except OSError:
+            continue
+    raise HidError("no Vial raw HID interface found (is the keyboard plugged in?)")
+
+
+def open_transport(args: argparse.Namespace) -> HidrawTransport | SimTransport:
+    if args.sim:
+        return SimTransport(args.sim)
+    return HidrawTransport(Path(args.device) if args.device else find_hidraw())
+
+
+def command(transport: HidrawTransport | SimTransport, *payload: int) -> bytes:
+    packet = bytes(payload).ljust(PACKET_SIZE, b"\x00")
+    reply = transport.request(packet)
+    if len(reply) < PACKET_SIZE or reply[0] == UNHANDLED:
+        raise HidError(f"command {packet[:4].hex()} not handled (firmware built without it?)")
+    return reply
+
+
+# ============================================================================
+# Latency Histograms
+# ============================================================================
+
+
+@dataclass
+class Histogram:
+    name: str
+    unit: str
+    counts: list[int]
+
+    @staticmethod
+    def bucket_range(bucket: int) -> tuple[int, int | None]:
+        """Inclusive lower bound and exclusive upper bound (None = open)."""
+        if bucket == 0:
+            return (0, 1)
+        return (1 << (bucket - 1), 1 << bucket)
+
+    def total(self) -> int:
+        return sum(self.counts)
+
+    def percentile(self, fraction: float) -> str:
+        """Upper bound of the bucket holding the given fraction of samples."""
+        total = self.total()
+        if not total:
+            return "-"
+        seen = 0
+        for bucket, count in enumerate(self.counts):
+            seen += count
+            if seen >= fraction * total:
+                low, high = self.bucket_range(bucket)
+                if bucket == len(self.counts) - 1:
+                    return f">={low}{self.unit}"
+                return f"<{high}{self.unit}"
+        return "-"
+
+
+def read_stats(transport: HidrawTransport | SimTransport) -> list[Histogram]:
+    info = command(transport, STATS_COMMAND_ID, STATS_OP_INFO)
+    version, stat_count, buckets = info[2], info[3], info[4]
+    if version != STATS_VERSION:
+        raise HidError(f"unsupported latency stats version {version}")
+
+    histograms = []
+    for stat in range(stat_count):
+        counts: list[int] = []
+        while len(counts) < buckets:
+            reply = command(transport, STATS_COMMAND_ID, STATS_OP_READ, stat, len(counts))
+            n = reply[4]
+            if not n:
+                raise HidError("empty histogram page")
+            for i in range(n):
+                counts.append(int.from_bytes(reply[5 + 4 * i : 9 + 4 * i], "little"))
+        name = STATS_NAMES[stat] if stat < len(STATS_NAMES) else f"stat {stat}"
+        unit = STATS_UNITS[info[5 + stat]] if info[5 + stat] < len(STATS_UNITS) else "?"
+        histograms.append(Histogram(name, unit, counts))
+    return histograms
+
+
+def print_histogram(hist: Histogram) -> None:
+    total = hist.total()
+    print(f"{hist.name} ({total} samples, p50 {hist.percentile(0.5)}, p95 {hist.percentile(0.95)})")
+    if not total:
+        return
+
+    peak = max(hist.counts)
+    last = max(i for i, count in enumerate(hist.counts) if count)
+    for bucket in range(last + 1):
+        low, high = hist.bucket_range(bucket)
+        label = f">={low}" if bucket == len(hist.counts) - 1 else f"{low}-{high - 1}" if high - low > 1 else f"{low}"
+        bar = "#" * round(40 * hist.counts[bucket] / peak)
+        print(f"  {label:>13} {hist.unit}  {hist.counts[bucket]:>8}  {bar}")
+
+
+def cmd_stats(transport: HidrawTransport | SimTransport, args: argparse.Namespace) -> int:
+    histograms = read_stats(transport)
+    if args.json:
+        print(json.dumps([hist.__dict__ for hist in histograms], indent=2))
+    else:
+        for hist in histograms:
+            print_histogram(hist)
+            print()
+    if args.reset:
+        command(transport, STATS_COMMAND_ID, STATS_OP_RESET)
+    return 0
+
+
+def cmd_reset(transport: HidrawTransport | SimTransport, args: argparse.Namespace) -> int:
+    command(transport, STATS_COMMAND_ID, STATS_OP_RESET)
+    print("Latency histograms cleared")
+    return 0
+
+
+# ============================================================================
+# Trace Recorder
+# ============================================================================
+
+
+@dataclass
+class TraceEvent:
+    time: int
+    row: int
+    col: int
+    pressed: bool
+    tapped: bool
+
+
+@dataclass
+class RecorderStatus:
+    recording: bool
+    used: int
+    size: int
+    dropped: int
+
+
+def recorder_status(transport: HidrawTransport | SimTransport) -> RecorderStatus:
+    reply = command(transport, RECORDER_COMMAND_ID, RECORDER_OP_STATUS)
+    if reply[2] != RECORDER_VERSION:
+        raise HidError(f"unsupported trace recorder version {reply[2]}")
+    return RecorderStatus(
+        recording=bool(reply[3]),
+        used=int.from_bytes(reply[4:6], "little"),
+        size=int.from_bytes(reply[6:8], "little"),
+        dropped=int.from_bytes(reply[8:10], "little"),
+    )
+
+
+def drain_recorder(transport: HidrawTransport | SimTransport) -> bytes:
+    stream = bytearray()
+    while True:
+        reply = command(transport, RECORDER_COMMAND_ID, RECORDER_OP_READ)
+        n = reply[2]
+        if not n:
+            return bytes(stream)
+        stream += reply[3 : 3 + n]
+
+
+def decode_events(stream: bytes) -> list[TraceEvent]:
+    """Zigzag varint deltas + key bytes -> events in physical order."""
+    events = []
+    time = 0
+    pos = 0
+    while pos < len(stream):
+        value = 0
+        shift = 0
+        while True:
+            if pos >= len(stream):
+                raise HidError("trace stream ends inside an event")
+            byte = stream[pos]
+            pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        if pos >= len(stream):
+            raise HidError("trace stream ends inside an event")
+        key = stream[pos]
+        pos += 1
+
+        time += (value >> 1) ^ -(value & 1)
+        events.append(
+            TraceEvent(
+                time=time,
+                row=(key >> 3) & 0x07,
+                col=key & 0x07,
+                pressed=bool(key & EVENT_PRESSED),
+                tapped=bool(key & EVENT_TAPPED),
+            )
+        )
+
+    # Tap-hold keys are recorded when they settle; sort back by scan time
+    events.sort(key=lambda event: event.time)
+    return events
+
+
+def format_trace(events: list[TraceEvent], source: str) -> str:
+    """hrmods-sim trace format, starting at 0 ms."""
+    lines = [f"# Recorded on the keyboard ({source}), {len(events)} events", ""]
+    start = events[0].time if events else 0
+    for event in events:
+        edge = "down" if event.pressed else "up"
+        line = f"{event.time - start:<6} {edge:<4} {event.row},{event.col}"
+        if event.pressed and event.tapped:
+            line += "  # tap"
+        lines.append(line)
+    return "\n".join(lines) + "\n"
+
+
+def write_output(text: str, path: str | None) -> None:
+    if path:
+        Path(path).write_text(text)
+    else:
+        sys.stdout.write(text)
+
+
+def cmd_trace_status(transport: HidrawTransport | SimTransport, args: argparse.Namespace) -> int:
+    status = recorder_status(transport)
+    state = "recording" if status.recording else "stopped"
+    print(f"Trace recorder {state}: {status.used}/{status.size} bytes, {status.dropped} events dropped")
+    return 0
+
+
+def cmd_trace_start(transport: HidrawTransport | SimTransport, args: argparse.Namespace) -> int:
+    command(transport, RECORDER_COMMAND_ID, RECORDER_OP_START)
+    print("Trace recorder started")
+    return 0
+
+
+def cmd_trace_stop(transport: HidrawTransport | SimTransport, args: argparse.Namespace) -> int:
+    command(transport, RECORDER_COMMAND_ID, RECORDER_OP_STOP)
+    print("Trace recorder stopped")
+    return 0
+
+
+def cmd_trace_dump(transport: HidrawTransport | SimTransport, args: argparse.Namespace) -> int:
+    if args.stop:
+        command(transport, RECORDER_COMMAND_ID, RECORDER_OP_STOP)
+    status = recorder_status(transport)
+    if status.dropped:
+        print(f"WARNING: buffer overflowed, oldest {status.dropped} events were lost", file=sys.stderr)
+
+    stream = drain_recorder(transport)
+    if args.raw:
+        Path(args.raw).write_bytes(stream)
+    write_output(format_trace(decode_events(stream), "hrmods-hid.py trace dump"), args.output)
+    return 0
+
+
+def cmd_trace_convert(args: argparse.Namespace) -> int:
+    stream = Path(args.input).read_bytes()
+    write_output(format_trace(decode_events(stream), Path(args.input).name), args.output)
+    return 0
+
+
+# ============================================================================
+# Keymap Upload
+# ============================================================================
+
+
+def basic_keycodes() -> dict[str, int]:
+    names = {f"KC_{chr(ord('A') + i)}": 0x04 + i for i in range(26)}
+    names.update({f"KC_{(i + 1) % 10}": 0x1E + i for i in range(10)})
+    names.update({f"KC_F{i + 1}": 0x3A + i for i in range(12)})
+    names.update({f"M{i}": QK_MACRO + i for i in range(16)})
+    for value, *aliases in NAMED_KEYCODES:
+        names.update(dict.fromkeys(aliases, value))
+    return names
+
+
+BASIC_KEYCODES = basic_keycodes()
+
+
+def mod_bits(name: str) -> int:
+    """MOD_LSFT / LSFT and friends -> the 5-bit QMK mod mask."""
+    name = name.removeprefix("MOD_")
+    if len(name) != 4 or name[0] not in "LR" or name[1:] not in MOD_BITS:
+        raise HidError(f"unknown modifier '{name}'")
+    return MOD_BITS[name[1:]] | (0x10 if name[0] == "R" else 0)
+
+
+def keycode_value(name: str) -> int:
+    """A .vil keycode name like "MT(MOD_LSFT,KC_T)" -> its 16 bit value."""
+    name = name.replace(" ", "")
+    if name in BASIC_KEYCODES:
+        return BASIC_KEYCODES[name]
+    if name.startswith("0x"):
+        return int(name, 16)
+    func, paren, rest = name.partition("(")
+    if not paren or not rest.endswith(")"):
+        raise HidError(f"unknown keycode '{name}'")
+    args = rest[:-1]
+    if func == "MT":
+        mods, _, key = args.partition(",")
+        mask = 0
+        for mod in mods.split("|"):
+            mask |= mod_bits(mod)
+        return QK_MODS_TAP | mask << 8 | keycode_value(key) & 0xFF
+    if func == "LT":
+        layer, _, key = args.partition(",")
+        return QK_LAYER_TAP | (int(layer) & 0x0F) << 8 | keycode_value(key) & 0xFF
+    if func in LAYER_KEYCODES:
+        return LAYER_KEYCODES[func] | int(args) & (0xFF if func == "TD" else 0x1F)
+    # LSFT(kc), RALT(kc), ...: nested wrappers add up their mod bits
+    return mod_bits(func) << 8 | keycode_value(args)
+
+
+def vil_layers(path: Path) -> list[list[int | None]]:
+    """Flattened layers of a .vil file; None where the layout has no key."""
+    layers = []
+    for layer in json.loads(path.read_text())["layout"]:
+        keys: list[int | None] = []
+        for row in layer:
+            keys += [None if key == -1 else keycode_value(str(key)) for key in row]
+        layers.append(keys)
+    return layers
+
+
+def stage_layer(transport: HidrawTransport | SimTransport, layer: int, keys: list[int | None], per_packet: int) -> int:
+    """Stage the keys of one layer in runs of present keys; returns how many."""
+    staged = 0
+    first = 0
+    while first < len(keys):
+        if keys[first] is None:
+            first += 1
+            continue
+        run = []
+        while first + len(run) < len(keys) and keys[first + len(run)] is not None and len(run) < per_packet:
+            run.append(keys[first + len(run)])
+        payload = b"".join(keycode.to_bytes(2, "little") for keycode in run)
+        command(transport, BATCH_COMMAND_ID, BATCH_OP_STAGE, layer, first, len(run), *payload)
+        staged += len(run)
+        first += len(run)
+    return staged
+
+
+def verify_layer(transport: HidrawTransport | SimTransport, layer: int, keys: list[int | None], cols: int) -> int:
+    """Read a layer back key by key; returns how many keys differ."""
+    mismatches = 0
+    for index, keycode in enumerate(keys):
+        if keycode is None:
+            continue
+        reply = command(transport, VIA_GET_KEYCODE, layer, index // cols, index % cols)
+        stored = int.from_bytes(reply[4:6], "big")
+        if stored != keycode:
+            position = f"{index // cols},{index % cols}"
+            print(f"layer {layer} key {position}: 0x{stored:04x}, expected 0x{keycode:04x}", file=sys.stderr)
+            mismatches += 1
+    return mismatches
+
+
+def cmd_keymap_load(transport: HidrawTransport | SimTransport, args: argparse.Namespace) -> int:
+    info = command(transport, BATCH_COMMAND_ID, BATCH_OP_INFO)
+    version, layer_count, rows, cols, per_packet = info[2:7]
+    if version != BATCH_VERSION:
+        raise HidError(f"unsupported keymap batch version {version}")
+
+    layers = vil_layers(Path(args.vil))
+    for layer, keys in enumerate(layers):
+        if len(keys) != rows * cols:
+            raise HidError(f"layer {layer} has {len(keys)} keys, the keyboard has {rows}x{cols}")
+    # Vial exports every layer it knows about; only warn about ones in use
+    extra = [
+        layer
+        for layer, keys in enumerate(layers[layer_count:], layer_count)
+        if any(key not in (None, 0x0000, 0x0001) for key in keys)
+    ]
+    if extra:
+        print(f"WARNING: the keyboard has {layer_count} layers, skipping layers {extra}", file=sys.stderr)
+    layers = layers[:layer_count]
+
+    try:
+        staged = sum(stage_layer(transport, layer, keys, per_packet) for layer, keys in enumerate(layers))
+    except HidError:
+        command(transport, BATCH_COMMAND_ID, BATCH_OP_DISCARD)
+        raise
+    reply = command(transport, BATCH_COMMAND_ID, BATCH_OP_COMMIT)
+    print(f"Staged {staged} keys on {len(layers)} layers, {int.from_bytes(reply[2:4], 'little')} changed")
+
+    if args.verify:
+        mismatches = sum(verify_layer(transport, layer, keys, cols) for layer, keys in enumerate(layers))
+        if mismatches:
+            raise HidError(f"{mismatches} keys read back wrong")
+        print("Keymap verified")
+    return 0
+
+
+# ============================================================================
+# Power Mode
+# ============================================================================
+
+
+@dataclass
+class PowerStatus:
+    state: int
+    wakes: int
+    state_ms: list[int]
+
+
+def power_status(transport: HidrawTransport | SimTransport) -> PowerStatus:
+    reply = command(transport, POWER_COMMAND_ID, POWER_OP_STATUS)
+    version, state, count = reply[2], reply[3], reply[4]
+    if version != POWER_VERSION:
+        raise HidError(f"unsupported power mode version {version}")
+    state_ms = [int.from_bytes(reply[9 + 4 * i : 13 + 4 * i], "little") for i in range(count)]
+    return PowerStatus(state, int.from_bytes(reply[5:9], "little"), state_ms)
+
+
+def power_state_name(state: int) -> str:
+    return "full rate" if state == 0 else f"idle step {state}"
+
+
+def cmd_power(transport: HidrawTransport | SimTransport, args: argparse.Namespace) -> int:
+    status = power_status(transport)
+    if args.json:
+        print(json.dumps(status.__dict__, indent=2))
+    else:
+        total = sum(status.state_ms) or 1
+        print(f"Power mode: {power_state_name(status.state)}, {status.wakes} wake-ups from idle")
+        for state, ms in enumerate(status.state_ms):
+            print(f"  {power_state_name(state):>12}  {ms / 1000:>10.1f} s  {100 * ms / total:5.1f}%")
+        print("Wake-up latency: see the 'wake latency' histogram of the stats command")
+    if args.reset:
+        command(transport, POWER_COMMAND_ID, POWER_OP_RESET)
+    return 0
+
+
+# ============================================================================
+# CLI
+# ============================================================================
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Read on-device diagnostics over Vial raw HID")
+    target = parser.add_mutually_exclusive_group()
+    target.add_argument("--device", help="hidraw node (default: first Vial raw HID interface)")
+    target.add_argument(
+        "--sim",
+        metavar="COMMAND",
+        help="talk to a simulator endpoint instead, e.g. 'tools/hrmods-sim/build/hrmods-sim --hid trace'",
+    )
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    stats = sub.add_parser("stats", help="print latency and scan-rate histograms")
+    stats.add_argument("--json", action="store_true", help="machine-readable output")
+    stats.add_argument("--reset", action="store_true", help="clear the histograms after reading")
+    stats.set_defaults(func=cmd_stats)
+
+    reset = sub.add_parser("reset", help="clear latency and scan-rate histograms")
+    reset.set_defaults(func=cmd_reset)
+
+    trace = sub.add_parser("trace", help="record typing on the keyboard for tools/hrmods-sim")
+    trace_sub = trace.add_subparsers(dest="trace_command", required=True)
+    trace_sub.add_parser("status", help="show recorder state and buffer use").set_defaults(func=cmd_trace_status)
+    trace_sub.add_parser("start", help="clear the buffer and start recording").set_defaults(func=cmd_trace_start)
+    trace_sub.add_parser("stop", help="stop recording, keep the buffer").set_defaults(func=cmd_trace_stop)
+
+    dump = trace_sub.add_parser("dump", help="drain the buffer and print an hrmods-sim trace")
+    dump.add_argument("-o", "--output", help="write the trace here instead of stdout")
+    dump.add_argument("--raw", metavar="FILE", help="also save the undecoded stream")
+    dump.add_argument("--stop", action="store_true", help="stop recording first")
+    dump.set_defaults(func=cmd_trace_dump)
+
+    convert = trace_sub.add_parser("convert", help="turn a stream saved with --raw into a trace (offline)")
+    convert.add_argument("input", help="raw stream file")
+    convert.add_argument("-o", "--output", help="write the trace here instead of stdout")
+    convert.set_defaults(func=cmd_trace_convert, offline=True)
+
+    keymap = sub.add_parser("keymap", help="write the dynamic keymap in batches")
+    keymap_sub = keymap.add_subparsers(dest="keymap_command", required=True)
+    load = keymap_sub.add_parser("load", help="upload a .vil layout and commit it in one go")
+    load.add_argument("vil", help="Vial layout file, e.g. firmware/corne_v4-1_custom_hrmods.vil")
+    load.add_argument("--verify", action="store_true", help="read every key back afterwards")
+    load.set_defaults(func=cmd_keymap_load)
+
+    power = sub.add_parser("power", help="time spent in each idle power state")
+    power.add_argument("--json", action="store_true", help="machine-readable output")
+    power.add_argument("--reset", action="store_true", help="clear the counters after reading")
+    power.set_defaults(func=cmd_power)
+
+    return parser.parse_args()
+
+
+def main() -> int:
+    args = parse_args()
+    if getattr(args, "offline", False):
+        try:
+            return args.func(args)
+        except (HidError, OSError) as exc:
+            print(f"ERROR: {exc}", file=sys.stderr)
+            return 1
+
+    try:
+        transport = open_transport(args)
+    except (HidError, OSError) as exc:
+        print(f"ERROR: {exc}", file=sys.stderr)
+        return 1
+
+    try:
+        return args.func(transport, args)
+    except (HidError, OSError) as exc:
+        print(f"ERROR: {exc}", file=sys.stderr)
+        return 1
+    finally:
+        transport.close()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,315 @@
+#!/usr/bin/env python3
+"""Render layout images from vil2json keymaps, re-drawing only the layers that changed.
+
+Every layer is drawn on its own with keymap-drawer and kept in a cache keyed
+by a hash of what it shows: its bindings, the raw_binding_map entries they
+use, the keys on other layers that activate it (drawn as held), the rest of
+the keymap-drawer config and the keymap-drawer install itself. The images in
+--out-dir are assembled from the cached layers, and PDF/PNG copies are
+redrawn only when the assembled SVG changed. Parsing, drawing and conversion
+run in parallel across all keymaps.
+"""
+
+from __future__ import annotations
+
+import argparse
+import hashlib
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import xml.etree.ElementTree as ET
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import dataclass, field
+from pathlib import Path
+
+import yaml
+
+
+REPO_DIR = Path(__file__).resolve().parent.parent
+DRAWER_PATH = REPO_DIR / "keymap-drawer.yaml"
+
+# Bump when the fragment layout or assembly changes, to drop old cache entries
+CACHE_FORMAT = 1
+
+# Keycodes that switch to layer N; keymap-drawer marks their position held on layer N
+LAYER_REF_RE = re.compile(r"\b(?:MO|LT|TG|TT|OSL|LM|TO|DF)\((\d+)")
+
+SVG_NS = "http://www.w3.org/2000/svg"
+ET.register_namespace("", SVG_NS)
+ET.register_namespace("xlink", "http://www.w3.org/1999/xlink")
+
+
+class RenderError(Exception):
+    pass
+
+
+@dataclass(eq=False)
+class Keymap:
+    json_path: Path
+    svg_path: Path
+    data: dict  # As written by vil2json
+    digests: list[str] = field(default_factory=list)
+    yaml_path: Path | None = None
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("keymaps", nargs="+", type=Path, help="keymap.json files written by vil2json")
+    parser.add_argument("--config", type=Path, default=DRAWER_PATH, help="keymap-drawer config (default: %(default)s)")
+    parser.add_argument("--out-dir", type=Path, default=Path("images/generated"), help="where <name>.svg/.pdf/.png go")
+    parser.add_argument("--cache-dir", type=Path, default=Path(".cache/layout-images"), help="layer fragment cache")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 1, help="parallel keymap-drawer runs")
+    parser.add_argument("--no-pdf", action="store_true", help="skip the rsvg-convert PDF copy")
+    parser.add_argument("--no-png", action="store_true", help="skip the ImageMagick PNG copy")
+    return parser.parse_args()
+
+
+def run(cmd: list[str | Path]) -> None:
+    result = subprocess.run([str(part) for part in cmd], capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RenderError(f"{' '.join(map(str, cmd))}: {result.stderr.strip() or result.returncode}")
+
+
+def write_if_changed(path: Path, data: bytes) -> bool:
+    if path.exists() and path.read_bytes() == data:
+        return False
+    tmp = path.with_name(path.name + ".tmp")
+    tmp.write_bytes(data)
+    tmp.replace(path)
+    return True
+
+
+def drawer_identity() -> str:
+    # Nix store paths change with the keymap-drawer version
+    keymap = shutil.which("keymap")
+    if keymap is None:
+        raise RenderError("keymap-drawer ('keymap') not found; run inside 'nix develop'")
+    return os.path.realpath(keymap)
+
+
+def config_parts(config_path: Path) -> tuple[dict[str, str], str]:
+    """Split the config into raw_binding_map and a digest of everything else."""
+    config = yaml.safe_load(config_path.read_text(encoding="utf-8")) or {}
+    raw_map = config.get("parse_config", {}).pop("raw_binding_map", None) or {}
+    rest = json.dumps(config, sort_keys=True, ensure_ascii=False)
+    return raw_map, hashlib.sha256(rest.encode("utf-8")).hexdigest()
+
+
+def layer_digest(keymap: dict, index: int, raw_map: dict[str, str], base: str) -> str:
+    layers = keymap["layers"]
+    bindings = layers[index]
+    used = {code for code in raw_map if any(code == key or code in key for key in bindings)}
+    activators = [
+        [other, pos]
+        for other, layer in enumerate(layers)
+        if other != index
+        for pos, key in enumerate(layer)
+        if any(int(target) == index for target in LAYER_REF_RE.findall(key))
+    ]
+    payload = {
+        "base": base,
+        "keyboard": keymap.get("keyboard"),
+        "layout": keymap.get("layout"),
+        "index": index,
+        "bindings": bindings,
+        "raw_binding_map": {code: raw_map[code] for code in sorted(used)},
+        "activators": activators,
+    }
+    text = json.dumps(payload, sort_keys=True, ensure_ascii=False)
+    return hashlib.sha256(text.encode("utf-8")).hexdigest()[:32]
+
+
+def fragment_path(cache_dir: Path, digest: str) -> Path:
+    return cache_dir / "layers" / f"{digest}.svg"
+
+
+def manifest_path(cache_dir: Path, keymap: Keymap) -> Path:
+    return cache_dir / f"{keymap.svg_path.stem}.layers"
+
+
+def manifest_text(keymap: Keymap) -> str:
+    svg_hash = hashlib.sha256(keymap.svg_path.read_bytes()).hexdigest()
+    return "\n".join([svg_hash, *keymap.digests]) + "\n"
+
+
+def is_current(cache_dir: Path, keymap: Keymap) -> bool:
+    manifest = manifest_path(cache_dir, keymap)
+    if not manifest.exists() or not keymap.svg_path.exists():
+        return False
+    return manifest.read_text(encoding="utf-8") == manifest_text(keymap)
+
+
+def parse_keymap(config: Path, cache_dir: Path, keymap: Keymap) -> None:
+    keymap.yaml_path = cache_dir / "parsed" / f"{keymap.svg_path.stem}.yaml"
+    run(["keymap", "-c", config, "parse", "-q", keymap.json_path, "-o", keymap.yaml_path])
+
+
+def draw_layer(config: Path, cache_dir: Path, yaml_path: Path, index: int, digest: str) -> None:
+    target = fragment_path(cache_dir, digest)
+    with tempfile.NamedTemporaryFile(dir=target.parent, suffix=".svg", delete=False) as tmp:
+        tmp_path = Path(tmp.name)
+    try:
+        # NOTE: -c must come BEFORE the draw subcommand
+        run(["keymap", "-c", config, "draw", yaml_path, "-s", f"L{index}", "-o", tmp_path])
+        if tmp_path.stat().st_size == 0:
+            raise RenderError(f"keymap-drawer drew an empty SVG for layer L{index} of {yaml_path.name}")
+        tmp_path.replace(target)
+    finally:
+        tmp_path.unlink(missing_ok=True)
+
+
+def svg_length(value: str | None) -> float:
+    return float(re.sub(r"[a-z%]+$", "", value or "0"))
+
+
+def assemble(cache_dir: Path, keymap: Keymap) -> bytes:
+    """Stack the cached layer drawings top to bottom into one SVG."""
+    width = height = 0.0
+    shared: list[ET.Element] = []
+    seen_shared: set[bytes] = set()
+    groups: list[ET.Element] = []
+
+    for digest in keymap.digests:
+        root = ET.parse(fragment_path(cache_dir, digest)).getroot()
+        frag_w = svg_length(root.get("width"))
+        frag_h = svg_length(root.get("height"))
+
+        group = ET.Element(f"{{{SVG_NS}}}g", {"transform": f"translate(0, {height:g})"})
+        for child in root:
+            # Style and defs are the same in every layer drawn with one config
+            if child.tag in (f"{{{SVG_NS}}}style", f"{{{SVG_NS}}}defs"):
+                text = ET.tostring(child)
+                if text not in seen_shared:
+                    seen_shared.add(text)
+                    shared.append(child)
+            else:
+                group.append(child)
+        groups.append(group)
+        width = max(width, frag_w)
+        height += frag_h
+
+    svg = ET.Element(
+        f"{{{SVG_NS}}}svg",
+        {"width": f"{width:g}", "height": f"{height:g}", "viewBox": f"0 0 {width:g} {height:g}", "class": "keymap"},
+    )
+    svg.extend(shared)
+    svg.extend(groups)
+    return ET.tostring(svg, encoding="utf-8", xml_declaration=False) + b"\n"
+
+
+def convert_copy(cmd: list[str | Path], target: Path, note: str) -> str:
+    """PDF/PNG copies are extras: a failed conversion warns, the SVG still counts."""
+    try:
+        run(cmd)
+    except RenderError as exc:
+        # Drop a partial file so the next run tries again
+        target.unlink(missing_ok=True)
+        print(f"⚠ {target}: {note.upper()} conversion failed, continuing: {exc}", file=sys.stderr)
+        return f"{note} failed"
+    return note
+
+
+def convert_copies(svg_path: Path, pdf: bool, png: bool) -> list[str]:
+    notes = []
+    if pdf and shutil.which("rsvg-convert"):
+        pdf_path = svg_path.with_suffix(".pdf")
+        notes.append(convert_copy(["rsvg-convert", "-f", "pdf", "-o", pdf_path, svg_path], pdf_path, "pdf"))
+    if png and shutil.which("convert"):
+        png_path = svg_path.with_suffix(".png")
+        notes.append(convert_copy(["convert", svg_path, png_path], png_path, "png"))
+    return notes
+
+
+def load_keymaps(paths: list[Path], out_dir: Path) -> list[Keymap]:
+    keymaps = []
+    for path in paths:
+        data = json.loads(path.read_text(encoding="utf-8"))
+        if not isinstance(data.get("layers"), list):
+            raise RenderError(f"{path}: no layers")
+        keymaps.append(Keymap(path, out_dir / f"{path.stem}.svg", data))
+    return keymaps
+
+
+def main() -> int:
+    args = parse_args()
+    jobs = max(1, args.jobs)
+
+    try:
+        raw_map, config_digest = config_parts(args.config)
+        base = f"{CACHE_FORMAT}\0{drawer_identity()}\0{config_digest}"
+        keymaps = load_keymaps(args.keymaps, args.out_dir)
+    except (RenderError, OSError, KeyError, ValueError, yaml.YAMLError) as exc:
+        print(f"ERROR: {exc}", file=sys.stderr)
+        return 1
+
+    for keymap in keymaps:
+        keymap.digests = [layer_digest(keymap.data, i, raw_map, base) for i in range(len(keymap.data["layers"]))]
+
+    for sub in ("layers", "parsed"):
+        (args.cache_dir / sub).mkdir(parents=True, exist_ok=True)
+    args.out_dir.mkdir(parents=True, exist_ok=True)
+
+    stale = [keymap for keymap in keymaps if not is_current(args.cache_dir, keymap)]
+    for keymap in keymaps:
+        if keymap not in stale:
+            print(f"✓ Unchanged: {keymap.svg_path}")
+
+    # Layers missing from the cache, each drawn once even if several keymaps share it
+    missing: dict[str, tuple[Keymap, int]] = {}
+    for keymap in stale:
+        for index, digest in enumerate(keymap.digests):
+            if digest not in missing and not fragment_path(args.cache_dir, digest).exists():
+                missing[digest] = (keymap, index)
+    to_parse = list({id(keymap): keymap for keymap, _ in missing.values()}.values())
+
+    failed: dict[Path, str] = {}
+    with ThreadPoolExecutor(max_workers=jobs) as pool:
+        for keymap, future in [(k, pool.submit(parse_keymap, args.config, args.cache_dir, k)) for k in to_parse]:
+            try:
+                future.result()
+            except RenderError as exc:
+                failed[keymap.json_path] = str(exc)
+
+        draws = [
+            (keymap, index, pool.submit(draw_layer, args.config, args.cache_dir, keymap.yaml_path, index, digest))
+            for digest, (keymap, index) in missing.items()
+            if keymap.yaml_path and keymap.yaml_path.exists()
+        ]
+        for keymap, index, future in draws:
+            try:
+                future.result()
+            except RenderError as exc:
+                failed.setdefault(keymap.json_path, f"L{index}: {exc}")
+
+        def finish(keymap: Keymap) -> str:
+            if not all(fragment_path(args.cache_dir, digest).exists() for digest in keymap.digests):
+                raise RenderError("layers missing after drawing")
+            changed = write_if_changed(keymap.svg_path, assemble(args.cache_dir, keymap))
+
+            # Copies of an unchanged SVG are only drawn when missing
+            def wanted(ext: str) -> bool:
+                return changed or not keymap.svg_path.with_suffix(ext).exists()
+
+            notes = convert_copies(keymap.svg_path, not args.no_pdf and wanted(".pdf"), not args.no_png and wanted(".png"))
+            manifest_path(args.cache_dir, keymap).write_text(manifest_text(keymap), encoding="utf-8")
+            drawn = sum(digest in missing for digest in keymap.digests)
+            return f"{drawn}/{len(keymap.digests)} layers drawn" + "".join(f", {note}" for note in notes)
+
+        for keymap, future in [(k, pool.submit(finish, k)) for k in stale if k.json_path not in failed]:
+            try:
+                print(f"✓ Rendered {keymap.svg_path} ({future.result()})")
+            except (RenderError, OSError, ET.ParseError) as exc:
+                failed[keymap.json_path] = str(exc)
+
+    for path, message in failed.items():
+        print(f"✗ {path}: {message}", file=sys.stderr)
+    print(f"✓ {len(stale) - len(failed)} rendered, {len(keymaps) - len(stale)} unchanged, {len(failed)} failed")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
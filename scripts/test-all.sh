@@ -37,8 +37,10 @@ run_test() {
 
 # Run essential tests only
 run_test "Layout Validation" "$SCRIPT_DIR/test-layouts.sh"
+run_test "Generated Layout" "python3 $SCRIPT_DIR/gen-layout.py --check"
 run_test "Coverage Validation" "$SCRIPT_DIR/validate-coverage.sh --mode strict --layout-glob corne_v4-1_custom_hrmods.vil"
 run_test "Configuration Validation" "$SCRIPT_DIR/test-configs.sh"
+run_test "Keymap Simulation" "$SCRIPT_DIR/test-sim.sh"
 
 # Optional: Run GitHub Actions locally (can be slow on first run)
 if [ "${RUN_ACT_CHECK:-}" = "true" ]; then
@@ -0,0 +1,81 @@
+#!/usr/bin/env bash
+# Keymap simulation tests
+# Replays the event traces in tools/hrmods-sim/traces through the keymap
+# compiled for the host and checks their @expect lines, then runs switch
+# bounce traces through the debounce, text through the corpus analyzer and
+# the traces through the timing tuner
+
+set -euo pipefail
+
+# Load color utilities
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+source "$SCRIPT_DIR/colors.sh"
+
+SIM_DIR="$SCRIPT_DIR/../tools/hrmods-sim"
+
+print_header "Simulating keymap..."
+
+echo "Building host simulator..."
+if ! make -s -C "$SIM_DIR"; then
+    status_fail "Simulator build failed"
+    exit 1
+fi
+
+echo ""
+echo "Replaying traces..."
+if make -s -C "$SIM_DIR" check; then
+    status_pass "All traces met their expectations"
+else
+    status_fail "Trace expectations not met (run 'make -C tools/hrmods-sim bench' for details)"
+    exit 1
+fi
+
+echo ""
+echo "Reading latency histograms over simulated raw HID..."
+SIM_HID="$SIM_DIR/build/hrmods-sim --hid $SIM_DIR/traces/alpha-rolls.trace"
+# alpha-rolls.trace has 9 presses; each must land in the key latency histogram
+if python3 "$SCRIPT_DIR/hrmods-hid.py" --sim "$SIM_HID" stats --json |
+    python3 -c 'import json, sys; sys.exit(sum(json.load(sys.stdin)[0]["counts"]) != 9)'; then
+    status_pass "hrmods-hid.py decoded the simulated histograms"
+else
+    status_fail "hrmods-hid.py could not read the simulated histograms"
+    exit 1
+fi
+
+echo ""
+echo "Round-tripping a recorded trace..."
+RECORDED="$(mktemp)"
+trap 'rm -f "$RECORDED"' EXIT
+SIM_HID="$SIM_DIR/build/hrmods-sim --hid $SIM_DIR/traces/trace-recorder.trace"
+# Replaying what the recorder captured must type the same text as the original
+if python3 "$SCRIPT_DIR/hrmods-hid.py" --sim "$SIM_HID" trace dump --stop -o "$RECORDED" &&
+    [ "$("$SIM_DIR/build/hrmods-sim" -q "$RECORDED" | grep 'typed:')" = '  typed: He sta' ]; then
+    status_pass "Recorded trace replays to the same output"
+else
+    status_fail "Recorded trace does not replay to the same output"
+    exit 1
+fi
+
+echo ""
+echo "Uploading a Vial layout in keymap batches..."
+SIM_HID="$SIM_DIR/build/hrmods-sim --hid $SIM_DIR/traces/alpha-rolls.trace"
+# Every key of the committed layout must read back through VIA's own command
+if python3 "$SCRIPT_DIR/hrmods-hid.py" --sim "$SIM_HID" keymap load --verify \
+    "$SCRIPT_DIR/../firmware/corne_v4-1_custom_hrmods.vil" >/dev/null; then
+    status_pass "Batched keymap upload reads back intact"
+else
+    status_fail "Batched keymap upload does not read back intact"
+    exit 1
+fi
+
+echo ""
+echo "Reading idle power states over simulated raw HID..."
+SIM_HID="$SIM_DIR/build/hrmods-sim --hid $SIM_DIR/traces/power-idle.trace"
+# power-idle.trace wakes from both idle steps once and spends time in the deepest
+if python3 "$SCRIPT_DIR/hrmods-hid.py" --sim "$SIM_HID" power --json |
+    python3 -c 'import json, sys; s = json.load(sys.stdin); sys.exit(s["wakes"] != 2 or not s["state_ms"][-1])'; then
+    status_pass "hrmods-hid.py decoded the simulated power states"
+else
+    status_fail "hrmods-hid.py could not read the simulated power states"
+    exit 1
+fi
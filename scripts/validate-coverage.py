@@ -4,11 +4,14 @@
 from __future__ import annotations
 
 import argparse
+import hashlib
 import json
+import os
 import re
 import subprocess
 import sys
-from dataclasses import dataclass
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import asdict, dataclass
 from pathlib import Path
 
 
@@ -23,6 +26,14 @@ class EurKeyEntry:
     level3_symbol: str
 
 
+@dataclass(frozen=True)
+class CoverageIndex:
+    """Keycode to character tables the layouts are checked against."""
+
+    xkb_level3: dict[str, str]  # RALT(<keycode>) -> EurKey level-3 keysym
+    drawer_ralt: dict[str, str]  # RALT(<keycode>) -> keymap-drawer legend
+
+
 ASCII_CHAR_TO_QMK = {
     " ": "KC_SPACE",
     "!": "LSFT(KC_1)",
@@ -185,6 +196,14 @@ XKB_TO_DRAWER_SYMBOL = {
 
 REQUIRED_EURKEY_SYMBOLS = ("adiaeresis", "odiaeresis", "udiaeresis", "ssharp", "EuroSign")
 
+# Evaluated with --inputs-from the repository flake, so "nixpkgs" is the
+# revision locked in flake.lock rather than whatever the registry points at
+XKB_INPUT = "nixpkgs"
+XKB_ATTR = f"{XKB_INPUT}#xorg.xkeyboardconfig.outPath"
+
+# Bump when the index layout or its parsing changes
+INDEX_FORMAT = 1
+
 
 def fail(msg: str) -> None:
     print(f"[FAIL] {msg}")
@@ -217,6 +236,9 @@ def parse_args() -> argparse.Namespace:
         default="non-strict",
         help="strict: coverage issues fail; non-strict: coverage issues warn",
     )
+    parser.add_argument("--cache-dir", default=".cache/coverage", help="Where the keycode index is kept")
+    parser.add_argument("--flake-lock", default="flake.lock", help="Lock file whose nixpkgs provides the EurKey xkb data")
+    parser.add_argument("--refresh", action="store_true", help="Re-evaluate nixpkgs and rebuild the index")
     return parser.parse_args()
 
 
@@ -306,9 +328,25 @@ def load_vil_keys(file_path: Path) -> set[str]:
     return expand_virtual_keys(keys)
 
 
-def nix_eval_out_path(attr: str) -> str:
+def locked_input(flake_lock: Path, name: str) -> dict:
+    """The "locked" entry of a root input of flake.lock, following "follows"."""
+    lock = json.loads(flake_lock.read_text(encoding="utf-8"))
+    nodes = lock["nodes"]
+    node = nodes[lock.get("root", "root")]["inputs"].get(name)
+    if node is None:
+        raise KeyError(f"{flake_lock}: no input named {name}")
+    if isinstance(node, list):
+        # "follows": a path of input names starting at the root
+        node_name = lock.get("root", "root")
+        for step in node:
+            node_name = nodes[node_name]["inputs"][step]
+        node = node_name
+    return nodes[node]["locked"]
+
+
+def nix_eval_out_path(attr: str, flake_dir: Path) -> str:
     proc = subprocess.run(
-        ["nix", "eval", "--raw", attr],
+        ["nix", "eval", "--raw", "--inputs-from", str(flake_dir.resolve()), attr],
         capture_output=True,
         text=True,
         check=True,
@@ -316,8 +354,7 @@ def nix_eval_out_path(attr: str) -> str:
     return proc.stdout.strip()
 
 
-def load_eurkey_entries() -> list[EurKeyEntry]:
-    out_path = nix_eval_out_path("nixpkgs#xorg.xkeyboardconfig.outPath")
+def load_eurkey_entries(out_path: str) -> list[EurKeyEntry]:
     symbol_file = Path(out_path) / "share" / "xkeyboard-config-2" / "symbols" / "eu"
     if not symbol_file.exists():
         raise FileNotFoundError(f"EurKey symbol file not found: {symbol_file}")
@@ -364,6 +401,56 @@ def parse_ralt_drawer_map(drawer_config: Path) -> dict[str, str]:
     return mapping
 
 
+def read_cache(path: Path) -> dict | None:
+    try:
+        return json.loads(path.read_text(encoding="utf-8"))
+    except (OSError, ValueError):
+        return None
+
+
+def write_cache(path: Path, data: dict) -> None:
+    path.parent.mkdir(parents=True, exist_ok=True)
+    tmp = path.with_name(f"{path.name}.{os.getpid()}.tmp")
+    tmp.write_text(json.dumps(data, ensure_ascii=False, indent=1), encoding="utf-8")
+    tmp.replace(path)
+
+
+def xkb_out_path(cache_dir: Path, flake_lock: Path, refresh: bool) -> str:
+    """Store path of xkeyboard-config, evaluated again only when the locked nixpkgs changes."""
+    locked = locked_input(flake_lock, XKB_INPUT)
+    record_path = cache_dir / "nix-eval.json"
+    record = read_cache(record_path)
+    if (
+        not refresh
+        and record
+        and record.get("attr") == XKB_ATTR
+        and record.get("locked") == locked
+        and Path(record.get("out_path", "")).exists()  # Not garbage collected
+    ):
+        return record["out_path"]
+
+    out_path = nix_eval_out_path(XKB_ATTR, flake_lock.parent)
+    write_cache(record_path, {"attr": XKB_ATTR, "locked": locked, "out_path": out_path})
+    return out_path
+
+
+def load_index(cache_dir: Path, drawer_config: Path, flake_lock: Path, refresh: bool) -> tuple[CoverageIndex, bool]:
+    """Index keyed by the xkb store path and the drawer config; True if it was cached."""
+    out_path = xkb_out_path(cache_dir, flake_lock, refresh)
+    drawer_hash = hashlib.sha256(drawer_config.read_bytes()).hexdigest()
+    key = hashlib.sha256(f"{INDEX_FORMAT}\0{out_path}\0{drawer_hash}".encode()).hexdigest()[:16]
+    index_path = cache_dir / f"index-{key}.json"
+
+    cached = None if refresh else read_cache(index_path)
+    if cached and cached.get("out_path") == out_path:
+        return CoverageIndex(cached["xkb_level3"], cached["drawer_ralt"]), True
+
+    xkb_level3 = {f"RALT({entry.qmk_keycode})": entry.level3_symbol for entry in load_eurkey_entries(out_path)}
+    index = CoverageIndex(xkb_level3, parse_ralt_drawer_map(drawer_config))
+    write_cache(index_path, {"out_path": out_path, **asdict(index)})
+    return index, False
+
+
 def validate_ascii_coverage(
     keys: set[str], layout_name: str, *, strict: bool
 ) -> tuple[bool, list[str]]:
@@ -386,11 +473,11 @@ def validate_ascii_coverage(
 def validate_eurkey_required(
     keys: set[str],
     layout_name: str,
-    eur_entries: list[EurKeyEntry],
+    index: CoverageIndex,
     *,
     strict: bool,
 ) -> tuple[bool, list[str]]:
-    by_symbol = {entry.level3_symbol: f"RALT({entry.qmk_keycode})" for entry in eur_entries}
+    by_symbol = {symbol: keycode for keycode, symbol in index.xkb_level3.items()}
     missing: list[str] = []
 
     for symbol in REQUIRED_EURKEY_SYMBOLS:
@@ -418,15 +505,14 @@ def validate_eurkey_required(
 def validate_drawer_drift(
     keys: set[str],
     layout_name: str,
-    drawer_map: dict[str, str],
-    eur_entries: list[EurKeyEntry],
+    index: CoverageIndex,
     *,
     strict: bool,
 ) -> tuple[bool, list[str], list[str]]:
     missing_codes: list[str] = []
     mismatched_symbols: list[str] = []
-
-    eur_by_keycode = {f"RALT({entry.qmk_keycode})": entry.level3_symbol for entry in eur_entries}
+    drawer_map = index.drawer_ralt
+    eur_by_keycode = index.xkb_level3
 
     for ralt_code, drawer_symbol in sorted(drawer_map.items()):
         if ralt_code not in keys:
@@ -485,28 +571,33 @@ def main() -> int:
         print(f"ERROR: No .vil files found in {firmware_dir} with glob {args.layout_glob}")
         return 1
 
-    info("Loading EurKey xkb data from nixpkgs...")
-    eur_entries = load_eurkey_entries()
-    drawer_map = parse_ralt_drawer_map(drawer_config)
+    flake_lock = Path(args.flake_lock)
+    if not flake_lock.is_file():
+        print(f"ERROR: flake lock file not found: {flake_lock}")
+        return 1
+
+    cache_dir = Path(args.cache_dir)
+    index, cached = load_index(cache_dir, drawer_config, flake_lock, args.refresh)
+    if cached:
+        info(f"Using the EurKey xkb index cached in {cache_dir}")
+    else:
+        info(f"Indexed EurKey xkb data from the locked nixpkgs into {cache_dir}")
+
+    # All layouts are read and flattened at once; results stay in file order
+    with ThreadPoolExecutor() as pool:
+        layout_keys = list(pool.map(load_vil_keys, vil_files))
 
     failures = 0
     warned = 0
 
-    for vil_file in vil_files:
+    for vil_file, keys in zip(vil_files, layout_keys):
         print()
         info(f"Validating coverage for {vil_file.name}")
-        keys = load_vil_keys(vil_file)
 
         strict_mode = args.mode == "strict"
         ascii_ok, _ = validate_ascii_coverage(keys, vil_file.name, strict=strict_mode)
-        eur_ok, _ = validate_eurkey_required(keys, vil_file.name, eur_entries, strict=strict_mode)
-        drift_ok, _, _ = validate_drawer_drift(
-            keys,
-            vil_file.name,
-            drawer_map,
-            eur_entries,
-            strict=strict_mode,
-        )
+        eur_ok, _ = validate_eurkey_required(keys, vil_file.name, index, strict=strict_mode)
+        drift_ok, _, _ = validate_drawer_drift(keys, vil_file.name, index, strict=strict_mode)
 
         if not (ascii_ok and eur_ok and drift_ok):
             if args.mode == "strict":
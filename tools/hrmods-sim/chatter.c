@@ -0,0 +1,410 @@
+/* Copyright 2024
+ * Switch bounce harness for the keymap's debounce
+ *
+ * Feeds raw contact traces, with the bounce left in, through the debounce
+ * selected in rules.mk and through QMK's default (sym_defer_g) side by
+ * side, sampling the matrix every --scan-us like the firmware's scan loop.
+ * Every press the reference reports is matched with the press the keymap's
+ * debounce reported for the same key, which gives:
+ *
+ *   latency saved  reference press time - keymap press time
+ *   ghost presses  keymap presses with no reference press (chatter or
+ *                  contact noise that got through)
+ *   missed presses reference presses the keymap never reported
+ *
+ * Traces are either synthetic (--synthetic <presses>: random typing with
+ * 0-4 bounces per edge, all settled within 4 ms) or files with one raw
+ * contact edge per line, e.g. converted from a logic analyzer capture:
+ *
+ *   <us> <row>,<col> down|up   contact closes / opens
+ *   @expect ghosts <n>         ghost presses allowed (default 0)
+ *   @expect min-saved-us <us>  lower bound for the mean latency saved
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "qmk/debounce.h"
+
+#define MAX_EDGES 65536
+#define MAX_PRESSES 16384
+#define SETTLE_US 100000
+
+typedef struct {
+    uint32_t time;  // us
+    keypos_t key;
+    bool     closed;
+} edge_t;
+
+typedef struct {
+    uint32_t time;  // us
+    keypos_t key;
+    bool     pressed;
+} cooked_edge_t;
+
+typedef struct {
+    const char    *name;
+    edge_t        *edges;
+    uint32_t       edge_count;
+    uint32_t       expect_ghosts;
+    uint32_t       expect_min_saved;
+    cooked_edge_t *keymap;  // Output of the debounce under test
+    uint32_t       keymap_count;
+    cooked_edge_t *reference;  // Output of sym_defer_g
+    uint32_t       reference_count;
+} chatter_trace_t;
+
+static uint32_t now_us;
+
+uint16_t timer_read(void) {
+    return (uint16_t)(now_us / 1000);
+}
+
+// ============================================================================
+// Reference Debounce (sym_defer_g)
+// ============================================================================
+
+static uint16_t reference_timer;
+static bool     reference_debouncing;
+
+static bool reference_debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    bool cooked_changed = false;
+
+    if (changed) {
+        reference_debouncing = true;
+        reference_timer      = timer_read();
+    } else if (reference_debouncing && (uint16_t)(timer_read() - reference_timer) >= DEBOUNCE) {
+        size_t matrix_size = num_rows * sizeof(matrix_row_t);
+        if (memcmp(cooked, raw, matrix_size) != 0) {
+            memcpy(cooked, raw, matrix_size);
+            cooked_changed = true;
+        }
+        reference_debouncing = false;
+    }
+    return cooked_changed;
+}
+
+// ============================================================================
+// Traces
+// ============================================================================
+
+static int compare_edges(const void *a, const void *b) {
+    const edge_t *ea = a;
+    const edge_t *eb = b;
+
+    return ea->time < eb->time ? -1 : (ea->time > eb->time ? 1 : 0);
+}
+
+static bool add_edge(chatter_trace_t *trace, uint32_t time, keypos_t key, bool closed) {
+    if (trace->edge_count >= MAX_EDGES) {
+        fprintf(stderr, "%s: more than %d edges\n", trace->name, MAX_EDGES);
+        return false;
+    }
+    trace->edges[trace->edge_count++] = (edge_t){.time = time, .key = key, .closed = closed};
+    return true;
+}
+
+static bool load_chatter(chatter_trace_t *trace, const char *path) {
+    FILE *file = fopen(path, "r");
+    char  line[256];
+    int   line_no = 0;
+
+    trace->name = path;
+    if (!file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        char     verb[16];
+        unsigned time, value;
+        int      row, col;
+
+        line_no++;
+        if (sscanf(line, " @expect ghosts %u", &value) == 1) {
+            trace->expect_ghosts = value;
+        } else if (sscanf(line, " @expect min-saved-us %u", &value) == 1) {
+            trace->expect_min_saved = value;
+        } else if (sscanf(line, "%u %d,%d %15s", &time, &row, &col, verb) == 4 && row >= 0 && row < MATRIX_ROWS && col >= 0 &&
+                   col < MATRIX_COLS && (strcmp(verb, "down") == 0 || strcmp(verb, "up") == 0)) {
+            if (!add_edge(trace, time, (keypos_t){.col = (uint8_t)col, .row = (uint8_t)row}, verb[0] == 'd')) {
+                fclose(file);
+                return false;
+            }
+        } else if (line[strspn(line, " \t\r\n")] != '\0' && line[strspn(line, " \t")] != '#') {
+            fprintf(stderr, "%s:%d: cannot parse '%s'\n", path, line_no, line);
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+    qsort(trace->edges, trace->edge_count, sizeof(edge_t), compare_edges);
+    return true;
+}
+
+static uint32_t random_between(uint32_t low, uint32_t high) {
+    return low + (uint32_t)(rand() % (int)(high - low + 1));
+}
+
+// Open/close pairs after an edge; returns when the contact has settled
+static bool add_bounces(chatter_trace_t *trace, uint32_t time, keypos_t key, bool closed, uint32_t *settled) {
+    uint8_t bounces = (uint8_t)random_between(0, 4);
+
+    for (uint8_t i = 0; i < bounces; i++) {
+        time += random_between(50, 400);
+        if (!add_edge(trace, time, key, !closed)) {
+            return false;
+        }
+        time += random_between(20, 400);
+        if (!add_edge(trace, time, key, closed)) {
+            return false;
+        }
+    }
+    *settled = time;
+    return true;
+}
+
+// Alpha keys of both halves, typed with overlapping (rolled) presses
+static bool make_synthetic(chatter_trace_t *trace, uint32_t presses) {
+    static uint32_t free_at[MATRIX_ROWS][MATRIX_COLS];
+    static const uint8_t rows[] = {0, 1, 2, 4, 5, 6};
+    uint32_t              time  = 10000;
+
+    trace->name = "synthetic";
+    memset(free_at, 0, sizeof(free_at));
+    for (uint32_t i = 0; i < presses; i++) {
+        keypos_t key = {.col = (uint8_t)random_between(1, 5), .row = rows[random_between(0, sizeof(rows) - 1)]};
+        uint32_t settled;
+
+        time += random_between(40, 200) * 1000;
+        if (time < free_at[key.row][key.col]) {
+            time = free_at[key.row][key.col];
+        }
+
+        uint32_t release = time + random_between(30, 150) * 1000;
+        if (!add_edge(trace, time, key, true) || !add_bounces(trace, time, key, true, &settled) || !add_edge(trace, release, key, false) ||
+            !add_bounces(trace, release, key, false, &settled)) {
+            return false;
+        }
+        // A finger needs a while before it presses the same key again
+        free_at[key.row][key.col] = settled + 30000;
+    }
+    qsort(trace->edges, trace->edge_count, sizeof(edge_t), compare_edges);
+    return true;
+}
+
+// ============================================================================
+// Replay
+// ============================================================================
+
+static void record_changes(cooked_edge_t *out, uint32_t *count, const matrix_row_t *before, const matrix_row_t *after) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        matrix_row_t diff = before[row] ^ after[row];
+        for (uint8_t col = 0; col < MATRIX_COLS && diff; col++) {
+            matrix_row_t mask = (matrix_row_t)1 << col;
+            if ((diff & mask) && *count < MAX_PRESSES * 2) {
+                out[(*count)++] = (cooked_edge_t){.time = now_us, .key = {.col = col, .row = row}, .pressed = (after[row] & mask) != 0};
+            }
+        }
+    }
+}
+
+static void replay(chatter_trace_t *trace, uint32_t scan_us) {
+    matrix_row_t raw[MATRIX_ROWS]      = {0};
+    matrix_row_t previous[MATRIX_ROWS] = {0};
+    matrix_row_t keymap[MATRIX_ROWS]   = {0};
+    matrix_row_t reference[MATRIX_ROWS] = {0};
+    uint32_t     end                    = trace->edge_count ? trace->edges[trace->edge_count - 1].time + SETTLE_US : 0;
+    uint32_t     next                   = 0;
+
+    now_us = 0;
+    reference_debouncing = false;
+    debounce_init(MATRIX_ROWS);
+
+    for (now_us = 0; now_us <= end; now_us += scan_us) {
+        matrix_row_t keymap_before[MATRIX_ROWS], reference_before[MATRIX_ROWS];
+
+        while (next < trace->edge_count && trace->edges[next].time <= now_us) {
+            edge_t      *edge = &trace->edges[next++];
+            matrix_row_t mask = (matrix_row_t)1 << edge->key.col;
+            raw[edge->key.row] = edge->closed ? raw[edge->key.row] | mask : raw[edge->key.row] & ~mask;
+        }
+        bool changed = memcmp(raw, previous, sizeof(raw)) != 0;
+        memcpy(previous, raw, sizeof(raw));
+
+        memcpy(keymap_before, keymap, sizeof(keymap));
+        memcpy(reference_before, reference, sizeof(reference));
+        if (debounce(raw, keymap, MATRIX_ROWS, changed)) {
+            record_changes(trace->keymap, &trace->keymap_count, keymap_before, keymap);
+        }
+        if (reference_debounce(raw, reference, MATRIX_ROWS, changed)) {
+            record_changes(trace->reference, &trace->reference_count, reference_before, reference);
+        }
+    }
+    debounce_free();
+}
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+static bool same_key(keypos_t a, keypos_t b) {
+    return a.row == b.row && a.col == b.col;
+}
+
+// Match presses key by key: a keymap press belongs to the reference press
+// of the same key that follows it before that key's next reference release
+static bool report(chatter_trace_t *trace, bool check) {
+    uint32_t matched = 0, ghosts = 0, missed = 0, reference_presses = 0, keymap_presses = 0;
+    int64_t  saved_total = 0, release_total = 0;
+    int32_t  saved_min = INT32_MAX, saved_max = INT32_MIN;
+    bool    *used = calloc(trace->keymap_count + 1, sizeof(bool));
+
+    for (uint32_t r = 0; r < trace->reference_count; r++) {
+        cooked_edge_t *ref = &trace->reference[r];
+        if (!ref->pressed) {
+            continue;
+        }
+        reference_presses++;
+
+        // Latest unused keymap press of this key at or before the reference press
+        int32_t found = -1;
+        for (uint32_t k = 0; k < trace->keymap_count && trace->keymap[k].time <= ref->time; k++) {
+            if (!used[k] && trace->keymap[k].pressed && same_key(trace->keymap[k].key, ref->key)) {
+                found = (int32_t)k;
+            }
+        }
+        if (found < 0) {
+            missed++;
+            continue;
+        }
+        used[found] = true;
+        matched++;
+
+        int32_t saved = (int32_t)(ref->time - trace->keymap[found].time);
+        saved_total += saved;
+        saved_min = saved < saved_min ? saved : saved_min;
+        saved_max = saved > saved_max ? saved : saved_max;
+
+        // Release difference: the next release of the key on both sides
+        uint32_t ref_release = 0, keymap_release = 0;
+        for (uint32_t i = r + 1; i < trace->reference_count && !ref_release; i++) {
+            if (!trace->reference[i].pressed && same_key(trace->reference[i].key, ref->key)) {
+                ref_release = trace->reference[i].time;
+            }
+        }
+        for (uint32_t i = (uint32_t)found + 1; i < trace->keymap_count && !keymap_release; i++) {
+            if (!trace->keymap[i].pressed && same_key(trace->keymap[i].key, ref->key)) {
+                keymap_release = trace->keymap[i].time;
+            }
+        }
+        release_total += (int64_t)keymap_release - (int64_t)ref_release;
+    }
+    for (uint32_t k = 0; k < trace->keymap_count; k++) {
+        if (trace->keymap[k].pressed) {
+            keymap_presses++;
+            if (!used[k]) {
+                ghosts++;
+            }
+        }
+    }
+    free(used);
+
+    double saved_mean = matched ? (double)saved_total / matched : 0.0;
+    printf("== %s (%u edges)\n", trace->name, trace->edge_count);
+    printf("  presses: %u reference, %u keymap, %u ghost, %u missed\n", reference_presses, keymap_presses, ghosts, missed);
+    if (matched) {
+        printf("  latency saved: mean %.2f ms, min %.2f ms, max %.2f ms\n", saved_mean / 1000.0, saved_min / 1000.0, saved_max / 1000.0);
+        printf("  release: mean %+.2f ms vs reference\n", (double)release_total / matched / 1000.0);
+    }
+
+    bool ok = true;
+    if (check && ghosts > trace->expect_ghosts) {
+        printf("  FAIL: %u ghost presses, %u allowed\n", ghosts, trace->expect_ghosts);
+        ok = false;
+    }
+    if (check && missed) {
+        printf("  FAIL: %u presses never reported\n", missed);
+        ok = false;
+    }
+    if (check && saved_mean < trace->expect_min_saved) {
+        printf("  FAIL: mean latency saved %.0f us, expected at least %u us\n", saved_mean, trace->expect_min_saved);
+        ok = false;
+    }
+    return ok;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--check] [--scan-us n] [--synthetic presses [--seed n]] [trace...]\n", argv0);
+    fprintf(stderr, "  --check       fail on ghost or missed presses and unmet @expect lines\n");
+    fprintf(stderr, "  --scan-us     matrix scan interval (default 200)\n");
+    fprintf(stderr, "  --synthetic   add a random bouncy typing trace with this many presses\n");
+    fprintf(stderr, "  --min-saved   lower bound in us for the synthetic trace's mean latency saved\n");
+}
+
+static int run(chatter_trace_t *trace, uint32_t scan_us, bool check) {
+    trace->keymap    = calloc(MAX_PRESSES * 2, sizeof(cooked_edge_t));
+    trace->reference = calloc(MAX_PRESSES * 2, sizeof(cooked_edge_t));
+    replay(trace, scan_us);
+
+    bool ok = report(trace, check);
+    free(trace->keymap);
+    free(trace->reference);
+    free(trace->edges);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    bool     check     = false;
+    uint32_t scan_us   = 200;
+    uint32_t synthetic = 0;
+    uint32_t min_saved = 0;
+    unsigned seed      = 1;
+    int      failures  = 0;
+    int      runs      = 0;
+    int      first     = 1;
+
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        if (strcmp(argv[first], "--check") == 0) {
+            check = true;
+        } else if (strcmp(argv[first], "--scan-us") == 0 && first + 1 < argc) {
+            scan_us = (uint32_t)strtoul(argv[++first], NULL, 10);
+        } else if (strcmp(argv[first], "--synthetic") == 0 && first + 1 < argc) {
+            synthetic = (uint32_t)strtoul(argv[++first], NULL, 10);
+        } else if (strcmp(argv[first], "--seed") == 0 && first + 1 < argc) {
+            seed = (unsigned)strtoul(argv[++first], NULL, 10);
+        } else if (strcmp(argv[first], "--min-saved") == 0 && first + 1 < argc) {
+            min_saved = (uint32_t)strtoul(argv[++first], NULL, 10);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if ((!synthetic && first >= argc) || !scan_us || synthetic > MAX_PRESSES) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (synthetic) {
+        chatter_trace_t trace = {.edges = calloc(MAX_EDGES, sizeof(edge_t)), .expect_min_saved = min_saved};
+        srand(seed);
+        if (!make_synthetic(&trace, synthetic)) {
+            return 2;
+        }
+        failures += run(&trace, scan_us, check);
+        runs++;
+    }
+    for (int i = first; i < argc; i++) {
+        chatter_trace_t trace = {.edges = calloc(MAX_EDGES, sizeof(edge_t))};
+        if (!load_chatter(&trace, argv[i])) {
+            return 2;
+        }
+        failures += run(&trace, scan_us, check);
+        runs++;
+    }
+
+    if (check) {
+        printf("%d/%d chatter traces passed\n", runs - failures, runs);
+    }
+    return failures ? 1 : 0;
+}
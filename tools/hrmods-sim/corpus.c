@@ -0,0 +1,788 @@
+/* Copyright 2024
+ * Corpus analyzer for the custom_hrmods layout
+ *
+ * Types text through the compiled keymap (keymap.gen.h, so every layer of
+ * layout.yaml including the EurKey RALT(...) symbols) and reports what it
+ * would cost to type:
+ *
+ *   per-key load     presses per matrix position, layer and shift keys
+ *                    included
+ *   same-finger      consecutive characters on different keys of the same
+ *   bigrams          finger (thumbs excluded)
+ *   home row mod     a home row mod followed by another key of the same
+ *   rolls            hand: the rolls the bilateral engine settles as taps,
+ *                    and how many of them typing flow already sent as taps
+ *                    (the mod came right after a letter of the same hand);
+ *                    cross-hand rolls are the ones that can become holds
+ *   layer switches   presses of a MO() key to reach a character, once per
+ *                    run of characters on the same layer
+ *
+ * Every character is typed the cheapest way the keymap offers: a key on
+ * the base layer, then a key on a MO() layer, then Shift (the home row
+ * Shift of the other hand) with either. Characters that can't be typed are
+ * counted and skipped.
+ *
+ * Files are cut into chunks that all cores work on; each chunk re-reads
+ * the two characters before it, so the result does not depend on the
+ * thread count or chunk size. A worker maps a file only while it works on
+ * one of its chunks, so any number of files stays within the process's
+ * mapping limit. Directories are walked recursively (hidden entries and
+ * files with NUL bytes are skipped).
+ */
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "qmk/quantum.h"
+#include "layout.gen.h"
+#include "keymap.gen.h"
+
+#define KEY_COUNT (MATRIX_ROWS * MATRIX_COLS)
+#define DEFAULT_CHUNK (64u << 20)
+#define MAX_THREADS 256
+#define TOP_PAIRS 10
+
+// ============================================================================
+// Strokes
+// ============================================================================
+
+typedef struct {
+    bool    valid;
+    uint8_t row;
+    uint8_t col;
+    uint8_t layer;
+    bool    shift;
+    // Filled in once the tables are built, for the per-character loop
+    uint8_t hand;
+    uint8_t finger;
+    bool    home_row_mod;
+    bool    letter;
+} stroke_t;
+
+// One non-ASCII character the host layout (EurKey) produces with AltGr
+typedef struct {
+    uint32_t codepoint;
+    uint8_t  keycode;
+    bool     shift;
+} eurkey_char_t;
+
+// clang-format off
+// US ANSI, which EurKey keeps on its first two levels
+static const char unshifted[256] = {
+    [KC_1] = '1', [KC_2] = '2', [KC_3] = '3', [KC_4] = '4', [KC_5] = '5',
+    [KC_6] = '6', [KC_7] = '7', [KC_8] = '8', [KC_9] = '9', [KC_0] = '0',
+    [KC_ENTER] = '\n', [KC_TAB] = '\t', [KC_SPACE] = ' ', [KC_MINUS] = '-',
+    [KC_EQUAL] = '=', [KC_LEFT_BRACKET] = '[', [KC_RIGHT_BRACKET] = ']',
+    [KC_BACKSLASH] = '\\', [KC_SEMICOLON] = ';', [KC_QUOTE] = '\'', [KC_GRAVE] = '`',
+    [KC_COMMA] = ',', [KC_DOT] = '.', [KC_SLASH] = '/',
+};
+static const char shifted[256] = {
+    [KC_1] = '!', [KC_2] = '@', [KC_3] = '#', [KC_4] = '$', [KC_5] = '%',
+    [KC_6] = '^', [KC_7] = '&', [KC_8] = '*', [KC_9] = '(', [KC_0] = ')',
+    [KC_MINUS] = '_', [KC_EQUAL] = '+', [KC_LEFT_BRACKET] = '{', [KC_RIGHT_BRACKET] = '}',
+    [KC_BACKSLASH] = '|', [KC_SEMICOLON] = ':', [KC_QUOTE] = '"', [KC_GRAVE] = '~',
+    [KC_COMMA] = '<', [KC_DOT] = '>', [KC_SLASH] = '?',
+};
+
+// AltGr level of EurKey for the RALT() keycodes keymap-drawer.yaml labels
+static const eurkey_char_t eurkey_chars[] = {
+    {0x00E4, KC_A, false}, {0x00C4, KC_A, true},   // ä Ä
+    {0x00F6, KC_O, false}, {0x00D6, KC_O, true},   // ö Ö
+    {0x00FC, KC_U, false}, {0x00DC, KC_U, true},   // ü Ü
+    {0x00DF, KC_S, false},                         // ß
+    {0x20AC, KC_5, false},                         // €
+    {0x00B0, KC_SEMICOLON, false},                 // °
+};
+// clang-format on
+
+#define EURKEY_CHARS (sizeof(eurkey_chars) / sizeof(eurkey_chars[0]))
+
+static stroke_t ascii_strokes[128];
+static stroke_t eurkey_strokes[EURKEY_CHARS];
+static stroke_t layer_keys[LAYOUT_LAYER_COUNT][2];  // MO() key per layer, per hand of the character
+static stroke_t shift_keys[2];                      // Shift per hand of the character
+static char     key_labels[MATRIX_ROWS][MATRIX_COLS][8];
+
+static uint8_t key_hand(uint8_t row, uint8_t col) {
+    return LAYOUT_KEY_HAND(layout_key_flags[row][col]);
+}
+
+// Index into the finger table: hand * 5 + finger, thumbs are 10 and 11
+static uint8_t key_finger(uint8_t row, uint8_t col) {
+    static const uint8_t column_finger[MATRIX_COLS] = {0, 0, 1, 2, 3, 3, 3};
+    uint8_t              hand                       = key_hand(row, col);
+
+    if (hand == LAYOUT_HAND_THUMB) {
+        return 10 + (row >= MATRIX_ROWS / 2);
+    }
+    return hand * 5 + column_finger[col];
+}
+
+static uint16_t stroke_cost(const stroke_t *stroke) {
+    // Fewer extra keys first, then no Shift, then lower layers
+    return (uint16_t)(((stroke->layer != _BASE) + stroke->shift) << 8 | stroke->shift << 4 | stroke->layer);
+}
+
+static void offer(stroke_t *slot, stroke_t stroke) {
+    if (!slot->valid || stroke_cost(&stroke) < stroke_cost(slot)) {
+        *slot = stroke;
+    }
+}
+
+// Keycode a key sends when tapped, with the mods that come with it
+static uint8_t tap_keycode(uint16_t keycode, uint8_t *mods) {
+    *mods = 0;
+    if (IS_QK_BASIC(keycode)) {
+        return (uint8_t)keycode;
+    }
+    if (IS_QK_MOD_TAP(keycode)) {
+        return QK_MOD_TAP_GET_TAP_KEYCODE(keycode);
+    }
+    if (IS_QK_MODS(keycode)) {
+        *mods = QK_MODS_GET_MODS(keycode);
+        return QK_MODS_GET_BASIC_KEYCODE(keycode);
+    }
+    if (keycode == SC_SENT) {
+        return KC_ENTER;
+    }
+    if (keycode == SC_LSPO) {
+        *mods = MOD_LSFT;
+        return KC_9;
+    }
+    if (keycode == SC_RCPC) {
+        *mods = MOD_LSFT;
+        return KC_0;
+    }
+    return KC_NO;
+}
+
+static void add_key(uint8_t layer, uint8_t row, uint8_t col, uint16_t keycode) {
+    uint8_t  mods;
+    uint8_t  basic = tap_keycode(keycode, &mods);
+    bool     shift = mods & MOD_LSFT;
+    bool     ralt  = (mods & MOD_RALT) == MOD_RALT;
+    stroke_t key   = {.valid = true, .row = row, .col = col, .layer = layer};
+
+    if (mods & ~(MOD_LSFT | MOD_RALT)) {
+        return;
+    }
+    if (ralt) {
+        for (uint8_t i = 0; i < EURKEY_CHARS; i++) {
+            if (eurkey_chars[i].keycode == basic && (eurkey_chars[i].shift == shift || !shift)) {
+                key.shift = eurkey_chars[i].shift && !shift;
+                offer(&eurkey_strokes[i], key);
+            }
+        }
+        return;
+    }
+    if (basic >= KC_A && basic <= KC_Z) {
+        char letter = (char)('a' + basic - KC_A);
+        if (!shift) {
+            offer(&ascii_strokes[(uint8_t)letter], key);
+        }
+        key.shift = !shift;
+        offer(&ascii_strokes[(uint8_t)(letter - 'a' + 'A')], key);
+        return;
+    }
+    if (shift) {
+        if (shifted[basic]) {
+            offer(&ascii_strokes[(uint8_t)shifted[basic]], key);
+        }
+        return;
+    }
+    if (unshifted[basic]) {
+        offer(&ascii_strokes[(uint8_t)unshifted[basic]], key);
+    }
+    if (shifted[basic]) {
+        key.shift = true;
+        offer(&ascii_strokes[(uint8_t)shifted[basic]], key);
+    }
+}
+
+// Prefer the other hand's key for a character typed with the given hand
+static void add_helper(stroke_t helpers[2], uint8_t row, uint8_t col) {
+    uint8_t  hand   = key_hand(row, col);
+    stroke_t helper = {.valid = true, .row = row, .col = col};
+
+    for (uint8_t typing = 0; typing < 2; typing++) {
+        if (!helpers[typing].valid || (hand != typing && key_hand(helpers[typing].row, helpers[typing].col) == typing)) {
+            helpers[typing] = helper;
+        }
+    }
+}
+
+static void finish_stroke(stroke_t *stroke) {
+    uint8_t mods;
+    uint8_t basic = tap_keycode(keymaps[stroke->layer][stroke->row][stroke->col], &mods);
+
+    // Shifted strokes need a Shift key
+    if (stroke->shift && !shift_keys[0].valid) {
+        stroke->valid = false;
+    }
+    stroke->hand         = key_hand(stroke->row, stroke->col);
+    stroke->finger       = key_finger(stroke->row, stroke->col);
+    stroke->home_row_mod = stroke->layer == _BASE && (layout_key_flags[stroke->row][stroke->col] & LAYOUT_KEY_HOME_ROW_MOD);
+    stroke->letter       = basic >= KC_A && basic <= KC_Z;
+}
+
+static void build_tables(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint16_t keycode = keymaps[_BASE][row][col];
+            uint8_t  mods;
+
+            if (IS_QK_MOMENTARY(keycode) && QK_MOMENTARY_GET_LAYER(keycode) < LAYOUT_LAYER_COUNT) {
+                add_helper(layer_keys[QK_MOMENTARY_GET_LAYER(keycode)], row, col);
+            }
+            if ((IS_QK_MOD_TAP(keycode) && (QK_MOD_TAP_GET_MODS(keycode) & MOD_LSFT)) || keycode == KC_LEFT_SHIFT ||
+                keycode == KC_RIGHT_SHIFT) {
+                add_helper(shift_keys, row, col);
+            }
+
+            uint8_t basic = tap_keycode(keycode, &mods);
+            if (basic >= KC_A && basic <= KC_Z && !mods) {
+                snprintf(key_labels[row][col], sizeof(key_labels[row][col]), "%c", 'a' + basic - KC_A);
+            } else if (unshifted[basic] > ' ' && !mods) {
+                snprintf(key_labels[row][col], sizeof(key_labels[row][col]), "%c", unshifted[basic]);
+            } else if (shifted[basic] && mods == MOD_LSFT) {
+                snprintf(key_labels[row][col], sizeof(key_labels[row][col]), "%c", shifted[basic]);
+            } else {
+                snprintf(key_labels[row][col], sizeof(key_labels[row][col]), "%u,%u", row, col);
+            }
+        }
+    }
+
+    for (uint8_t layer = 0; layer < LAYOUT_LAYER_COUNT; layer++) {
+        // Characters on a layer no MO() key reaches can't be typed here
+        if (layer != _BASE && !layer_keys[layer][0].valid) {
+            continue;
+        }
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                add_key(layer, row, col, keymaps[layer][row][col]);
+            }
+        }
+    }
+
+    for (uint16_t i = 0; i < 128; i++) {
+        finish_stroke(&ascii_strokes[i]);
+    }
+    for (uint8_t i = 0; i < EURKEY_CHARS; i++) {
+        finish_stroke(&eurkey_strokes[i]);
+    }
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+// Only uint64_t fields: merged by adding them up as an array
+typedef struct {
+    uint64_t bytes;
+    uint64_t chars;    // Summed up from layer_chars after merging
+    uint64_t unmapped;
+    uint64_t presses;  // Summed up from key_presses after merging
+    uint64_t key_presses[MATRIX_ROWS][MATRIX_COLS];
+    uint64_t bigrams;
+    uint64_t same_finger;
+    uint64_t same_finger_pairs[KEY_COUNT][KEY_COUNT];
+    uint64_t hrm_same_hand;       // Home row mod, then a key of the same hand
+    uint64_t hrm_same_hand_flow;  // ... where the mod itself followed a same-hand letter
+    uint64_t hrm_cross_hand;      // Home row mod, then a key of the other hand
+    uint64_t layer_chars[LAYOUT_LAYER_COUNT];
+    uint64_t layer_switches[LAYOUT_LAYER_COUNT];
+    uint64_t shift_presses;
+} corpus_stats_t;
+
+_Static_assert(sizeof(corpus_stats_t) % sizeof(uint64_t) == 0, "corpus_stats_t holds uint64_t only");
+
+typedef struct {
+    const stroke_t *prev;       // NULL at the start and after a character that can't be typed
+    bool            prev_flow;  // prev was a home row mod typed right after a same-hand letter
+} typing_state_t;
+
+static const stroke_t *lookup(uint32_t codepoint) {
+    if (codepoint < 128) {
+        return ascii_strokes[codepoint].valid ? &ascii_strokes[codepoint] : NULL;
+    }
+    for (uint8_t i = 0; i < EURKEY_CHARS; i++) {
+        if (eurkey_chars[i].codepoint == codepoint) {
+            return eurkey_strokes[i].valid ? &eurkey_strokes[i] : NULL;
+        }
+    }
+    return NULL;
+}
+
+// Type one character; stats == NULL only updates the state (chunk seeding)
+static void type_char(typing_state_t *state, uint32_t codepoint, corpus_stats_t *stats) {
+    const stroke_t *stroke = lookup(codepoint);
+    const stroke_t *prev   = state->prev;
+
+    if (codepoint == '\r') {
+        return;  // CRLF types one Enter
+    }
+    if (!stroke) {
+        if (stats) {
+            stats->unmapped++;
+        }
+        state->prev = NULL;
+        return;
+    }
+
+    if (stats) {
+        stats->layer_chars[stroke->layer]++;
+        stats->key_presses[stroke->row][stroke->col]++;
+
+        // Layer and Shift keys stay held over a run of characters that need them
+        if (stroke->layer != _BASE && (!prev || prev->layer != stroke->layer)) {
+            const stroke_t *layer_key = &layer_keys[stroke->layer][stroke->hand & 1];
+            stats->layer_switches[stroke->layer]++;
+            stats->key_presses[layer_key->row][layer_key->col]++;
+        }
+        if (stroke->shift && (!prev || !prev->shift)) {
+            const stroke_t *shift_key = &shift_keys[stroke->hand & 1];
+            stats->shift_presses++;
+            stats->key_presses[shift_key->row][shift_key->col]++;
+        }
+
+        if (prev) {
+            stats->bigrams++;
+            if (stroke->finger < 10 && stroke->finger == prev->finger && (prev->row != stroke->row || prev->col != stroke->col)) {
+                stats->same_finger++;
+                stats->same_finger_pairs[prev->row * MATRIX_COLS + prev->col][stroke->row * MATRIX_COLS + stroke->col]++;
+            }
+            if (prev->home_row_mod && stroke->hand != LAYOUT_HAND_THUMB) {
+                if (stroke->hand == prev->hand) {
+                    stats->hrm_same_hand++;
+                    stats->hrm_same_hand_flow += state->prev_flow;
+                } else {
+                    stats->hrm_cross_hand++;
+                }
+            }
+        }
+    }
+    state->prev_flow = stroke->home_row_mod && prev && prev->hand == stroke->hand && prev->letter;
+    state->prev      = stroke;
+}
+
+// Decode one UTF-8 sequence; malformed bytes decode as U+FFFD one at a time
+static size_t decode_utf8(const uint8_t *text, const uint8_t *end, uint32_t *codepoint) {
+    uint8_t lead = text[0];
+    size_t  length;
+
+    if (lead < 0x80) {
+        *codepoint = lead;
+        return 1;
+    }
+    if ((lead & 0xE0) == 0xC0) {
+        length     = 2;
+        *codepoint = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length     = 3;
+        *codepoint = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length     = 4;
+        *codepoint = lead & 0x07;
+    } else {
+        *codepoint = 0xFFFD;
+        return 1;
+    }
+    if ((size_t)(end - text) < length) {
+        *codepoint = 0xFFFD;
+        return 1;
+    }
+    for (size_t i = 1; i < length; i++) {
+        if ((text[i] & 0xC0) != 0x80) {
+            *codepoint = 0xFFFD;
+            return 1;
+        }
+        *codepoint = *codepoint << 6 | (text[i] & 0x3F);
+    }
+    return length;
+}
+
+static bool is_continuation(uint8_t byte) {
+    return (byte & 0xC0) == 0x80;
+}
+
+// ============================================================================
+// Work
+// ============================================================================
+
+typedef struct {
+    char  *path;
+    size_t size;
+} corpus_file_t;
+
+// Byte range of a file; both ends move forward to the next character
+// boundary once the file is mapped, so neighbouring chunks still meet
+typedef struct {
+    uint32_t file;
+    size_t   begin;
+    size_t   end;
+} chunk_t;
+
+static corpus_file_t *files;
+static uint32_t       file_count;
+static size_t         file_capacity;
+static chunk_t       *chunks;
+static uint32_t       chunk_count;
+static size_t         chunk_capacity;
+static atomic_uint    next_chunk;
+static atomic_bool    failed;
+
+// Room for one more element, doubling the allocation; NULL when out of memory
+static void *grow(void *array, size_t *capacity, size_t count, size_t size) {
+    if (count < *capacity) {
+        return array;
+    }
+
+    size_t next  = *capacity ? *capacity * 2 : 64;
+    void  *grown = realloc(array, next * size);
+    if (grown) {
+        *capacity = next;
+    }
+    return grown;
+}
+
+static size_t char_boundary(const uint8_t *data, size_t size, size_t offset) {
+    while (offset < size && is_continuation(data[offset])) {
+        offset++;
+    }
+    return offset;
+}
+
+static void analyze_chunk(const uint8_t *data, size_t size, size_t begin, size_t end, corpus_stats_t *stats) {
+    const uint8_t *text  = data + begin;
+    typing_state_t state = {NULL, false};
+
+    // Replay the two characters before the chunk to pick up where the last one left off
+    const uint8_t *seed = text;
+    for (uint8_t back = 0; back < 2 && seed > data; back++) {
+        do {
+            seed--;
+        } while (seed > data && text - seed < 8 && is_continuation(*seed));
+    }
+    while (seed < text) {
+        uint32_t codepoint;
+        seed += decode_utf8(seed, text, &codepoint);
+        type_char(&state, codepoint, NULL);
+    }
+
+    stats->bytes += end - begin;
+    while (text < data + end) {
+        uint32_t codepoint;
+        text += decode_utf8(text, data + size, &codepoint);
+        type_char(&state, codepoint, stats);
+    }
+}
+
+// Map the chunk's file for as long as the chunk takes
+static bool run_chunk(const chunk_t *chunk, corpus_stats_t *stats) {
+    const corpus_file_t *file = &files[chunk->file];
+    int                  fd   = open(file->path, O_RDONLY);
+
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", file->path, strerror(errno));
+        return false;
+    }
+    const uint8_t *data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "%s: %s\n", file->path, strerror(errno));
+        return false;
+    }
+    madvise((void *)data, file->size, MADV_SEQUENTIAL);
+
+    size_t begin = char_boundary(data, file->size, chunk->begin);
+    size_t end   = char_boundary(data, file->size, chunk->end);
+    analyze_chunk(data, file->size, begin, end, stats);
+    munmap((void *)data, file->size);
+    return true;
+}
+
+static void *worker(void *arg) {
+    corpus_stats_t *stats = arg;
+    uint32_t        index;
+
+    while ((index = atomic_fetch_add(&next_chunk, 1)) < chunk_count) {
+        if (!run_chunk(&chunks[index], stats)) {
+            atomic_store(&failed, true);
+        }
+    }
+    return NULL;
+}
+
+static bool add_file(const char *path, size_t chunk_size) {
+    int         fd = open(path, O_RDONLY);
+    struct stat st;
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    // Only the head is read here; the workers map the rest later
+    uint8_t head[4096];
+    ssize_t length = read(fd, head, sizeof(head));
+    close(fd);
+    if (length < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    if (memchr(head, '\0', (size_t)length)) {
+        return true;  // Binary
+    }
+
+    corpus_file_t *grown_files = grow(files, &file_capacity, file_count, sizeof(*files));
+    char          *copy        = strdup(path);
+    if (!grown_files || !copy) {
+        fprintf(stderr, "%s: out of memory\n", path);
+        free(copy);
+        return false;
+    }
+    files             = grown_files;
+    size_t size       = (size_t)st.st_size;
+    files[file_count] = (corpus_file_t){.path = copy, .size = size};
+
+    for (size_t begin = 0; begin < size; begin += chunk_size) {
+        chunk_t *grown_chunks = grow(chunks, &chunk_capacity, chunk_count, sizeof(*chunks));
+        if (!grown_chunks) {
+            fprintf(stderr, "%s: out of memory\n", path);
+            return false;
+        }
+        chunks                = grown_chunks;
+        size_t end            = size - begin > chunk_size ? begin + chunk_size : size;
+        chunks[chunk_count++] = (chunk_t){.file = file_count, .begin = begin, .end = end};
+    }
+    file_count++;
+    return true;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Files in name order, so chunk order and thus output never depend on readdir
+static bool add_path(const char *path, size_t chunk_size) {
+    struct stat st;
+
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        return S_ISREG(st.st_mode) ? add_file(path, chunk_size) : true;
+    }
+
+    DIR *dir = opendir(path);
+    if (!dir) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    char         **names    = NULL;
+    size_t         count    = 0;
+    size_t         capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char **grown = grow(names, &capacity, count, sizeof(*names));
+        char  *name  = strdup(entry->d_name);
+        if (!grown || !name) {
+            fprintf(stderr, "%s: out of memory\n", path);
+            free(name);
+            names = grown ? grown : names;
+            while (count) {
+                free(names[--count]);
+            }
+            free(names);
+            closedir(dir);
+            return false;
+        }
+        names          = grown;
+        names[count++] = name;
+    }
+    closedir(dir);
+    qsort(names, count, sizeof(*names), compare_names);
+
+    bool ok = true;
+    for (size_t i = 0; i < count; i++) {
+        char child[4096];
+        snprintf(child, sizeof(child), "%s/%s", path, names[i]);
+        ok = add_path(child, chunk_size) && ok;
+        free(names[i]);
+    }
+    free(names);
+    return ok;
+}
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+static void print_load_row(const corpus_stats_t *stats, uint8_t row) {
+    printf("   ");
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        bool key = row % 4 < 2 || (row % 4 == 2 && col < 6) || (row % 4 == 3 && col >= 3 && col <= 5);
+        printf(key ? " %5.2f" : "      ", percent(stats->key_presses[row][col], stats->presses));
+    }
+}
+
+static void print_report(const corpus_stats_t *stats) {
+    printf("== %u files, %llu bytes\n", file_count, (unsigned long long)stats->bytes);
+    printf("  characters: %llu typed, %llu not on the layout\n", (unsigned long long)stats->chars, (unsigned long long)stats->unmapped);
+    printf("  key presses: %llu (%.3f per character)\n", (unsigned long long)stats->presses,
+           stats->chars ? (double)stats->presses / (double)stats->chars : 0.0);
+    printf("  same-finger bigrams: %llu (%.2f%% of %llu bigrams)\n", (unsigned long long)stats->same_finger,
+           percent(stats->same_finger, stats->bigrams), (unsigned long long)stats->bigrams);
+    printf("  home row mod rolls: %llu same hand (%.2f%% of bigrams, %llu sent as taps by typing flow), %llu cross hand (%.2f%%)\n",
+           (unsigned long long)stats->hrm_same_hand, percent(stats->hrm_same_hand, stats->bigrams), (unsigned long long)stats->hrm_same_hand_flow,
+           (unsigned long long)stats->hrm_cross_hand, percent(stats->hrm_cross_hand, stats->bigrams));
+    printf("  shift presses: %llu\n", (unsigned long long)stats->shift_presses);
+    for (uint8_t layer = 0; layer < LAYOUT_LAYER_COUNT; layer++) {
+        if (stats->layer_chars[layer] || stats->layer_switches[layer]) {
+            printf("  layer %u: %llu characters (%.2f%%), %llu switches\n", layer, (unsigned long long)stats->layer_chars[layer],
+                   percent(stats->layer_chars[layer], stats->chars), (unsigned long long)stats->layer_switches[layer]);
+        }
+    }
+
+    // Left half as seen from above, right half mirrored back to the same view
+    printf("  per-key load (%% of presses):\n");
+    for (uint8_t row = 0; row < MATRIX_ROWS / 2; row++) {
+        print_load_row(stats, row);
+        printf("   |");
+        for (int col = MATRIX_COLS - 1; col >= 0; col--) {
+            uint8_t right = row + MATRIX_ROWS / 2;
+            bool    key   = row < 2 || (row == 2 && col < 6) || (row == 3 && col >= 3 && col <= 5);
+            printf(key ? " %5.2f" : "      ", percent(stats->key_presses[right][col], stats->presses));
+        }
+        printf("\n");
+    }
+
+    // Worst same-finger pairs
+    bool printed[KEY_COUNT][KEY_COUNT] = {{false}};
+    printf("  top same-finger bigrams:\n");
+    for (uint8_t rank = 0; rank < TOP_PAIRS; rank++) {
+        uint64_t best = 0;
+        int      from = -1, to = -1;
+        for (int a = 0; a < KEY_COUNT; a++) {
+            for (int b = 0; b < KEY_COUNT; b++) {
+                if (!printed[a][b] && stats->same_finger_pairs[a][b] > best) {
+                    best = stats->same_finger_pairs[a][b];
+                    from = a;
+                    to   = b;
+                }
+            }
+        }
+        if (from < 0) {
+            break;
+        }
+        printed[from][to] = true;
+        printf("    %-5s %-5s %10llu (%.3f%%)\n", key_labels[from / MATRIX_COLS][from % MATRIX_COLS], key_labels[to / MATRIX_COLS][to % MATRIX_COLS],
+               (unsigned long long)best, percent(best, stats->bigrams));
+    }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-j threads] [--chunk bytes] path...\n", argv0);
+    fprintf(stderr, "  -j        worker threads (default: all cores)\n");
+    fprintf(stderr, "  --chunk   bytes per work item (default 64 MiB)\n");
+}
+
+int main(int argc, char **argv) {
+    long   threads    = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t chunk_size = DEFAULT_CHUNK;
+    int    first      = 1;
+
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        if (strcmp(argv[first], "-j") == 0 && first + 1 < argc) {
+            threads = strtol(argv[++first], NULL, 10);
+        } else if (strncmp(argv[first], "-j", 2) == 0 && argv[first][2]) {
+            threads = strtol(argv[first] + 2, NULL, 10);
+        } else if (strcmp(argv[first], "--chunk") == 0 && first + 1 < argc) {
+            chunk_size = (size_t)strtoull(argv[++first], NULL, 10);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (first >= argc || threads < 1 || threads > MAX_THREADS || chunk_size == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    build_tables();
+    for (int i = first; i < argc; i++) {
+        if (!add_path(argv[i], chunk_size)) {
+            return 2;
+        }
+    }
+
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    corpus_stats_t *stats = calloc((size_t)threads, sizeof(*stats));
+    pthread_t       workers[MAX_THREADS];
+    for (long i = 0; i < threads; i++) {
+        pthread_create(&workers[i], NULL, worker, &stats[i]);
+    }
+    for (long i = 0; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    if (atomic_load(&failed)) {
+        free(stats);
+        return 2;
+    }
+    for (long i = 1; i < threads; i++) {
+        uint64_t       *total = (uint64_t *)&stats[0];
+        const uint64_t *part  = (const uint64_t *)&stats[i];
+        for (size_t field = 0; field < sizeof(corpus_stats_t) / sizeof(uint64_t); field++) {
+            total[field] += part[field];
+        }
+    }
+
+    for (uint8_t layer = 0; layer < LAYOUT_LAYER_COUNT; layer++) {
+        stats[0].chars += stats[0].layer_chars[layer];
+    }
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            stats[0].presses += stats[0].key_presses[row][col];
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    double seconds = (double)(stop.tv_sec - start.tv_sec) + (double)(stop.tv_nsec - start.tv_nsec) / 1e9;
+
+    print_report(&stats[0]);
+    // Timing on stderr keeps stdout identical across runs and thread counts
+    fprintf(stderr, "%u chunks on %ld threads in %.3f s (%.0f MB/s)\n", chunk_count, threads, seconds,
+            seconds > 0 ? (double)stats[0].bytes / seconds / 1e6 : 0.0);
+
+    free(stats);
+    return 0;
+}
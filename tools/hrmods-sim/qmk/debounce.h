@@ -0,0 +1,12 @@
+/* Copyright 2024
+ * Host-side stand-in for QMK's debounce.h
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+// Filter raw into cooked; true when cooked changed
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed);
+void debounce_init(uint8_t num_rows);
+void debounce_free(void);
@@ -0,0 +1,211 @@
+/* Copyright 2024
+ * Host-side stand-in for QMK keycodes
+ *
+ * Values follow upstream quantum/keycodes.h so encoded keycodes (MT, TD,
+ * LSFT, MO, ...) match the firmware bit for bit.
+ */
+
+#pragma once
+
+// ============================================================================
+// Basic Keycodes
+// ============================================================================
+
+// clang-format off
+enum qk_keycode_defines {
+    KC_NO              = 0x0000,
+    KC_TRANSPARENT     = 0x0001,
+    KC_A               = 0x0004,
+    KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H, KC_I, KC_J, KC_K, KC_L, KC_M,
+    KC_N, KC_O, KC_P, KC_Q, KC_R, KC_S, KC_T, KC_U, KC_V, KC_W, KC_X, KC_Y,
+    KC_Z               = 0x001D,
+    KC_1               = 0x001E,
+    KC_2, KC_3, KC_4, KC_5, KC_6, KC_7, KC_8, KC_9,
+    KC_0               = 0x0027,
+    KC_ENTER           = 0x0028,
+    KC_ESCAPE          = 0x0029,
+    KC_BACKSPACE       = 0x002A,
+    KC_TAB             = 0x002B,
+    KC_SPACE           = 0x002C,
+    KC_MINUS           = 0x002D,
+    KC_EQUAL           = 0x002E,
+    KC_LEFT_BRACKET    = 0x002F,
+    KC_RIGHT_BRACKET   = 0x0030,
+    KC_BACKSLASH       = 0x0031,
+    KC_NONUS_HASH      = 0x0032,
+    KC_SEMICOLON       = 0x0033,
+    KC_QUOTE           = 0x0034,
+    KC_GRAVE           = 0x0035,
+    KC_COMMA           = 0x0036,
+    KC_DOT             = 0x0037,
+    KC_SLASH           = 0x0038,
+    KC_CAPS_LOCK       = 0x0039,
+    KC_F1              = 0x003A,
+    KC_F2, KC_F3, KC_F4, KC_F5, KC_F6, KC_F7, KC_F8, KC_F9, KC_F10, KC_F11,
+    KC_F12             = 0x0045,
+    KC_PRINT_SCREEN    = 0x0046,
+    KC_SCROLL_LOCK     = 0x0047,
+    KC_PAUSE           = 0x0048,
+    KC_INSERT          = 0x0049,
+    KC_HOME            = 0x004A,
+    KC_PAGE_UP         = 0x004B,
+    KC_DELETE          = 0x004C,
+    KC_END             = 0x004D,
+    KC_PAGE_DOWN       = 0x004E,
+    KC_RIGHT           = 0x004F,
+    KC_LEFT            = 0x0050,
+    KC_DOWN            = 0x0051,
+    KC_UP              = 0x0052,
+    KC_AUDIO_MUTE      = 0x00A8,
+    KC_AUDIO_VOL_UP    = 0x00A9,
+    KC_AUDIO_VOL_DOWN  = 0x00AA,
+    KC_BRIGHTNESS_UP   = 0x00BD,
+    KC_BRIGHTNESS_DOWN = 0x00BE,
+    KC_LEFT_CTRL       = 0x00E0,
+    KC_LEFT_SHIFT      = 0x00E1,
+    KC_LEFT_ALT        = 0x00E2,
+    KC_LEFT_GUI        = 0x00E3,
+    KC_RIGHT_CTRL      = 0x00E4,
+    KC_RIGHT_SHIFT     = 0x00E5,
+    KC_RIGHT_ALT       = 0x00E6,
+    KC_RIGHT_GUI       = 0x00E7,
+
+    // Quantum ranges
+    QK_BASIC_MAX       = 0x00FF,
+    QK_MODS            = 0x0100,
+    QK_MODS_MAX        = 0x1FFF,
+    QK_MOD_TAP         = 0x2000,
+    QK_MOD_TAP_MAX     = 0x3FFF,
+    QK_LAYER_TAP       = 0x4000,
+    QK_LAYER_TAP_MAX   = 0x4FFF,
+    QK_MOMENTARY       = 0x5220,
+    QK_MOMENTARY_MAX   = 0x523F,
+    QK_TOGGLE_LAYER    = 0x5260,
+    QK_TOGGLE_LAYER_MAX = 0x527F,
+    QK_TAP_DANCE       = 0x5700,
+    QK_TAP_DANCE_MAX   = 0x57FF,
+
+    RGB_TOG            = 0x7820,
+    RGB_MOD,
+    RGB_RMOD,
+    RGB_HUI,
+    RGB_HUD,
+    RGB_SAI,
+    RGB_SAD,
+    RGB_VAI,
+    RGB_VAD,
+
+    QK_BOOTLOADER      = 0x7C00,
+    QK_GRAVE_ESCAPE    = 0x7C16,
+    QK_SPACE_CADET_LEFT_SHIFT_PARENTHESIS_OPEN   = 0x7C1A,
+    QK_SPACE_CADET_RIGHT_CTRL_PARENTHESIS_CLOSE  = 0x7C19,
+    QK_SPACE_CADET_RIGHT_SHIFT_ENTER             = 0x7C1E,
+
+    QK_KB              = 0x7E00,
+    QK_USER            = 0x7E40,
+};
+// clang-format on
+
+#define SAFE_RANGE QK_USER
+
+// ============================================================================
+// Aliases
+// ============================================================================
+
+#define KC_TRNS KC_TRANSPARENT
+#define XXXXXXX KC_NO
+#define _______ KC_TRANSPARENT
+#define KC_ENT KC_ENTER
+#define KC_ESC KC_ESCAPE
+#define KC_BSPC KC_BACKSPACE
+#define KC_SPC KC_SPACE
+#define KC_MINS KC_MINUS
+#define KC_EQL KC_EQUAL
+#define KC_LBRC KC_LEFT_BRACKET
+#define KC_RBRC KC_RIGHT_BRACKET
+#define KC_BSLS KC_BACKSLASH
+#define KC_SCLN KC_SEMICOLON
+#define KC_QUOT KC_QUOTE
+#define KC_GRV KC_GRAVE
+#define KC_COMM KC_COMMA
+#define KC_SLSH KC_SLASH
+#define KC_PSCR KC_PRINT_SCREEN
+#define KC_DEL KC_DELETE
+#define KC_PGUP KC_PAGE_UP
+#define KC_PGDN KC_PAGE_DOWN
+#define KC_MUTE KC_AUDIO_MUTE
+#define KC_VOLU KC_AUDIO_VOL_UP
+#define KC_VOLD KC_AUDIO_VOL_DOWN
+#define KC_BRIU KC_BRIGHTNESS_UP
+#define KC_BRID KC_BRIGHTNESS_DOWN
+#define KC_LCTL KC_LEFT_CTRL
+#define KC_LSFT KC_LEFT_SHIFT
+#define KC_LALT KC_LEFT_ALT
+#define KC_LGUI KC_LEFT_GUI
+#define KC_RCTL KC_RIGHT_CTRL
+#define KC_RSFT KC_RIGHT_SHIFT
+#define KC_RALT KC_RIGHT_ALT
+#define KC_RGUI KC_RIGHT_GUI
+
+#define QK_BOOT QK_BOOTLOADER
+#define QK_GESC QK_GRAVE_ESCAPE
+#define SC_LSPO QK_SPACE_CADET_LEFT_SHIFT_PARENTHESIS_OPEN
+#define SC_RCPC QK_SPACE_CADET_RIGHT_CTRL_PARENTHESIS_CLOSE
+#define SC_SENT QK_SPACE_CADET_RIGHT_SHIFT_ENTER
+
+// ============================================================================
+// Modifiers
+// ============================================================================
+
+#define MOD_LCTL 0x01
+#define MOD_LSFT 0x02
+#define MOD_LALT 0x04
+#define MOD_LGUI 0x08
+#define MOD_RCTL 0x11
+#define MOD_RSFT 0x12
+#define MOD_RALT 0x14
+#define MOD_RGUI 0x18
+
+#define MOD_BIT(kc) (1 << ((kc)&0x07))
+#define MOD_MASK_CTRL (MOD_BIT(KC_LCTL) | MOD_BIT(KC_RCTL))
+#define MOD_MASK_SHIFT (MOD_BIT(KC_LSFT) | MOD_BIT(KC_RSFT))
+#define MOD_MASK_ALT (MOD_BIT(KC_LALT) | MOD_BIT(KC_RALT))
+#define MOD_MASK_GUI (MOD_BIT(KC_LGUI) | MOD_BIT(KC_RGUI))
+
+#define LCTL(kc) ((0x01 << 8) | (kc))
+#define LSFT(kc) ((0x02 << 8) | (kc))
+#define LALT(kc) ((0x04 << 8) | (kc))
+#define LGUI(kc) ((0x08 << 8) | (kc))
+#define RCTL(kc) ((0x11 << 8) | (kc))
+#define RSFT(kc) ((0x12 << 8) | (kc))
+#define RALT(kc) ((0x14 << 8) | (kc))
+#define RGUI(kc) ((0x18 << 8) | (kc))
+
+// ============================================================================
+// Quantum Keycode Encoders / Decoders
+// ============================================================================
+
+#define MT(mod, kc) (QK_MOD_TAP | (((mod)&0x1F) << 8) | ((kc)&0xFF))
+#define MO(layer) (QK_MOMENTARY | ((layer)&0x1F))
+#define TG(layer) (QK_TOGGLE_LAYER | ((layer)&0x1F))
+#define TD(index) (QK_TAP_DANCE | ((index)&0xFF))
+
+#define IS_BASIC_KEYCODE(code) ((code) >= KC_A && (code) <= 0x00A4)
+#define IS_MODIFIER_KEYCODE(code) ((code) >= KC_LEFT_CTRL && (code) <= KC_RIGHT_GUI)
+#define IS_QK_BASIC(code) ((code) <= QK_BASIC_MAX)
+#define IS_QK_MODS(code) ((code) >= QK_MODS && (code) <= QK_MODS_MAX)
+#define IS_QK_MOD_TAP(code) ((code) >= QK_MOD_TAP && (code) <= QK_MOD_TAP_MAX)
+#define IS_QK_LAYER_TAP(code) ((code) >= QK_LAYER_TAP && (code) <= QK_LAYER_TAP_MAX)
+#define IS_QK_MOMENTARY(code) ((code) >= QK_MOMENTARY && (code) <= QK_MOMENTARY_MAX)
+#define IS_QK_TOGGLE_LAYER(code) ((code) >= QK_TOGGLE_LAYER && (code) <= QK_TOGGLE_LAYER_MAX)
+#define IS_QK_TAP_DANCE(code) ((code) >= QK_TAP_DANCE && (code) <= QK_TAP_DANCE_MAX)
+
+#define QK_MODS_GET_MODS(kc) (((kc) >> 8) & 0x1F)
+#define QK_MODS_GET_BASIC_KEYCODE(kc) ((kc)&0xFF)
+#define QK_MOD_TAP_GET_MODS(kc) (((kc) >> 8) & 0x1F)
+#define QK_MOD_TAP_GET_TAP_KEYCODE(kc) ((kc)&0xFF)
+#define QK_LAYER_TAP_GET_LAYER(kc) (((kc) >> 8) & 0xF)
+#define QK_LAYER_TAP_GET_TAP_KEYCODE(kc) ((kc)&0xFF)
+#define QK_MOMENTARY_GET_LAYER(kc) ((kc)&0x1F)
+#define QK_TOGGLE_LAYER_GET_LAYER(kc) ((kc)&0x1F)
+#define QK_TAP_DANCE_GET_INDEX(kc) ((kc)&0xFF)
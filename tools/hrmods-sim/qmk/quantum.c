@@ -0,0 +1,1162 @@
+/* Copyright 2024
+ * Host-side stand-in for the QMK runtime
+ *
+ * A deliberately small model of the parts of QMK the custom_hrmods keymap
+ * depends on: global debounce, the action_tapping hold/tap state machine
+ * (PERMISSIVE_HOLD, HOLD_ON_OTHER_KEY_PRESS, per-key tapping term), the
+ * process_record chain, layers, tap dance, send_string and the HID report.
+ *
+ * Blocking behaviour is modelled on the simulated clock: every HID report
+ * occupies one USB poll slot, so firmware that sends many reports in a row
+ * (SEND_STRING) stalls the scan loop just like on the RP2040.
+ */
+
+#include "sim.h"
+#include "transactions.h"
+#include "debounce.h"
+#include "features/combo_engine.h"
+#include "features/macro_queue.h"
+
+#include <time.h>
+
+#ifdef __x86_64__
+#    include <x86intrin.h>
+#endif
+
+uint32_t sim_now             = 0;
+uint32_t sim_sleep_until     = 0;
+int      sim_current_origin  = -1;
+bool     sim_is_master       = true;
+bool     sim_split_connected = false;
+
+uint64_t sim_cycles(void) {
+#ifdef __x86_64__
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// ============================================================================
+// Timers
+// ============================================================================
+
+void wait_ms(uint16_t ms) {
+    sim_now += ms;
+}
+
+uint16_t timer_read(void) {
+    return (uint16_t)sim_now;
+}
+
+uint32_t timer_read32(void) {
+    return sim_now;
+}
+
+uint16_t timer_elapsed(uint16_t last) {
+    return (uint16_t)(timer_read() - last);
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return timer_read32() - last;
+}
+
+void sim_wait_for_edge(uint16_t ms) {
+    sim_sleep_until = sim_now + ms;
+}
+
+uint32_t sim_clock_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u);
+}
+
+bool is_keyboard_master(void) {
+    return sim_is_master;
+}
+
+bool is_keyboard_left(void) {
+    return true;
+}
+
+// ============================================================================
+// EEPROM
+// ============================================================================
+
+// The RP2040 has no EEPROM: QMK's wear leveling keeps the image in RAM and
+// appends every change to a write log in flash. When the log is full it is
+// consolidated: the backing sectors are erased and the image is programmed
+// afresh. Modelled closely enough to compare write patterns: a write logs
+// one entry per 8-byte-aligned chunk it changes.
+#define FLASH_BACKING_SIZE 8192
+#define FLASH_SECTOR_SIZE 4096
+#define FLASH_LOG_SIZE (FLASH_BACKING_SIZE - EEPROM_SIZE)
+#define FLASH_LOG_ENTRY 8
+#define EECONFIG_USER_ADDR 32
+
+_Static_assert(DYNAMIC_KEYMAP_EEPROM_ADDR >= EECONFIG_USER_ADDR + 4, "dynamic keymap overlaps the user word");
+_Static_assert(DYNAMIC_KEYMAP_EEPROM_ADDR + DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2 <= EEPROM_SIZE,
+               "dynamic keymap does not fit the EEPROM");
+
+static uint8_t  eeprom[EEPROM_SIZE];
+static uint32_t flash_log_used;
+
+uint32_t sim_eeprom_writes = 0;
+uint32_t sim_flash_writes  = 0;
+uint32_t sim_flash_erases  = 0;
+
+static void flash_log_append(void) {
+    if (flash_log_used + FLASH_LOG_ENTRY > FLASH_LOG_SIZE) {
+        sim_flash_erases += FLASH_BACKING_SIZE / FLASH_SECTOR_SIZE;
+        sim_flash_writes++;
+        flash_log_used = 0;
+    }
+    flash_log_used += FLASH_LOG_ENTRY;
+    sim_flash_writes++;
+}
+
+// eeprom_update_* only write when the stored data changes
+static void eeprom_write(uintptr_t addr, const uint8_t *data, size_t len) {
+    if (addr + len > EEPROM_SIZE || memcmp(&eeprom[addr], data, len) == 0) {
+        return;
+    }
+    for (uintptr_t chunk = addr & ~(uintptr_t)7; chunk < addr + len; chunk += 8) {
+        uintptr_t from = chunk > addr ? chunk : addr;
+        uintptr_t to   = chunk + 8 < addr + len ? chunk + 8 : addr + len;
+        if (memcmp(&eeprom[from], data + (from - addr), to - from) != 0) {
+            flash_log_append();
+        }
+    }
+    memcpy(&eeprom[addr], data, len);
+    sim_eeprom_writes++;
+}
+
+uint8_t eeprom_read_byte(const uint8_t *addr) {
+    uintptr_t offset = (uintptr_t)addr;
+    return offset < EEPROM_SIZE ? eeprom[offset] : 0;
+}
+
+void eeprom_update_byte(uint8_t *addr, uint8_t value) {
+    eeprom_write((uintptr_t)addr, &value, 1);
+}
+
+uint32_t eeprom_read_dword(const uint32_t *addr) {
+    uint32_t value = 0;
+    eeprom_read_block(&value, addr, sizeof(value));
+    return value;
+}
+
+void eeprom_update_dword(uint32_t *addr, uint32_t value) {
+    eeprom_write((uintptr_t)addr, (const uint8_t *)&value, sizeof(value));
+}
+
+void eeprom_read_block(void *buf, const void *addr, size_t len) {
+    uintptr_t offset = (uintptr_t)addr;
+    if (offset + len <= EEPROM_SIZE) {
+        memcpy(buf, &eeprom[offset], len);
+    }
+}
+
+void eeprom_update_block(const void *buf, void *addr, size_t len) {
+    eeprom_write((uintptr_t)addr, buf, len);
+}
+
+uint32_t eeconfig_read_user(void) {
+    return eeprom_read_dword((const uint32_t *)EECONFIG_USER_ADDR);
+}
+
+void eeconfig_update_user(uint32_t val) {
+    eeprom_update_dword((uint32_t *)EECONFIG_USER_ADDR, val);
+}
+
+// ============================================================================
+// Weak User Hooks
+// ============================================================================
+
+__attribute__((weak)) bool pre_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    return true;
+}
+
+__attribute__((weak)) bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    return true;
+}
+
+__attribute__((weak)) void post_process_record_user(uint16_t keycode, keyrecord_t *record) {}
+
+__attribute__((weak)) uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record) {
+    return TAPPING_TERM;
+}
+
+__attribute__((weak)) bool get_hold_on_other_key_press(uint16_t keycode, keyrecord_t *record) {
+    return false;
+}
+
+__attribute__((weak)) bool get_permissive_hold(uint16_t keycode, keyrecord_t *record) {
+    return false;
+}
+
+__attribute__((weak)) void keyboard_post_init_user(void) {}
+
+__attribute__((weak)) void eeconfig_init_user(void) {}
+
+__attribute__((weak)) void housekeeping_task_user(void) {}
+
+__attribute__((weak)) void matrix_scan_user(void) {}
+
+// ============================================================================
+// Keymap and Layers
+// ============================================================================
+
+layer_state_t layer_state = 0;
+
+static uint8_t source_layer[MATRIX_ROWS][MATRIX_COLS];
+
+// Vial keeps the active keymap in (emulated) EEPROM; so does the sim.
+// Private, like in QMK's nvm backend: the keymap reaches it through the
+// dynamic_keymap_* calls only
+static void *dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t column) {
+    return (void *)(uintptr_t)(DYNAMIC_KEYMAP_EEPROM_ADDR + ((layer * MATRIX_ROWS + row) * MATRIX_COLS + column) * 2);
+}
+
+uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column) {
+    const uint8_t *addr = dynamic_keymap_key_to_eeprom_address(layer, row, column);
+    return (uint16_t)(eeprom_read_byte(addr) << 8 | eeprom_read_byte(addr + 1));
+}
+
+void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode) {
+    uint8_t *addr = dynamic_keymap_key_to_eeprom_address(layer, row, column);
+    eeprom_update_byte(addr, keycode >> 8);
+    eeprom_update_byte(addr + 1, keycode & 0xFF);
+}
+
+void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
+    uint16_t keymap_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
+    uint8_t *addr        = (uint8_t *)(uintptr_t)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
+
+    for (uint16_t i = 0; i < size && offset + i < keymap_size; i++) {
+        eeprom_update_byte(addr + i, data[i]);
+    }
+}
+
+void dynamic_keymap_reset(void) {
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                dynamic_keymap_set_keycode(layer, row, col, keymaps[layer][row][col]);
+            }
+        }
+    }
+}
+
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
+    if (layer >= DYNAMIC_KEYMAP_LAYER_COUNT || key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return KC_NO;
+    }
+    return dynamic_keymap_get_keycode(layer, key.row, key.col);
+}
+
+uint8_t get_highest_layer(layer_state_t state) {
+    uint8_t layer = 0;
+    while (state >>= 1) {
+        layer++;
+    }
+    return layer;
+}
+
+bool layer_state_is(uint8_t layer) {
+    return layer == 0 ? true : (layer_state & (1UL << layer)) != 0;
+}
+
+void layer_on(uint8_t layer) {
+    layer_state |= 1UL << layer;
+}
+
+void layer_off(uint8_t layer) {
+    layer_state &= ~(1UL << layer);
+}
+
+void layer_invert(uint8_t layer) {
+    layer_state ^= 1UL << layer;
+}
+
+void layer_clear(void) {
+    layer_state = 0;
+}
+
+// Resolve the keycode for an event, honouring the layer a key was pressed on
+static uint16_t event_keycode(keyevent_t event) {
+    uint8_t row = event.key.row;
+    uint8_t col = event.key.col;
+
+    if (event.pressed) {
+        layer_state_t layers = layer_state | 1;
+        for (int8_t layer = DYNAMIC_KEYMAP_LAYER_COUNT - 1; layer >= 0; layer--) {
+            if (!(layers & (1UL << layer))) {
+                continue;
+            }
+            uint16_t keycode = keymap_key_to_keycode(layer, event.key);
+            if (keycode != KC_TRNS) {
+                source_layer[row][col] = layer;
+                return keycode;
+            }
+        }
+        source_layer[row][col] = 0;
+    }
+    return keymap_key_to_keycode(source_layer[row][col], event.key);
+}
+
+// The sim resolves keycodes once per event, so records always carry one
+uint16_t get_record_keycode(keyrecord_t *record, bool update_layer_cache) {
+    (void)update_layer_cache;
+    return record->keycode;
+}
+
+// ============================================================================
+// VIA / Vial Raw HID
+// ============================================================================
+
+#ifdef VIA_ENABLE
+
+__attribute__((weak)) bool via_command_kb(uint8_t *data, uint8_t length) {
+    return false;
+}
+
+void raw_hid_send(uint8_t *data, uint8_t length) {
+    sim_on_raw_hid(data, length);
+}
+
+// The dynamic keymap subset of VIA's command handler
+void raw_hid_receive(uint8_t *data, uint8_t length) {
+    if (via_command_kb(data, length)) {
+        return;
+    }
+
+    switch (data[0]) {
+        case id_dynamic_keymap_get_keycode:
+            if (data[1] < DYNAMIC_KEYMAP_LAYER_COUNT && data[2] < MATRIX_ROWS && data[3] < MATRIX_COLS) {
+                uint16_t keycode = dynamic_keymap_get_keycode(data[1], data[2], data[3]);
+                data[4]          = keycode >> 8;
+                data[5]          = keycode & 0xFF;
+            }
+            break;
+        case id_dynamic_keymap_set_keycode:
+            if (data[1] < DYNAMIC_KEYMAP_LAYER_COUNT && data[2] < MATRIX_ROWS && data[3] < MATRIX_COLS) {
+                dynamic_keymap_set_keycode(data[1], data[2], data[3], (uint16_t)(data[4] << 8 | data[5]));
+            }
+            break;
+        case id_dynamic_keymap_reset:
+            dynamic_keymap_reset();
+            break;
+        case id_dynamic_keymap_set_buffer: {
+            // Big-endian keycodes at a byte offset into the flattened keymap
+            uint16_t offset = (uint16_t)(data[1] << 8 | data[2]);
+            uint8_t  size   = data[3];
+
+            dynamic_keymap_set_buffer(offset, size < length - 4 ? size : length - 4, &data[4]);
+            break;
+        }
+        case id_eeprom_reset:
+            dynamic_keymap_reset();
+            eeconfig_init_user();
+            break;
+        default:
+            data[0] = id_unhandled;
+            break;
+    }
+    raw_hid_send(data, length);
+}
+
+#endif // VIA_ENABLE
+
+// ============================================================================
+// Split Transactions
+// ============================================================================
+
+#ifdef SPLIT_KEYBOARD
+
+static slave_callback_t rpc_handlers[NUM_TOTAL_TRANSACTIONS];
+
+void transaction_register_rpc(int8_t transaction_id, slave_callback_t callback) {
+    if (transaction_id >= 0 && transaction_id < NUM_TOTAL_TRANSACTIONS) {
+        rpc_handlers[transaction_id] = callback;
+    }
+}
+
+bool transaction_rpc_send(int8_t transaction_id, uint8_t initiator2target_buffer_size, const void *initiator2target_buffer) {
+    if (!sim_is_master) {
+        return false;
+    }
+    return sim_on_split_rpc(transaction_id, initiator2target_buffer_size, initiator2target_buffer);
+}
+
+bool is_transport_connected(void) {
+    return sim_split_connected;
+}
+
+void sim_split_rpc_receive(int8_t transaction_id, uint8_t length, const void *data) {
+    if (transaction_id >= 0 && transaction_id < NUM_TOTAL_TRANSACTIONS && rpc_handlers[transaction_id]) {
+        rpc_handlers[transaction_id](length, data, 0, NULL);
+    }
+}
+
+#endif // SPLIT_KEYBOARD
+
+// ============================================================================
+// HID Report
+// ============================================================================
+
+static sim_report_t report;
+static sim_report_t sent_report;
+static uint32_t     usb_next_slot = 0;
+
+void send_keyboard_report(void) {
+    if (memcmp(&report, &sent_report, sizeof(report)) == 0) {
+        return;
+    }
+    // One report per USB poll; the firmware blocks until the endpoint frees up
+    if (sim_now < usb_next_slot) {
+        sim_now = usb_next_slot;
+    }
+    usb_next_slot = sim_now + USB_POLLING_INTERVAL_MS;
+    sent_report   = report;
+    sim_on_report(&report);
+}
+
+static uint8_t mod_config(uint8_t mods) {
+    // 5-bit mod encoding (bit 4 = right hand) to 8-bit HID modifier byte
+    return (mods & 0x10) ? (uint8_t)((mods & 0x0F) << 4) : (uint8_t)(mods & 0x0F);
+}
+
+uint8_t get_mods(void) {
+    return report.mods;
+}
+
+void add_mods(uint8_t mods) {
+    report.mods |= mods;
+}
+
+void del_mods(uint8_t mods) {
+    report.mods &= ~mods;
+}
+
+void set_mods(uint8_t mods) {
+    report.mods = mods;
+}
+
+void clear_mods(void) {
+    report.mods = 0;
+}
+
+void register_mods(uint8_t mods) {
+    add_mods(mods);
+    send_keyboard_report();
+}
+
+void unregister_mods(uint8_t mods) {
+    del_mods(mods);
+    send_keyboard_report();
+}
+
+void register_code(uint8_t kc) {
+    if (kc == KC_NO) {
+        return;
+    }
+    if (IS_MODIFIER_KEYCODE(kc)) {
+        report.mods |= MOD_BIT(kc);
+    } else {
+        report.keys[kc >> 3] |= (uint8_t)(1 << (kc & 7));
+    }
+    send_keyboard_report();
+}
+
+void unregister_code(uint8_t kc) {
+    if (kc == KC_NO) {
+        return;
+    }
+    if (IS_MODIFIER_KEYCODE(kc)) {
+        report.mods &= ~MOD_BIT(kc);
+    } else {
+        report.keys[kc >> 3] &= (uint8_t) ~(1 << (kc & 7));
+    }
+    send_keyboard_report();
+}
+
+void tap_code(uint8_t kc) {
+    register_code(kc);
+    wait_ms(TAP_CODE_DELAY);
+    unregister_code(kc);
+}
+
+void register_code16(uint16_t kc) {
+    if (IS_QK_MODS(kc)) {
+        register_mods(mod_config(QK_MODS_GET_MODS(kc)));
+    }
+    // Like QMK, anything above the basic range is truncated to 8 bits here
+    register_code((uint8_t)kc);
+}
+
+void unregister_code16(uint16_t kc) {
+    unregister_code((uint8_t)kc);
+    if (IS_QK_MODS(kc)) {
+        unregister_mods(mod_config(QK_MODS_GET_MODS(kc)));
+    }
+}
+
+void tap_code16(uint16_t kc) {
+    register_code16(kc);
+    wait_ms(TAP_CODE_DELAY);
+    unregister_code16(kc);
+}
+
+// ============================================================================
+// Send String
+// ============================================================================
+
+// clang-format off
+// Bit-packed, LSB first (KCLUT_ENTRY order in upstream send_string.c)
+const uint8_t ascii_to_shift_lut[16] = {
+    0x00, 0x00, 0x00, 0x00, 0x7E, 0x0F, 0x00, 0xD4,
+    0xFF, 0xFF, 0xFF, 0xC7, 0x00, 0x00, 0x00, 0x78,
+};
+
+const uint8_t ascii_to_keycode_lut[128] = {
+    ['\b'] = KC_BSPC, ['\t'] = KC_TAB, ['\n'] = KC_ENT, [0x1B] = KC_ESC,
+    [' '] = KC_SPC, ['!'] = KC_1, ['"'] = KC_QUOT, ['#'] = KC_3, ['$'] = KC_4,
+    ['%'] = KC_5, ['&'] = KC_7, ['\''] = KC_QUOT, ['('] = KC_9, [')'] = KC_0,
+    ['*'] = KC_8, ['+'] = KC_EQL, [','] = KC_COMM, ['-'] = KC_MINS, ['.'] = KC_DOT,
+    ['/'] = KC_SLSH, ['0'] = KC_0, ['1'] = KC_1, ['2'] = KC_2, ['3'] = KC_3,
+    ['4'] = KC_4, ['5'] = KC_5, ['6'] = KC_6, ['7'] = KC_7, ['8'] = KC_8,
+    ['9'] = KC_9, [':'] = KC_SCLN, [';'] = KC_SCLN, ['<'] = KC_COMM, ['='] = KC_EQL,
+    ['>'] = KC_DOT, ['?'] = KC_SLSH, ['@'] = KC_2,
+    ['A'] = KC_A, ['B'] = KC_B, ['C'] = KC_C, ['D'] = KC_D, ['E'] = KC_E, ['F'] = KC_F,
+    ['G'] = KC_G, ['H'] = KC_H, ['I'] = KC_I, ['J'] = KC_J, ['K'] = KC_K, ['L'] = KC_L,
+    ['M'] = KC_M, ['N'] = KC_N, ['O'] = KC_O, ['P'] = KC_P, ['Q'] = KC_Q, ['R'] = KC_R,
+    ['S'] = KC_S, ['T'] = KC_T, ['U'] = KC_U, ['V'] = KC_V, ['W'] = KC_W, ['X'] = KC_X,
+    ['Y'] = KC_Y, ['Z'] = KC_Z,
+    ['['] = KC_LBRC, ['\\'] = KC_BSLS, [']'] = KC_RBRC, ['^'] = KC_6, ['_'] = KC_MINS,
+    ['`'] = KC_GRV,
+    ['a'] = KC_A, ['b'] = KC_B, ['c'] = KC_C, ['d'] = KC_D, ['e'] = KC_E, ['f'] = KC_F,
+    ['g'] = KC_G, ['h'] = KC_H, ['i'] = KC_I, ['j'] = KC_J, ['k'] = KC_K, ['l'] = KC_L,
+    ['m'] = KC_M, ['n'] = KC_N, ['o'] = KC_O, ['p'] = KC_P, ['q'] = KC_Q, ['r'] = KC_R,
+    ['s'] = KC_S, ['t'] = KC_T, ['u'] = KC_U, ['v'] = KC_V, ['w'] = KC_W, ['x'] = KC_X,
+    ['y'] = KC_Y, ['z'] = KC_Z,
+    ['{'] = KC_LBRC, ['|'] = KC_BSLS, ['}'] = KC_RBRC, ['~'] = KC_GRV,
+};
+// clang-format on
+
+static void send_char(char ascii_code) {
+    uint8_t c       = (uint8_t)ascii_code & 0x7F;
+    uint8_t keycode = pgm_read_byte(&ascii_to_keycode_lut[c]);
+    bool    shifted = PGM_LOADBIT(ascii_to_shift_lut, c);
+
+    if (shifted) {
+        register_code(KC_LSFT);
+    }
+    tap_code(keycode);
+    if (shifted) {
+        unregister_code(KC_LSFT);
+    }
+}
+
+void send_string(const char *string) {
+    while (*string) {
+        char ascii_code = *string++;
+        if (ascii_code == SS_QMK_PREFIX) {
+            char code = *string++;
+            if (code == SS_TAP_CODE) {
+                tap_code((uint8_t)*string++);
+            } else if (code == SS_DOWN_CODE) {
+                register_code((uint8_t)*string++);
+            } else if (code == SS_UP_CODE) {
+                unregister_code((uint8_t)*string++);
+            } else if (code == SS_DELAY_CODE) {
+                uint16_t ms = 0;
+                while (*string >= '0' && *string <= '9') {
+                    ms = (uint16_t)(ms * 10 + (*string++ - '0'));
+                }
+                if (*string == '|') {
+                    string++;
+                }
+                wait_ms(ms);
+            }
+        } else {
+            send_char(ascii_code);
+        }
+    }
+}
+
+void send_string_P(const char *string) {
+    send_string(string);
+}
+
+// ============================================================================
+// Tap Dance
+// ============================================================================
+
+#ifdef TAP_DANCE_ENABLE
+
+#    define TAP_DANCE_MAX 32
+
+static tap_dance_state_t tap_dance_states[TAP_DANCE_MAX];
+static uint16_t          active_td = 0;
+static uint16_t          last_td_time;
+
+void tap_dance_pair_on_each_tap(tap_dance_state_t *state, void *user_data) {
+    tap_dance_pair_t *pair = (tap_dance_pair_t *)user_data;
+
+    if (state->count == 2) {
+        register_code16(pair->kc2);
+        state->finished = true;
+    }
+}
+
+void tap_dance_pair_finished(tap_dance_state_t *state, void *user_data) {
+    tap_dance_pair_t *pair = (tap_dance_pair_t *)user_data;
+
+    register_code16(state->count == 1 ? pair->kc1 : pair->kc2);
+}
+
+void tap_dance_pair_reset(tap_dance_state_t *state, void *user_data) {
+    tap_dance_pair_t *pair = (tap_dance_pair_t *)user_data;
+
+    if (state->count == 1) {
+        wait_ms(TAP_CODE_DELAY);
+    }
+    unregister_code16(state->count == 1 ? pair->kc1 : pair->kc2);
+}
+
+static void tap_dance_finish(uint8_t index) {
+    tap_dance_action_t *action = &tap_dance_actions[index];
+    tap_dance_state_t  *state  = &tap_dance_states[index];
+
+    if (state->finished) {
+        return;
+    }
+    state->finished = true;
+    if (action->fn.on_dance_finished) {
+        action->fn.on_dance_finished(state, action->user_data);
+    }
+}
+
+static void tap_dance_reset(uint8_t index) {
+    tap_dance_action_t *action = &tap_dance_actions[index];
+    tap_dance_state_t  *state  = &tap_dance_states[index];
+
+    if (action->fn.on_reset) {
+        action->fn.on_reset(state, action->user_data);
+    }
+    memset(state, 0, sizeof(*state));
+    if (active_td == QK_TAP_DANCE + index) {
+        active_td = 0;
+    }
+}
+
+static void preprocess_tap_dance(uint16_t keycode, keyrecord_t *record) {
+    if (!active_td || keycode == active_td || !record->event.pressed) {
+        return;
+    }
+
+    uint8_t            index = QK_TAP_DANCE_GET_INDEX(active_td);
+    tap_dance_state_t *state = &tap_dance_states[index];
+
+    state->interrupted          = true;
+    state->interrupting_keycode = keycode;
+    tap_dance_finish(index);
+    if (!state->pressed) {
+        tap_dance_reset(index);
+    }
+}
+
+static bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
+    if (!IS_QK_TAP_DANCE(keycode)) {
+        return true;
+    }
+
+    uint8_t             index  = QK_TAP_DANCE_GET_INDEX(keycode);
+    tap_dance_action_t *action = &tap_dance_actions[index];
+    tap_dance_state_t  *state  = &tap_dance_states[index];
+
+    if (record->event.pressed) {
+        state->pressed = true;
+        state->count++;
+        last_td_time = record->event.time;
+        active_td    = keycode;
+        if (action->fn.on_each_tap) {
+            action->fn.on_each_tap(state, action->user_data);
+        }
+    } else {
+        state->pressed = false;
+        if (action->fn.on_each_release) {
+            action->fn.on_each_release(state, action->user_data);
+        }
+        if (state->finished) {
+            tap_dance_reset(index);
+        }
+    }
+    return false;
+}
+
+static void tap_dance_task(void) {
+    if (!active_td) {
+        return;
+    }
+
+    uint8_t            index  = QK_TAP_DANCE_GET_INDEX(active_td);
+    tap_dance_state_t *state  = &tap_dance_states[index];
+    keyrecord_t        record = {0};
+    uint16_t           term;
+
+    SIM_TIMED(SIM_HOOK_TAPPING_TERM, term = get_tapping_term(active_td, &record));
+    if (!state->finished && timer_elapsed(last_td_time) > term) {
+        tap_dance_finish(index);
+        if (!state->pressed) {
+            tap_dance_reset(index);
+        }
+    }
+}
+
+#endif // TAP_DANCE_ENABLE
+
+// ============================================================================
+// Record Processing
+// ============================================================================
+
+typedef struct {
+    keyrecord_t record;
+    int         origin;
+} sim_record_t;
+
+static bool process_record_quantum(keyrecord_t *record) {
+    uint16_t keycode = record->keycode;
+    bool     result;
+
+#ifdef TAP_DANCE_ENABLE
+    preprocess_tap_dance(keycode, record);
+#endif
+
+    SIM_TIMED(SIM_HOOK_PROCESS_RECORD, result = process_record_user(keycode, record));
+    if (!result) {
+        return false;
+    }
+
+#ifdef TAP_DANCE_ENABLE
+    if (!process_tap_dance(keycode, record)) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+static void process_action(keyrecord_t *record) {
+    uint16_t keycode = record->keycode;
+    bool     pressed = record->event.pressed;
+
+    if (IS_QK_MOD_TAP(keycode)) {
+        uint8_t mods = mod_config(QK_MOD_TAP_GET_MODS(keycode));
+        uint8_t tap  = QK_MOD_TAP_GET_TAP_KEYCODE(keycode);
+        if (pressed) {
+            sim_on_mod_tap(record->event.key, record->tap.count > 0);
+        }
+        if (record->tap.count > 0) {
+            pressed ? register_code(tap) : unregister_code(tap);
+        } else {
+            pressed ? register_mods(mods) : unregister_mods(mods);
+        }
+    } else if (IS_QK_LAYER_TAP(keycode)) {
+        uint8_t layer = QK_LAYER_TAP_GET_LAYER(keycode);
+        uint8_t tap   = QK_LAYER_TAP_GET_TAP_KEYCODE(keycode);
+        if (record->tap.count > 0) {
+            pressed ? register_code(tap) : unregister_code(tap);
+        } else {
+            pressed ? layer_on(layer) : layer_off(layer);
+        }
+    } else if (IS_QK_MOMENTARY(keycode)) {
+        pressed ? layer_on(QK_MOMENTARY_GET_LAYER(keycode)) : layer_off(QK_MOMENTARY_GET_LAYER(keycode));
+    } else if (IS_QK_TOGGLE_LAYER(keycode)) {
+        if (pressed) {
+            layer_invert(QK_TOGGLE_LAYER_GET_LAYER(keycode));
+        }
+    } else if (IS_QK_MODS(keycode)) {
+        pressed ? register_code16(keycode) : unregister_code16(keycode);
+    } else if (IS_QK_BASIC(keycode)) {
+        pressed ? register_code((uint8_t)keycode) : unregister_code((uint8_t)keycode);
+    }
+    // Everything else (RGB, bootloader, space cadet, user keycodes) has no
+    // default action in this model
+}
+
+static void process_sim_record(sim_record_t *r) {
+    keyrecord_t *record = &r->record;
+
+    sim_current_origin = r->origin;
+    if (process_record_quantum(record)) {
+        process_action(record);
+    }
+    post_process_record_user(record->keycode, record);
+    sim_current_origin = -1;
+}
+
+void process_record(keyrecord_t *record) {
+    sim_record_t r = {
+        .record = *record,
+        .origin = sim_origin_for(record->event.key, record->event.pressed),
+    };
+
+    process_sim_record(&r);
+}
+
+// ============================================================================
+// Action Tapping (hold/tap decisions)
+// ============================================================================
+
+#define WAITING_BUFFER_SIZE 8
+
+static sim_record_t tapping_key;
+static bool         tapping_active = false;
+static sim_record_t waiting_buffer[WAITING_BUFFER_SIZE];
+static uint8_t      waiting_count = 0;
+static uint8_t      key_tap_count[MATRIX_ROWS][MATRIX_COLS];
+
+static void tapping_process(sim_record_t r);
+
+static bool is_tap_keycode(uint16_t keycode) {
+    return IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode);
+}
+
+static bool same_key(const keyrecord_t *a, const keyrecord_t *b) {
+    return a->event.key.row == b->event.key.row && a->event.key.col == b->event.key.col;
+}
+
+static bool waiting_buffer_has_press(const keyrecord_t *record) {
+    for (uint8_t i = 0; i < waiting_count; i++) {
+        if (waiting_buffer[i].record.event.pressed && same_key(&waiting_buffer[i].record, record)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void waiting_buffer_add(sim_record_t r) {
+    if (waiting_count < WAITING_BUFFER_SIZE) {
+        waiting_buffer[waiting_count++] = r;
+    } else {
+        // QMK drops events when the buffer overflows; process instead of losing them
+        process_sim_record(&r);
+    }
+}
+
+// Settle the pending tapping key and replay everything buffered behind it
+static void tapping_resolve(uint8_t count, sim_record_t *release) {
+    sim_record_t pending[WAITING_BUFFER_SIZE];
+    uint8_t      pending_count = waiting_count;
+    keypos_t     key           = tapping_key.record.event.key;
+
+    memcpy(pending, waiting_buffer, sizeof(pending[0]) * pending_count);
+    waiting_count  = 0;
+    tapping_active = false;
+
+    tapping_key.record.tap.count = count;
+    process_sim_record(&tapping_key);
+    if (release) {
+        release->record.tap.count = count;
+        process_sim_record(release);
+    } else {
+        key_tap_count[key.row][key.col] = count;
+    }
+
+    for (uint8_t i = 0; i < pending_count; i++) {
+        tapping_process(pending[i]);
+    }
+}
+
+static uint16_t tapping_term_for(sim_record_t *r) {
+    uint16_t term;
+
+    sim_current_origin = r->origin;
+#ifdef TAPPING_TERM_PER_KEY
+    SIM_TIMED(SIM_HOOK_TAPPING_TERM, term = get_tapping_term(r->record.keycode, &r->record));
+#else
+    term = TAPPING_TERM;
+#endif
+    sim_current_origin = -1;
+    return term;
+}
+
+static void tapping_process(sim_record_t r) {
+    keyrecord_t *record = &r.record;
+
+    if (!tapping_active) {
+        if (record->event.type == KEY_EVENT && record->event.pressed && is_tap_keycode(record->keycode)) {
+            tapping_key    = r;
+            tapping_active = true;
+            return;
+        }
+        if (record->event.type == KEY_EVENT) {
+            process_sim_record(&r);
+        }
+        return;
+    }
+
+    uint16_t now     = record->event.type == KEY_EVENT ? record->event.time : timer_read();
+    uint16_t elapsed = (uint16_t)(now - tapping_key.record.event.time);
+    uint16_t term    = tapping_term_for(&tapping_key);
+
+    if (record->event.type != KEY_EVENT) {
+        if (elapsed >= term) {
+            tapping_resolve(0, NULL);
+        }
+        return;
+    }
+
+    if (same_key(record, &tapping_key.record)) {
+        if (!record->event.pressed) {
+            tapping_resolve(elapsed < term ? 1 : 0, &r);
+        }
+        return;
+    }
+
+    if (record->event.pressed) {
+#ifdef HOLD_ON_OTHER_KEY_PRESS_PER_KEY
+        if (get_hold_on_other_key_press(tapping_key.record.keycode, &tapping_key.record)) {
+            tapping_resolve(0, NULL);
+            tapping_process(r);
+            return;
+        }
+#endif
+        waiting_buffer_add(r);
+        return;
+    }
+
+    // Release of some other key
+    if (waiting_buffer_has_press(record)) {
+#if defined(PERMISSIVE_HOLD) || defined(PERMISSIVE_HOLD_PER_KEY)
+#    ifdef PERMISSIVE_HOLD_PER_KEY
+        bool permissive = get_permissive_hold(tapping_key.record.keycode, &tapping_key.record);
+#    else
+        bool permissive = true;
+#    endif
+        if (permissive) {
+            waiting_buffer_add(r);
+            tapping_resolve(0, NULL);
+            return;
+        }
+#endif
+        waiting_buffer_add(r);
+        return;
+    }
+    // Key went down before the tapping key; let it go straight through
+    process_sim_record(&r);
+}
+
+void action_tapping_process(keyrecord_t record) {
+    sim_record_t r = {
+        .record = record,
+        .origin = -1,
+    };
+
+    if (record.event.type == KEY_EVENT) {
+        r.origin = sim_origin_for(record.event.key, record.event.pressed);
+        if (!record.event.pressed) {
+            r.record.tap.count                       = key_tap_count[record.event.key.row][record.event.key.col];
+            key_tap_count[record.event.key.row][record.event.key.col] = 0;
+        }
+    }
+    tapping_process(r);
+}
+
+#ifdef COMBO_ENABLE
+bool process_combo(uint16_t keycode, keyrecord_t *record) {
+    return true;
+}
+#endif
+
+void action_exec(keyevent_t event) {
+    keyrecord_t record = {.event = event};
+
+    if (event.type == KEY_EVENT) {
+        record.keycode = event_keycode(event);
+
+        bool keep;
+        sim_current_origin = sim_origin_for(event.key, event.pressed);
+        SIM_TIMED(SIM_HOOK_PRE_PROCESS, keep = pre_process_record_user(record.keycode, &record));
+        sim_current_origin = -1;
+#ifdef COMBO_ENABLE
+        keep = keep && process_combo(record.keycode, &record);
+#endif
+        if (!keep) {
+            return;
+        }
+    }
+    action_tapping_process(record);
+}
+
+// ============================================================================
+// Debounce (sym_defer_g, the QMK default; DEBOUNCE_TYPE = custom replaces it)
+// ============================================================================
+
+static uint16_t debounce_timer;
+static bool     debouncing = false;
+
+__attribute__((weak)) void debounce_init(uint8_t num_rows) {
+    debouncing = false;
+}
+
+__attribute__((weak)) void debounce_free(void) {}
+
+__attribute__((weak)) bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    bool cooked_changed = false;
+
+    if (changed) {
+        debouncing     = true;
+        debounce_timer = timer_read();
+    } else if (debouncing && timer_elapsed(debounce_timer) >= DEBOUNCE) {
+        size_t matrix_size = num_rows * sizeof(matrix_row_t);
+        if (memcmp(cooked, raw, matrix_size) != 0) {
+            memcpy(cooked, raw, matrix_size);
+            cooked_changed = true;
+        }
+        debouncing = false;
+    }
+    return cooked_changed;
+}
+
+// ============================================================================
+// RGB Matrix
+// ============================================================================
+
+#ifdef RGB_MATRIX_ENABLE
+
+// clang-format off
+// LED index per matrix position: 23 per half, left half first
+led_config_t g_led_config = {
+    .matrix_co = {
+        {  0,  1,  2,  3,  4,  5,  6 },
+        {  7,  8,  9, 10, 11, 12, 13 },
+        { 14, 15, 16, 17, 18, 19, NO_LED },
+        { NO_LED, NO_LED, NO_LED, 20, 21, 22, NO_LED },
+        { 23, 24, 25, 26, 27, 28, 29 },
+        { 30, 31, 32, 33, 34, 35, 36 },
+        { 37, 38, 39, 40, 41, 42, NO_LED },
+        { NO_LED, NO_LED, NO_LED, 43, 44, 45, NO_LED },
+    },
+};
+// clang-format on
+
+static RGB led_frame[RGB_MATRIX_LED_COUNT];
+
+__attribute__((weak)) bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
+    return true;
+}
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
+    if (index >= 0 && index < RGB_MATRIX_LED_COUNT) {
+        led_frame[index] = (RGB){red, green, blue};
+    }
+}
+
+const RGB *sim_led_frame(void) {
+    return led_frame;
+}
+
+uint8_t sim_leds_lit(void) {
+    uint8_t lit = 0;
+
+    for (uint8_t led = 0; led < RGB_MATRIX_LED_COUNT; led++) {
+        if (led_frame[led].r || led_frame[led].g || led_frame[led].b) {
+            lit++;
+        }
+    }
+    return lit;
+}
+
+#endif // RGB_MATRIX_ENABLE
+
+// ============================================================================
+// Keyboard Task
+// ============================================================================
+
+static matrix_row_t raw_matrix[MATRIX_ROWS];
+static matrix_row_t matrix[MATRIX_ROWS];
+static matrix_row_t matrix_previous[MATRIX_ROWS];
+
+matrix_row_t matrix_get_row(uint8_t row) {
+    return matrix[row];
+}
+
+void sim_keyboard_init(void) {
+    // The flashed image, which is not a write
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                uint8_t *stored = &eeprom[(uintptr_t)dynamic_keymap_key_to_eeprom_address(layer, row, col)];
+                stored[0]       = keymaps[layer][row][col] >> 8;
+                stored[1]       = keymaps[layer][row][col] & 0xFF;
+            }
+        }
+    }
+#ifdef RGB_MATRIX_ENABLE
+    memset(led_frame, 0, sizeof(led_frame));
+#endif
+    layer_state = 0;
+    debounce_init(MATRIX_ROWS);
+    keyboard_post_init_user();
+}
+
+bool sim_keyboard_busy(void) {
+#ifdef TAP_DANCE_ENABLE
+    if (active_td) {
+        return true;
+    }
+#endif
+#ifdef COMBO_ENGINE_ENABLE
+    if (combo_engine_busy()) {
+        return true;
+    }
+#endif
+#ifdef MACRO_QUEUE_ENABLE
+    if (macro_queue_busy()) {
+        return true;
+    }
+#endif
+    // Raw and debounced matrix still differ while a debounce wait runs
+    return tapping_active || debouncing || memcmp(raw_matrix, matrix, sizeof(matrix)) != 0;
+}
+
+void sim_keyboard_task(const matrix_row_t raw[MATRIX_ROWS]) {
+    bool changed = memcmp(raw_matrix, raw, sizeof(raw_matrix)) != 0;
+
+    memcpy(raw_matrix, raw, sizeof(raw_matrix));
+    debounce(raw_matrix, matrix, MATRIX_ROWS, changed);
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        matrix_row_t diff = matrix[row] ^ matrix_previous[row];
+        if (!diff) {
+            continue;
+        }
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            matrix_row_t mask = (matrix_row_t)1 << col;
+            if (diff & mask) {
+                action_exec((keyevent_t){
+                    .key     = {.col = col, .row = row},
+                    .time    = timer_read(),
+                    .type    = KEY_EVENT,
+                    .pressed = (matrix[row] & mask) != 0,
+                });
+            }
+        }
+        matrix_previous[row] = matrix[row];
+    }
+
+    action_exec((keyevent_t){.type = TICK_EVENT, .time = timer_read()});
+#ifdef TAP_DANCE_ENABLE
+    tap_dance_task();
+#endif
+    matrix_scan_user();
+    housekeeping_task_user();
+
+#ifdef RGB_MATRIX_ENABLE
+    SIM_TIMED(SIM_HOOK_RGB_INDICATORS, rgb_matrix_indicators_advanced_user(0, RGB_MATRIX_LED_COUNT));
+#endif
+}
@@ -0,0 +1,363 @@
+/* Copyright 2024
+ * Host-side stand-in for the QMK APIs used by the custom_hrmods keymap
+ *
+ * This is NOT QMK. It declares just enough of the QMK surface (keycodes,
+ * keyrecord_t, layers, HID, tap dance, send_string, RGB matrix) for
+ * keymap.c and the features/ sources to compile unchanged on x86 Linux. Keycode
+ * values and struct layouts follow upstream QMK so that MT(), TD(),
+ * LSFT() etc. decode the same way they do on the keyboard.
+ *
+ * The runtime behind these declarations lives in quantum.c.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Keymap configuration first, exactly like the QMK build does via -include
+#include "config.h"
+
+#include "keycodes.h"
+
+// ============================================================================
+// Keyboard Definition (crkbd/rev4_1/standard)
+// ============================================================================
+
+#define MATRIX_ROWS 8
+#define MATRIX_COLS 7
+#define RGB_MATRIX_LED_COUNT 46
+#define DYNAMIC_KEYMAP_LAYER_COUNT 4
+
+#ifndef TAPPING_TERM
+#    define TAPPING_TERM 200
+#endif
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+#ifndef USB_POLLING_INTERVAL_MS
+#    define USB_POLLING_INTERVAL_MS 1
+#endif
+#ifndef TAP_CODE_DELAY
+#    define TAP_CODE_DELAY 0
+#endif
+
+// The tuner's swept settings, on top of config.h
+#ifdef SIM_TUNE
+#    include "tune.h"
+#endif
+
+// Left half rows 0-3, right half rows 4-7 with mirrored columns
+// clang-format off
+#define LAYOUT_split_3x6_3_ex2( \
+    L00, L01, L02, L03, L04, L05, L06,   R06, R05, R04, R03, R02, R01, R00, \
+    L10, L11, L12, L13, L14, L15, L16,   R16, R15, R14, R13, R12, R11, R10, \
+    L20, L21, L22, L23, L24, L25,             R25, R24, R23, R22, R21, R20, \
+                        L33, L34, L35,   R35, R34, R33 \
+) { \
+    { L00,   L01,   L02,   L03,   L04,   L05,   L06   }, \
+    { L10,   L11,   L12,   L13,   L14,   L15,   L16   }, \
+    { L20,   L21,   L22,   L23,   L24,   L25,   KC_NO }, \
+    { KC_NO, KC_NO, KC_NO, L33,   L34,   L35,   KC_NO }, \
+    { R00,   R01,   R02,   R03,   R04,   R05,   R06   }, \
+    { R10,   R11,   R12,   R13,   R14,   R15,   R16   }, \
+    { R20,   R21,   R22,   R23,   R24,   R25,   KC_NO }, \
+    { KC_NO, KC_NO, KC_NO, R33,   R34,   R35,   KC_NO }  \
+}
+// clang-format on
+
+// ============================================================================
+// Platform
+// ============================================================================
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+
+typedef uint32_t layer_state_t;
+typedef uint32_t matrix_row_t;
+
+void     wait_ms(uint16_t ms);
+uint16_t timer_read(void);
+uint32_t timer_read32(void);
+
+// Stands in for the RP2040's 1 MHz TIMER; host time, not simulated time
+uint32_t sim_clock_us(void);
+#define LATENCY_STATS_CLOCK_US() sim_clock_us()
+uint16_t timer_elapsed(uint16_t last);
+uint32_t timer_elapsed32(uint32_t last);
+
+bool is_keyboard_master(void);
+bool is_keyboard_left(void);
+#ifdef SPLIT_KEYBOARD
+bool is_transport_connected(void);
+#endif
+
+// Debounced matrix row, as matrix_get_row() after a scan
+matrix_row_t matrix_get_row(uint8_t row);
+
+// Idle sleep of features/power_mode.c: the replay driver (sim.c) skips
+// ahead to the next key edge or the end of the sleep, whichever is first
+void sim_wait_for_edge(uint16_t ms);
+#define POWER_MODE_WAIT(ms) sim_wait_for_edge(ms)
+
+// Emulated EEPROM; addresses are byte offsets into it, as on the RP2040
+#define EEPROM_SIZE 4096
+uint8_t  eeprom_read_byte(const uint8_t *addr);
+void     eeprom_update_byte(uint8_t *addr, uint8_t value);
+uint32_t eeprom_read_dword(const uint32_t *addr);
+void     eeprom_update_dword(uint32_t *addr, uint32_t value);
+void     eeprom_read_block(void *buf, const void *addr, size_t len);
+void     eeprom_update_block(const void *buf, void *addr, size_t len);
+
+// 32-bit EEPROM user word
+uint32_t eeconfig_read_user(void);
+void     eeconfig_update_user(uint32_t val);
+
+// ============================================================================
+// Key Events
+// ============================================================================
+
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+} keypos_t;
+
+typedef enum {
+    TICK_EVENT = 0,
+    KEY_EVENT  = 1,
+} keyevent_type_t;
+
+typedef struct {
+    keypos_t key;
+    uint16_t time;
+    uint8_t  type;
+    bool     pressed;
+} keyevent_t;
+
+typedef struct {
+    bool    interrupted : 1;
+    bool    reserved2 : 1;
+    bool    reserved1 : 1;
+    bool    reserved0 : 1;
+    uint8_t count : 4;
+} tap_t;
+
+typedef struct {
+    keyevent_t event;
+    tap_t      tap;
+    uint16_t   keycode;
+} keyrecord_t;
+
+// User hooks (weak defaults in quantum.c)
+bool     pre_process_record_user(uint16_t keycode, keyrecord_t *record);
+bool     process_record_user(uint16_t keycode, keyrecord_t *record);
+void     post_process_record_user(uint16_t keycode, keyrecord_t *record);
+uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record);
+bool     get_hold_on_other_key_press(uint16_t keycode, keyrecord_t *record);
+bool     get_permissive_hold(uint16_t keycode, keyrecord_t *record);
+void     keyboard_post_init_user(void);
+void     eeconfig_init_user(void);
+void     housekeeping_task_user(void);
+void     matrix_scan_user(void);
+
+void action_exec(keyevent_t event);
+
+// Feed a record to the hold/tap logic, skipping pre_process_record_user
+void action_tapping_process(keyrecord_t record);
+
+#ifdef COMBO_ENABLE
+// QMK's combo step after pre_process_record_user. Vial's combos are stored
+// in the keyboard's EEPROM, so the simulator has none and lets keys pass.
+bool process_combo(uint16_t keycode, keyrecord_t *record);
+#endif
+
+// Process a record whose hold/tap state is already settled
+void process_record(keyrecord_t *record);
+
+// ============================================================================
+// Keymap and Layers
+// ============================================================================
+
+extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
+extern layer_state_t  layer_state;
+
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
+uint16_t get_record_keycode(keyrecord_t *record, bool update_layer_cache);
+
+// Vial's dynamic keymap: big-endian keycodes in EEPROM, layer by layer,
+// row by row, starting at DYNAMIC_KEYMAP_EEPROM_ADDR
+#define DYNAMIC_KEYMAP_EEPROM_ADDR 64
+uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column);
+void     dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode);
+void     dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data);
+void     dynamic_keymap_reset(void);
+
+uint8_t get_highest_layer(layer_state_t state);
+bool    layer_state_is(uint8_t layer);
+void    layer_on(uint8_t layer);
+void    layer_off(uint8_t layer);
+void    layer_invert(uint8_t layer);
+void    layer_clear(void);
+
+// ============================================================================
+// HID
+// ============================================================================
+
+void    register_code(uint8_t kc);
+void    unregister_code(uint8_t kc);
+void    tap_code(uint8_t kc);
+void    register_code16(uint16_t kc);
+void    unregister_code16(uint16_t kc);
+void    tap_code16(uint16_t kc);
+uint8_t get_mods(void);
+void    add_mods(uint8_t mods);
+void    del_mods(uint8_t mods);
+void    set_mods(uint8_t mods);
+void    clear_mods(void);
+void    register_mods(uint8_t mods);
+void    unregister_mods(uint8_t mods);
+void    send_keyboard_report(void);
+
+// ============================================================================
+// Send String
+// ============================================================================
+
+#define SS_QMK_PREFIX 1
+#define SS_TAP_CODE 1
+#define SS_DOWN_CODE 2
+#define SS_UP_CODE 3
+#define SS_DELAY_CODE 4
+
+#define QMK_STRINGIZE(z) #z
+#define ADD_SLASH_X(y) QMK_STRINGIZE(\x##y)
+#define SS_TAP(keycode) "\1\1" ADD_SLASH_X(keycode)
+#define SS_DOWN(keycode) "\1\2" ADD_SLASH_X(keycode)
+#define SS_UP(keycode) "\1\3" ADD_SLASH_X(keycode)
+
+#define X_ENTER 28
+#define X_ESCAPE 29
+#define X_TAB 2b
+
+#define PGM_LOADBIT(mem, pos) ((pgm_read_byte(&((mem)[(pos) / 8])) >> ((pos) % 8)) & 0x01)
+
+extern const uint8_t ascii_to_shift_lut[16];
+extern const uint8_t ascii_to_keycode_lut[128];
+
+void send_string(const char *string);
+void send_string_P(const char *string);
+#define SEND_STRING(string) send_string_P(PSTR(string))
+
+// ============================================================================
+// Tap Dance
+// ============================================================================
+
+#ifdef TAP_DANCE_ENABLE
+
+typedef struct {
+    uint16_t interrupting_keycode;
+    uint8_t  count;
+    uint8_t  weak_mods;
+    bool     pressed : 1;
+    bool     finished : 1;
+    bool     interrupted : 1;
+} tap_dance_state_t;
+
+typedef void (*tap_dance_user_fn_t)(tap_dance_state_t *state, void *user_data);
+
+typedef struct {
+    struct {
+        tap_dance_user_fn_t on_each_tap;
+        tap_dance_user_fn_t on_dance_finished;
+        tap_dance_user_fn_t on_reset;
+        tap_dance_user_fn_t on_each_release;
+    } fn;
+    void *user_data;
+} tap_dance_action_t;
+
+typedef struct {
+    uint16_t kc1;
+    uint16_t kc2;
+} tap_dance_pair_t;
+
+void tap_dance_pair_on_each_tap(tap_dance_state_t *state, void *user_data);
+void tap_dance_pair_finished(tap_dance_state_t *state, void *user_data);
+void tap_dance_pair_reset(tap_dance_state_t *state, void *user_data);
+
+#    define ACTION_TAP_DANCE_DOUBLE(kc1, kc2) \
+        { .fn = {tap_dance_pair_on_each_tap, tap_dance_pair_finished, tap_dance_pair_reset, NULL}, .user_data = (void *)&((tap_dance_pair_t){kc1, kc2}), }
+
+#    define ACTION_TAP_DANCE_FN_ADVANCED(user_fn_on_each_tap, user_fn_on_dance_finished, user_fn_on_dance_reset) \
+        { .fn = {user_fn_on_each_tap, user_fn_on_dance_finished, user_fn_on_dance_reset, NULL}, .user_data = NULL, }
+
+extern tap_dance_action_t tap_dance_actions[];
+
+#endif // TAP_DANCE_ENABLE
+
+// ============================================================================
+// VIA / Vial Raw HID
+// ============================================================================
+
+#ifdef VIA_ENABLE
+
+#    define RAW_EPSIZE 32
+
+enum via_command_id {
+    id_get_protocol_version           = 0x01,
+    id_get_keyboard_value             = 0x02,
+    id_set_keyboard_value             = 0x03,
+    id_dynamic_keymap_get_keycode     = 0x04,
+    id_dynamic_keymap_set_keycode     = 0x05,
+    id_dynamic_keymap_reset           = 0x06,
+    id_custom_set_value               = 0x07,
+    id_custom_get_value               = 0x08,
+    id_custom_save                    = 0x09,
+    id_eeprom_reset                   = 0x0A,
+    id_bootloader_jump                = 0x0B,
+    id_dynamic_keymap_get_layer_count = 0x11,
+    id_dynamic_keymap_get_buffer      = 0x12,
+    id_dynamic_keymap_set_buffer      = 0x13,
+    id_vial_prefix                    = 0xFE,
+    id_unhandled                      = 0xFF,
+};
+
+bool via_command_kb(uint8_t *data, uint8_t length);
+void raw_hid_receive(uint8_t *data, uint8_t length);
+void raw_hid_send(uint8_t *data, uint8_t length);
+
+#endif // VIA_ENABLE
+
+// ============================================================================
+// RGB Matrix
+// ============================================================================
+
+#ifdef RGB_MATRIX_ENABLE
+
+#    define NO_LED 255
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} RGB;
+
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+} led_point_t;
+
+typedef struct {
+    uint8_t     matrix_co[MATRIX_ROWS][MATRIX_COLS];
+    led_point_t point[RGB_MATRIX_LED_COUNT];
+    uint8_t     flags[RGB_MATRIX_LED_COUNT];
+} led_config_t;
+
+extern led_config_t g_led_config;
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue);
+bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max);
+
+#endif // RGB_MATRIX_ENABLE
@@ -0,0 +1,7 @@
+/* Copyright 2024
+ * Host-side stand-in for QMK's raw_hid.h (declarations live in quantum.h)
+ */
+
+#pragma once
+
+#include "quantum.h"
@@ -0,0 +1,88 @@
+/* Copyright 2024
+ * Host-side simulator interface
+ *
+ * Glue between the QMK stand-in runtime (quantum.c) and the replay driver
+ * (sim.c). The runtime owns the keyboard model; the driver owns the clock,
+ * the input traces and all reporting.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+// Hooks whose cost is measured on every call
+typedef enum {
+    SIM_HOOK_PRE_PROCESS = 0,
+    SIM_HOOK_PROCESS_RECORD,
+    SIM_HOOK_TAPPING_TERM,
+    SIM_HOOK_RGB_INDICATORS,
+    SIM_HOOK_COUNT
+} sim_hook_t;
+
+// HID keyboard report as seen by the host
+typedef struct {
+    uint8_t mods;
+    uint8_t keys[32];  // NKRO bitmap indexed by basic keycode
+} sim_report_t;
+
+// Simulated time in milliseconds (advanced by the driver and by blocking waits)
+extern uint32_t sim_now;
+
+// End of the idle sleep the last scan asked for (sim_wait_for_edge), or a
+// time already passed when it did not sleep
+extern uint32_t sim_sleep_until;
+
+// EEPROM writes that actually changed stored data
+extern uint32_t sim_eeprom_writes;
+
+// Wear-leveling flash under the EEPROM: log entries and image programs, and
+// sector erases when the log fills up
+extern uint32_t sim_flash_writes;
+extern uint32_t sim_flash_erases;
+
+// Index of the trace event whose processing is currently running (-1 = none)
+extern int sim_current_origin;
+
+// Which half this process plays (is_keyboard_master)
+extern bool sim_is_master;
+
+// Whether the other half runs as well (is_transport_connected, --split)
+extern bool sim_split_connected;
+
+// Runtime entry points (quantum.c)
+void sim_keyboard_init(void);
+void sim_keyboard_task(const matrix_row_t raw[MATRIX_ROWS]);
+bool sim_keyboard_busy(void);
+
+#ifdef RGB_MATRIX_ENABLE
+// Number of LEDs the last indicator pass left on
+uint8_t sim_leds_lit(void);
+
+// Colors the last indicator pass left, RGB_MATRIX_LED_COUNT entries
+const RGB *sim_led_frame(void);
+#endif
+
+#ifdef SPLIT_KEYBOARD
+// Hand a transfer from the other half to the registered RPC handler
+void sim_split_rpc_receive(int8_t transaction_id, uint8_t length, const void *data);
+#endif
+
+uint64_t sim_cycles(void);
+
+// Driver callbacks (sim.c)
+int  sim_origin_for(keypos_t key, bool pressed);
+void sim_on_report(const sim_report_t *report);
+void sim_on_hook(sim_hook_t hook, uint64_t cycles);
+void sim_on_raw_hid(const uint8_t *data, uint8_t length);
+void sim_on_mod_tap(keypos_t key, bool tap);  // Mod-tap press settled by QMK's hold/tap logic
+#ifdef SPLIT_KEYBOARD
+bool sim_on_split_rpc(int8_t transaction_id, uint8_t length, const void *data);
+#endif
+
+// Run a hook and charge its cost to the current origin
+#define SIM_TIMED(hook, expr)                         \
+    do {                                              \
+        uint64_t sim_t0_ = sim_cycles();              \
+        expr;                                         \
+        sim_on_hook((hook), sim_cycles() - sim_t0_);  \
+    } while (0)
@@ -0,0 +1,28 @@
+/* Copyright 2024
+ * Host-side stand-in for QMK's split transactions.h (user RPCs only)
+ *
+ * Transfers go to the replay driver, which carries them to a second
+ * simulated half in --split mode and drops them otherwise.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef SPLIT_KEYBOARD
+
+// Transaction ids; the user ids from config.h follow the built-in ones
+enum serial_transaction_id {
+    SIM_TRANSACTION_BUILTIN = 0x1F,
+#    ifdef SPLIT_TRANSACTION_IDS_USER
+    SPLIT_TRANSACTION_IDS_USER,
+#    endif
+    NUM_TOTAL_TRANSACTIONS
+};
+
+typedef void (*slave_callback_t)(uint8_t initiator2target_buffer_size, const void *initiator2target_buffer, uint8_t target2initiator_buffer_size, void *target2initiator_buffer);
+
+void transaction_register_rpc(int8_t transaction_id, slave_callback_t callback);
+bool transaction_rpc_send(int8_t transaction_id, uint8_t initiator2target_buffer_size, const void *initiator2target_buffer);
+
+#endif // SPLIT_KEYBOARD
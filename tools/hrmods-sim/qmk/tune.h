@@ -0,0 +1,37 @@
+/* Copyright 2024
+ * Tuner overrides
+ *
+ * Only in the tuner build (SIM_TUNE): the timing settings it sweeps are
+ * pointed at variables, so one build replays every combination. Included
+ * by quantum.h right after config.h and the keyboard definition.
+ */
+
+#pragma once
+
+typedef struct {
+    uint16_t roll_min_ms;
+    uint16_t roll_max_ms;
+    uint16_t flow_ms;  // 0 turns typing flow off
+    bool     permissive_hold;
+} sim_tuning_t;
+
+extern sim_tuning_t sim_tuning;
+
+// Per-key tapping terms, read instead of layout.gen.c's table
+extern const uint16_t (*sim_tuned_terms)[MATRIX_ROWS][MATRIX_COLS];
+
+#undef BILATERAL_ROLL_MIN_MS
+#define BILATERAL_ROLL_MIN_MS sim_tuning.roll_min_ms
+#undef BILATERAL_ROLL_MAX_MS
+#define BILATERAL_ROLL_MAX_MS sim_tuning.roll_max_ms
+#undef BILATERAL_FLOW_MS
+#define BILATERAL_FLOW_MS sim_tuning.flow_ms
+
+// get_permissive_hold() answers from sim_tuning
+#undef PERMISSIVE_HOLD
+#define PERMISSIVE_HOLD_PER_KEY
+
+#define layout_tapping_term (*sim_tuned_terms)
+
+// Learned terms would replace the swept ones after the first taps
+#undef ADAPTIVE_TAPPING_TERM
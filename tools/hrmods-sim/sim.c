@@ -0,0 +1,751 @@
+/* Copyright 2024
+ * Event-replay simulator and latency benchmark for the custom_hrmods keymap
+ *
+ * Replays timestamped press/release traces through keymap.c and the
+ * features/ sources compiled for the host, and reports for every physical
+ * event when its first HID report left the keyboard and how many CPU
+ * cycles the user hooks spent on it.
+ *
+ * Trace format (one directive per line, '#' starts a comment):
+ *
+ *   <ms> down <key>            physical press
+ *   <ms> up <key>              physical release
+ *   <ms> tap <key> <hold_ms>   press at <ms>, release <hold_ms> later
+ *   <ms> vial <key> <layer> <keycode>
+ *                              Vial keymap write (dynamic_keymap_set_keycode)
+ *   <ms> hid <hex>             raw HID packet to the keyboard, e.g. "f101"
+ *   @expect text <string>      typed output, e.g. "the<S-h>"
+ *   @expect max-latency <ms>   worst press-to-report latency over all presses
+ *   @expect lit <count>        LEDs left on by the last RGB indicator pass
+ *   @expect max-sync-us <us>   worst time until the slave half shows an LED
+ *                              frame change of the master (--split only)
+ *   @expect max-flash-writes <count>
+ *                              flash programs under the emulated EEPROM
+ *   @expect max-wake-latency <ms>
+ *                              worst press-to-report latency of the presses
+ *                              that ended an idle sleep, at least one (single
+ *                              half only: a connected master never sleeps
+ *                              longer than a scan)
+ *
+ * <key> is a base-layer label ("a", "t", "spc", "td1", "mo2", ...) or a
+ * matrix position written as "<row>,<col>".
+ *
+ * With --hid the simulator replays a single trace and then acts as the
+ * keyboard's raw HID endpoint: every stdin line is one request packet in
+ * hex, answered by one hex line on stdout. scripts/hrmods-hid.py --sim
+ * talks to it exactly like it talks to /dev/hidraw.
+ *
+ * With --split every trace drives the master half while a second process
+ * runs the slave half, joined by an in-memory serial link: each master
+ * scan ships its split RPCs to the slave, which runs one scan and returns
+ * its LED frame. The report adds the link bytes per scan and how long each
+ * master LED frame change took to show up on the slave, with the USART
+ * time modelled at SPLIT_BAUD.
+ *
+ * With POWER_MODE_ENABLE the keymap sleeps between scans once idle; the
+ * replay then jumps to the end of the sleep or to the next key edge,
+ * whichever comes first, as the column interrupt would wake it. The
+ * report adds the scans run, the time slept and the latency of the keys
+ * that woke the keyboard.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+#define MAX_TEXT 4096
+#define SETTLE_MS 1000
+#define IDLE_SKIP_MS 2000
+
+// Split link model: RP2040 full-duplex USART at QMK's default speed, 8N1,
+// plus the transaction ids and sizes QMK sends around every RPC payload
+#define SPLIT_BAUD 921600
+#define SPLIT_BITS_PER_BYTE 10
+#define SPLIT_RPC_OVERHEAD 6
+#define SPLIT_PACKET_MAX 256
+
+static const char *hook_names[SIM_HOOK_COUNT] = {
+    [SIM_HOOK_PRE_PROCESS]    = "pre_process_record_user",
+    [SIM_HOOK_PROCESS_RECORD] = "process_record_user",
+    [SIM_HOOK_TAPPING_TERM]   = "get_tapping_term",
+    [SIM_HOOK_RGB_INDICATORS] = "rgb_matrix_indicators_advanced_user",
+};
+
+typedef struct {
+    uint64_t calls;
+    uint64_t total;
+    uint64_t max;
+} hook_stats_t;
+
+// Split link traffic and master-to-slave LED frame latency (--split)
+typedef struct {
+    uint32_t scans;
+    uint32_t transfers;
+    uint32_t bytes;           // On the wire, RPC overhead included
+    uint32_t max_scan_bytes;  // Busiest single scan
+    uint32_t frames;          // Master LED frame changes the slave caught up with
+    uint32_t missed;          // Frame changes the slave never showed
+    uint64_t latency_total;   // us, over frames
+    uint32_t latency_max;
+} split_stats_t;
+
+// Idle sleeps of the power mode
+typedef struct {
+    uint32_t scans;
+    uint32_t sleeps;      // Longer than one scan
+    uint32_t slept_ms;
+    uint32_t edge_wakes;  // Ended early by a key edge
+} power_stats_t;
+
+static trace_t       trace;
+static char          typed[MAX_TEXT];
+static size_t        typed_len;
+static hook_stats_t  hook_stats[SIM_HOOK_COUNT];
+static split_stats_t split_stats;
+static power_stats_t power_stats;
+static int           last_event_for[MATRIX_ROWS][MATRIX_COLS][2];
+static int           last_press_seen;
+static sim_report_t  last_report;
+static bool          hid_endpoint;
+
+
+// ============================================================================
+// Driver Callbacks
+// ============================================================================
+
+int sim_origin_for(keypos_t key, bool pressed) {
+    int origin = last_event_for[key.row][key.col][pressed];
+
+    if (pressed) {
+        last_press_seen = origin;
+    }
+    return origin;
+}
+
+static void append_typed(const char *token) {
+    size_t len = strlen(token);
+
+    if (typed_len + len < sizeof(typed)) {
+        memcpy(typed + typed_len, token, len + 1);
+        typed_len += len;
+    }
+}
+
+// Translate a newly pressed HID key back to text, US layout
+static void type_key(uint8_t kc, uint8_t mods) {
+    bool shift = mods & MOD_MASK_SHIFT;
+    char token[32];
+    char name[16];
+
+    if (!(mods & ~MOD_MASK_SHIFT)) {
+        for (int c = ' '; c < 0x7F; c++) {
+            bool shifted = PGM_LOADBIT(ascii_to_shift_lut, c);
+            if (ascii_to_keycode_lut[c] == kc && shifted == shift) {
+                token[0] = (char)c;
+                token[1] = '\0';
+                append_typed(token);
+                return;
+            }
+        }
+    }
+
+    basic_name(kc, name, sizeof(name));
+    snprintf(token, sizeof(token), "<%s%s%s%s%s>",
+             (mods & MOD_MASK_CTRL) ? "C-" : "",
+             (mods & MOD_MASK_ALT) ? "A-" : "",
+             (mods & MOD_MASK_GUI) ? "G-" : "",
+             shift ? "S-" : "",
+             name);
+    append_typed(token);
+}
+
+void sim_on_report(const sim_report_t *report) {
+    for (int kc = 0; kc < 256; kc++) {
+        uint8_t bit = (uint8_t)(1 << (kc & 7));
+        if ((report->keys[kc >> 3] & bit) && !(last_report.keys[kc >> 3] & bit)) {
+            type_key((uint8_t)kc, report->mods);
+        }
+    }
+    last_report = *report;
+
+    // Reports from timers and housekeeping (tap dance timeouts, queued
+    // macros) belong to the last press the keyboard has seen
+    int origin = sim_current_origin >= 0 ? sim_current_origin : last_press_seen;
+
+    if (origin >= 0 && trace.events[origin].report_time < 0) {
+        trace.events[origin].report_time = (int32_t)sim_now;
+    }
+}
+
+void sim_on_hook(sim_hook_t hook, uint64_t cycles) {
+    hook_stats_t *stats = &hook_stats[hook];
+
+    stats->calls++;
+    stats->total += cycles;
+    if (cycles > stats->max) {
+        stats->max = cycles;
+    }
+    if (sim_current_origin >= 0) {
+        trace.events[sim_current_origin].cycles[hook] += cycles;
+    }
+}
+
+void sim_on_mod_tap(keypos_t key, bool tap) {}
+
+void sim_on_raw_hid(const uint8_t *data, uint8_t length) {
+    if (!hid_endpoint) {
+        return;  // Replies to trace-driven Vial writes are not interesting
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        printf("%02x", data[i]);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+// ============================================================================
+// Split Link
+// ============================================================================
+
+#if defined(SPLIT_KEYBOARD) && defined(RGB_MATRIX_ENABLE)
+#    define SPLIT_SIM
+
+// One master scan worth of link traffic, master to slave
+typedef struct {
+    uint32_t time;    // Master clock after the scan, UINT32_MAX ends the run
+    uint16_t length;  // Bytes used in rpcs
+    uint8_t  rpcs[SPLIT_PACKET_MAX];  // <id> <length> <payload> per transfer
+} split_packet_t;
+
+static int            split_fd = -1;
+static split_packet_t split_out;
+static uint32_t       split_scan_bytes;
+static RGB            split_master_frame[RGB_MATRIX_LED_COUNT];  // Last frame drawn by the master
+static bool           split_pending;                              // Slave has not shown it yet
+static uint32_t       split_pending_time;
+
+bool sim_on_split_rpc(int8_t transaction_id, uint8_t length, const void *data) {
+    if (split_fd < 0) {
+        return true;  // Single half: nobody listens, the transfer still succeeds
+    }
+    if (split_out.length + 2 + length > SPLIT_PACKET_MAX) {
+        return false;
+    }
+    split_out.rpcs[split_out.length++] = (uint8_t)transaction_id;
+    split_out.rpcs[split_out.length++] = length;
+    memcpy(&split_out.rpcs[split_out.length], data, length);
+    split_out.length += length;
+    split_scan_bytes += SPLIT_RPC_OVERHEAD + length;
+    split_stats.transfers++;
+    return true;
+}
+
+// Slave half: one scan per master scan, answering with the LED frame it drew
+static int split_slave(int fd) {
+    split_packet_t packet;
+    matrix_row_t   raw[MATRIX_ROWS] = {0};
+
+    sim_is_master = false;
+    sim_now       = 0;
+    sim_keyboard_init();
+
+    while (read(fd, &packet, sizeof(packet)) > 0 && packet.time != UINT32_MAX) {
+        sim_now = packet.time;
+        for (uint16_t i = 0; i + 2 <= packet.length; i += 2 + packet.rpcs[i + 1]) {
+            sim_split_rpc_receive((int8_t)packet.rpcs[i], packet.rpcs[i + 1], &packet.rpcs[i + 2]);
+        }
+        sim_keyboard_task(raw);
+        if (write(fd, sim_led_frame(), sizeof(RGB) * RGB_MATRIX_LED_COUNT) < 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static bool split_start(void) {
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) != 0) {
+        perror("socketpair");
+        return false;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        _exit(split_slave(fds[1]));
+    }
+    close(fds[1]);
+    split_fd            = fds[0];
+    sim_split_connected = true;
+    memset(&split_stats, 0, sizeof(split_stats));
+    memset(split_master_frame, 0, sizeof(split_master_frame));
+    split_pending = false;
+    return true;
+}
+
+// After every master scan: ship its transfers, run the slave, compare frames
+static void split_exchange(void) {
+    RGB slave_frame[RGB_MATRIX_LED_COUNT];
+
+    if (memcmp(split_master_frame, sim_led_frame(), sizeof(split_master_frame)) != 0) {
+        if (split_pending) {
+            split_stats.missed++;  // Replaced before the slave ever showed it
+        }
+        memcpy(split_master_frame, sim_led_frame(), sizeof(split_master_frame));
+        split_pending      = true;
+        split_pending_time = sim_now;
+    }
+
+    split_out.time = sim_now;
+    if (write(split_fd, &split_out, offsetof(split_packet_t, rpcs) + split_out.length) < 0 ||
+        read(split_fd, slave_frame, sizeof(slave_frame)) != (ssize_t)sizeof(slave_frame)) {
+        perror("split link");
+        exit(2);
+    }
+
+    if (split_pending && memcmp(slave_frame, split_master_frame, sizeof(slave_frame)) == 0) {
+        uint32_t wire_us = (uint32_t)((uint64_t)split_scan_bytes * SPLIT_BITS_PER_BYTE * 1000000u / SPLIT_BAUD);
+        uint32_t latency = (sim_now - split_pending_time) * 1000u + wire_us;
+
+        split_stats.frames++;
+        split_stats.latency_total += latency;
+        if (latency > split_stats.latency_max) {
+            split_stats.latency_max = latency;
+        }
+        split_pending = false;
+    }
+
+    split_stats.scans++;
+    split_stats.bytes += split_scan_bytes;
+    if (split_scan_bytes > split_stats.max_scan_bytes) {
+        split_stats.max_scan_bytes = split_scan_bytes;
+    }
+    split_out.length = 0;
+    split_scan_bytes = 0;
+}
+
+static void split_stop(void) {
+    split_packet_t end = {.time = UINT32_MAX};
+
+    if (split_pending) {
+        split_stats.missed++;
+    }
+    if (write(split_fd, &end, offsetof(split_packet_t, rpcs)) < 0) {
+        perror("split link");
+    }
+    close(split_fd);
+    split_fd            = -1;
+    sim_split_connected = false;
+    wait(NULL);
+}
+
+#elif defined(SPLIT_KEYBOARD)
+
+bool sim_on_split_rpc(int8_t transaction_id, uint8_t length, const void *data) {
+    return true;
+}
+
+#endif
+
+// ============================================================================
+// Replay
+// ============================================================================
+
+static void vial_set_keycode(const trace_event_t *event) {
+#ifdef VIA_ENABLE
+    uint8_t packet[RAW_EPSIZE] = {
+        id_dynamic_keymap_set_keycode, event->layer, event->key.row, event->key.col, (uint8_t)(event->keycode >> 8), (uint8_t)event->keycode,
+    };
+
+    raw_hid_receive(packet, sizeof(packet));
+#endif
+}
+
+static void send_raw_hid(trace_event_t *event) {
+#ifdef VIA_ENABLE
+    uint8_t packet[RAW_EPSIZE];
+
+    memcpy(packet, event->packet, sizeof(packet));
+    raw_hid_receive(packet, sizeof(packet));
+#endif
+}
+
+#ifdef POWER_MODE_ENABLE
+// The last scan asked to sleep: wake at the end of it or at the next key
+// edge from trace event next on, like the column interrupt would
+static void power_sleep(uint32_t next) {
+    if (sim_sleep_until <= sim_now + 1) {
+        return;  // Not longer than a scan at full rate
+    }
+
+    uint32_t wake = sim_sleep_until;
+    for (; next < trace.event_count; next++) {
+        trace_event_t *event = &trace.events[next];
+        if (event->kind != EVENT_KEY) {
+            continue;  // Host traffic waits for the next scan
+        }
+        if (event->time < wake) {
+            wake        = event->time;
+            event->woke = true;
+            power_stats.edge_wakes++;
+        }
+        break;
+    }
+    power_stats.sleeps++;
+    power_stats.slept_ms += wake - sim_now;
+    sim_now = wake;
+}
+#endif
+
+static void replay(void) {
+    matrix_row_t raw[MATRIX_ROWS] = {0};
+    uint32_t     next             = 0;
+    uint32_t     end              = trace.event_count ? trace.events[trace.event_count - 1].time + SETTLE_MS : 0;
+
+    memset(last_event_for, 0xFF, sizeof(last_event_for));
+    memset(&power_stats, 0, sizeof(power_stats));
+    last_press_seen = -1;
+    sim_now = 0;
+    sim_sleep_until = 0;
+    sim_keyboard_init();
+
+    // One matrix scan per millisecond; blocking firmware may push sim_now ahead
+    uint32_t tick = 0;
+    while (tick <= end || sim_keyboard_busy()) {
+#ifndef POWER_MODE_ENABLE
+        // The power mode sleeps through idle time on its own
+        if (next < trace.event_count && !sim_keyboard_busy() && trace.events[next].time > tick + IDLE_SKIP_MS) {
+            tick = trace.events[next].time - IDLE_SKIP_MS;
+        }
+#endif
+        if (sim_now < tick) {
+            sim_now = tick;
+        }
+
+        while (next < trace.event_count && trace.events[next].time <= sim_now) {
+            trace_event_t *event = &trace.events[next];
+            matrix_row_t   mask  = (matrix_row_t)1 << event->key.col;
+
+            if (event->kind == EVENT_VIAL_SET) {
+                vial_set_keycode(event);
+                next++;
+                continue;
+            }
+            if (event->kind == EVENT_RAW_HID) {
+                send_raw_hid(event);
+                next++;
+                continue;
+            }
+
+            raw[event->key.row] = event->pressed ? raw[event->key.row] | mask : raw[event->key.row] & ~mask;
+            last_event_for[event->key.row][event->key.col][event->pressed] = (int)next;
+            next++;
+        }
+        sim_keyboard_task(raw);
+        power_stats.scans++;
+#ifdef SPLIT_SIM
+        if (split_fd >= 0) {
+            split_exchange();
+        }
+#endif
+#ifdef POWER_MODE_ENABLE
+        power_sleep(next);
+#endif
+
+        tick = sim_now > tick ? sim_now : tick + 1;
+    }
+}
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t va = *(const uint32_t *)a;
+    uint32_t vb = *(const uint32_t *)b;
+    return va < vb ? -1 : (va > vb ? 1 : 0);
+}
+
+static void print_events(void) {
+    printf("  %8s  %-6s %-4s %-10s %8s  %12s %12s %12s\n", "t(ms)", "key", "edge", "keycode", "latency", "pre_process", "process", "tap_term");
+    for (uint32_t i = 0; i < trace.event_count; i++) {
+        trace_event_t *event = &trace.events[i];
+        char           name[16], pos[8], latency[16];
+
+        keycode_name(keymaps[0][event->key.row][event->key.col], name, sizeof(name));
+        snprintf(pos, sizeof(pos), "%d,%d", event->key.row, event->key.col);
+        if (event->kind == EVENT_VIAL_SET) {
+            printf("  %8u  %-6s vial layer %u = 0x%04x\n", event->time, pos, event->layer, event->keycode);
+            continue;
+        }
+        if (event->kind == EVENT_RAW_HID) {
+            printf("  %8u  %-6s raw hid %02x %02x\n", event->time, "-", event->packet[0], event->packet[1]);
+            continue;
+        }
+        if (event->report_time >= 0) {
+            snprintf(latency, sizeof(latency), "%u ms", (uint32_t)event->report_time - event->time);
+        } else {
+            snprintf(latency, sizeof(latency), "-");
+        }
+        printf("  %8u  %-6s %-4s %-10s %8s  %12llu %12llu %12llu\n", event->time, pos, event->pressed ? "down" : "up", name, latency,
+               (unsigned long long)event->cycles[SIM_HOOK_PRE_PROCESS], (unsigned long long)event->cycles[SIM_HOOK_PROCESS_RECORD],
+               (unsigned long long)event->cycles[SIM_HOOK_TAPPING_TERM]);
+    }
+}
+
+static uint32_t print_summary(void) {
+    uint32_t *latencies = malloc((trace.event_count + 1) * sizeof(*latencies));
+    uint32_t  count     = 0;
+    uint64_t  total     = 0;
+
+    for (uint32_t i = 0; i < trace.event_count; i++) {
+        trace_event_t *event = &trace.events[i];
+        if (event->kind == EVENT_KEY && event->pressed && event->report_time >= 0) {
+            latencies[count] = (uint32_t)event->report_time - event->time;
+            total += latencies[count];
+            count++;
+        }
+    }
+    qsort(latencies, count, sizeof(latencies[0]), compare_u32);
+
+    uint32_t max = count ? latencies[count - 1] : 0;
+    printf("  typed: %s\n", typed);
+    if (sim_eeprom_writes) {
+        printf("  eeprom writes: %u (flash: %u writes, %u erases)\n", sim_eeprom_writes, sim_flash_writes, sim_flash_erases);
+    }
+    if (count) {
+        printf("  press latency: mean %.1f ms, p50 %u ms, p95 %u ms, max %u ms (%u presses)\n", (double)total / count, latencies[count / 2],
+               latencies[(count * 95) / 100 < count ? (count * 95) / 100 : count - 1], max, count);
+    }
+    for (int hook = 0; hook < SIM_HOOK_COUNT; hook++) {
+        hook_stats_t *stats = &hook_stats[hook];
+        if (stats->calls) {
+            printf("  %-36s %8llu calls, mean %8.0f, max %8llu cycles\n", hook_names[hook], (unsigned long long)stats->calls,
+                   (double)stats->total / stats->calls, (unsigned long long)stats->max);
+        }
+    }
+    free(latencies);
+    return max;
+}
+
+static void print_split_summary(void) {
+    split_stats_t *stats = &split_stats;
+
+    printf("  split link: %u transfers, %u bytes in %u scans (%.3f bytes/scan, max %u in one scan)\n", stats->transfers, stats->bytes,
+           stats->scans, stats->scans ? (double)stats->bytes / stats->scans : 0.0, stats->max_scan_bytes);
+    printf("  indicator sync: %u frame changes, mean %.0f us, max %u us, %u missed\n", stats->frames,
+           stats->frames ? (double)stats->latency_total / stats->frames : 0.0, stats->latency_max, stats->missed);
+}
+
+// Worst press-to-report latency of the presses that ended a sleep; returns how many
+static uint32_t wake_latency(uint32_t *max) {
+    uint32_t count = 0;
+
+    *max = 0;
+    for (uint32_t i = 0; i < trace.event_count; i++) {
+        trace_event_t *event = &trace.events[i];
+        if (event->kind == EVENT_KEY && event->pressed && event->woke && event->report_time >= 0) {
+            uint32_t latency = (uint32_t)event->report_time - event->time;
+            if (latency > *max) {
+                *max = latency;
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+static void print_power_summary(void) {
+    power_stats_t *stats = &power_stats;
+    uint32_t       max;
+    uint32_t       woken = wake_latency(&max);
+
+    printf("  power: %u scans in %u ms, slept %u ms in %u sleeps, %u woken by a key edge", stats->scans, sim_now + 1, stats->slept_ms,
+           stats->sleeps, stats->edge_wakes);
+    if (woken) {
+        printf(", first key latency max %u ms", max);
+    }
+    printf("\n");
+}
+
+static bool check_expectations(uint32_t max_latency, bool split) {
+    bool ok = true;
+
+    for (uint32_t i = 0; i < trace.expect_count; i++) {
+        expect_t *expect = &trace.expects[i];
+        if (expect->kind == EXPECT_TEXT && strcmp(expect->text, typed) != 0) {
+            printf("  FAIL: expected text \"%s\", got \"%s\"\n", expect->text, typed);
+            ok = false;
+        } else if (expect->kind == EXPECT_MAX_LATENCY && max_latency > expect->value) {
+            printf("  FAIL: max press latency %u ms exceeds %u ms\n", max_latency, expect->value);
+            ok = false;
+        } else if (expect->kind == EXPECT_LIT) {
+#ifdef RGB_MATRIX_ENABLE
+            uint8_t lit = sim_leds_lit();
+#else
+            uint8_t lit = 0;
+#endif
+            if (lit != expect->value) {
+                printf("  FAIL: expected %u LEDs lit, got %u\n", expect->value, lit);
+                ok = false;
+            }
+        } else if (expect->kind == EXPECT_MAX_SYNC_US && split && split_stats.latency_max > expect->value) {
+            printf("  FAIL: max indicator sync latency %u us exceeds %u us\n", split_stats.latency_max, expect->value);
+            ok = false;
+        } else if (expect->kind == EXPECT_MAX_FLASH_WRITES && sim_flash_writes > expect->value) {
+            printf("  FAIL: %u flash writes exceed %u\n", sim_flash_writes, expect->value);
+            ok = false;
+        } else if (expect->kind == EXPECT_MAX_WAKE_LATENCY && !split) {
+            uint32_t max;
+            if (!wake_latency(&max)) {
+                printf("  FAIL: no press woke the keyboard from an idle sleep\n");
+                ok = false;
+            } else if (max > expect->value) {
+                printf("  FAIL: max wake-up press latency %u ms exceeds %u ms\n", max, expect->value);
+                ok = false;
+            }
+        }
+    }
+    if (split && split_stats.missed) {
+        printf("  FAIL: slave never showed %u master LED frame(s)\n", split_stats.missed);
+        ok = false;
+    }
+    return ok;
+}
+
+static int run_trace(const char *path, bool quiet, bool check, bool split) {
+    if (!trace_load(&trace, path)) {
+        return 2;
+    }
+
+#ifdef SPLIT_SIM
+    if (split && !split_start()) {
+        return 2;
+    }
+    replay();
+    if (split) {
+        split_stop();
+    }
+#else
+    replay();
+#endif
+
+    printf("== %s (%u events)\n", path, trace.event_count);
+    if (!quiet) {
+        print_events();
+    }
+    uint32_t max_latency = print_summary();
+    if (power_stats.sleeps) {
+        print_power_summary();
+    }
+    if (split) {
+        print_split_summary();
+    }
+    if (check && !check_expectations(max_latency, split)) {
+        return 1;
+    }
+    return 0;
+}
+
+// Replay, then answer raw HID packets (hex lines) until stdin closes
+static int serve_hid(const char *path) {
+#ifdef VIA_ENABLE
+    char line[4 * RAW_EPSIZE];
+
+    if (!trace_load(&trace, path)) {
+        return 2;
+    }
+    replay();
+
+    hid_endpoint = true;
+    while (fgets(line, sizeof(line), stdin)) {
+        uint8_t     packet[RAW_EPSIZE] = {0};
+        const char *hex                = line;
+        unsigned    byte;
+        int         used;
+
+        for (uint8_t i = 0; i < RAW_EPSIZE && sscanf(hex, "%2x%n", &byte, &used) == 1; i++) {
+            packet[i] = (uint8_t)byte;
+            hex += used;
+        }
+        raw_hid_receive(packet, RAW_EPSIZE);
+    }
+    return 0;
+#else
+    fprintf(stderr, "raw HID needs VIAL_ENABLE in rules.mk\n");
+    return 2;
+#endif
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-q] [--check] [--split] trace...\n", argv0);
+    fprintf(stderr, "       %s --hid trace\n", argv0);
+    fprintf(stderr, "  -q        summary only, no per-event table\n");
+    fprintf(stderr, "  --check   fail when a trace's @expect lines are not met\n");
+    fprintf(stderr, "  --split   run a slave half over a simulated serial link, report link bytes and sync latency\n");
+    fprintf(stderr, "  --hid     replay, then serve raw HID packets (hex lines on stdin/stdout)\n");
+}
+
+int main(int argc, char **argv) {
+    bool quiet    = false;
+    bool check    = false;
+    bool hid      = false;
+    bool split    = false;
+    int  failures = 0;
+    int  first    = 1;
+
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        if (strcmp(argv[first], "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[first], "--check") == 0) {
+            check = true;
+        } else if (strcmp(argv[first], "--split") == 0) {
+            split = true;
+        } else if (strcmp(argv[first], "--hid") == 0) {
+            hid = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (first >= argc || (hid && argc - first != 1)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (hid) {
+        return serve_hid(argv[first]);
+    }
+#ifndef SPLIT_SIM
+    if (split) {
+        fprintf(stderr, "--split needs SPLIT_KEYBOARD and RGB_MATRIX_ENABLE in rules.mk\n");
+        return 2;
+    }
+#endif
+
+    // Each trace runs in its own process so keymap state never leaks between them
+    for (int i = first; i < argc; i++) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            int status = run_trace(argv[i], quiet, check, split);
+            fflush(stdout);
+            _exit(status);
+        }
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failures++;
+        }
+    }
+
+    if (check) {
+        printf("%d/%d traces passed\n", argc - first - failures, argc - first);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,295 @@
+/* Copyright 2024
+ * Trace Files
+ *
+ * Parsing of the timestamped key traces shared by the replay simulator
+ * (sim.c) and the parameter tuner (tune.c).
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "trace.h"
+
+// ============================================================================
+// Key Names
+// ============================================================================
+
+// clang-format off
+static const char *basic_names[256] = {
+    [KC_ENTER] = "ent", [KC_ESCAPE] = "esc", [KC_BACKSPACE] = "bspc", [KC_TAB] = "tab",
+    [KC_SPACE] = "spc", [KC_MINUS] = "mins", [KC_EQUAL] = "eql", [KC_LEFT_BRACKET] = "lbrc",
+    [KC_RIGHT_BRACKET] = "rbrc", [KC_BACKSLASH] = "bsls", [KC_SEMICOLON] = "scln",
+    [KC_QUOTE] = "quot", [KC_GRAVE] = "grv", [KC_COMMA] = "comm", [KC_DOT] = "dot",
+    [KC_SLASH] = "slsh", [KC_CAPS_LOCK] = "caps", [KC_F1] = "f1", [KC_F2] = "f2",
+    [KC_F3] = "f3", [KC_F4] = "f4", [KC_F5] = "f5", [KC_F6] = "f6", [KC_F7] = "f7",
+    [KC_F8] = "f8", [KC_F9] = "f9", [KC_F10] = "f10", [KC_F11] = "f11", [KC_F12] = "f12",
+    [KC_PRINT_SCREEN] = "pscr", [KC_INSERT] = "ins", [KC_HOME] = "home", [KC_PAGE_UP] = "pgup",
+    [KC_DELETE] = "del", [KC_END] = "end", [KC_PAGE_DOWN] = "pgdn", [KC_RIGHT] = "rght",
+    [KC_LEFT] = "left", [KC_DOWN] = "down", [KC_UP] = "up", [KC_AUDIO_MUTE] = "mute",
+    [KC_AUDIO_VOL_UP] = "volu", [KC_AUDIO_VOL_DOWN] = "vold", [KC_BRIGHTNESS_UP] = "briu",
+    [KC_BRIGHTNESS_DOWN] = "brid", [KC_LEFT_CTRL] = "lctl", [KC_LEFT_SHIFT] = "lsft",
+    [KC_LEFT_ALT] = "lalt", [KC_LEFT_GUI] = "lgui", [KC_RIGHT_CTRL] = "rctl",
+    [KC_RIGHT_SHIFT] = "rsft", [KC_RIGHT_ALT] = "ralt", [KC_RIGHT_GUI] = "rgui",
+};
+// clang-format on
+
+void basic_name(uint8_t kc, char *out, size_t size) {
+    if (kc >= KC_A && kc <= KC_Z) {
+        snprintf(out, size, "%c", 'a' + (kc - KC_A));
+    } else if (kc >= KC_1 && kc <= KC_0) {
+        snprintf(out, size, "%c", kc == KC_0 ? '0' : '1' + (kc - KC_1));
+    } else if (basic_names[kc]) {
+        snprintf(out, size, "%s", basic_names[kc]);
+    } else {
+        snprintf(out, size, "0x%02x", kc);
+    }
+}
+
+void keycode_name(uint16_t kc, char *out, size_t size) {
+    if (IS_QK_BASIC(kc)) {
+        basic_name((uint8_t)kc, out, size);
+    } else if (IS_QK_MOD_TAP(kc)) {
+        basic_name(QK_MOD_TAP_GET_TAP_KEYCODE(kc), out, size);
+    } else if (IS_QK_MOMENTARY(kc)) {
+        snprintf(out, size, "mo%d", QK_MOMENTARY_GET_LAYER(kc));
+    } else if (IS_QK_TOGGLE_LAYER(kc)) {
+        snprintf(out, size, "tg%d", QK_TOGGLE_LAYER_GET_LAYER(kc));
+    } else if (IS_QK_TAP_DANCE(kc)) {
+        snprintf(out, size, "td%d", QK_TAP_DANCE_GET_INDEX(kc));
+    } else if (kc == QK_GESC) {
+        snprintf(out, size, "gesc");
+    } else if (kc == SC_LSPO) {
+        snprintf(out, size, "lspo");
+    } else if (kc == SC_RCPC) {
+        snprintf(out, size, "rcpc");
+    } else if (kc == SC_SENT) {
+        snprintf(out, size, "sent");
+    } else if (kc >= SAFE_RANGE) {
+        snprintf(out, size, "user%d", kc - SAFE_RANGE);
+    } else {
+        snprintf(out, size, "0x%04x", kc);
+    }
+}
+
+static bool parse_key(const char *label, keypos_t *key) {
+    int row, col;
+
+    if (sscanf(label, "%d,%d", &row, &col) == 2) {
+        if (row < 0 || row >= MATRIX_ROWS || col < 0 || col >= MATRIX_COLS) {
+            return false;
+        }
+        *key = (keypos_t){.col = (uint8_t)col, .row = (uint8_t)row};
+        return true;
+    }
+
+    // Labels come from the compiled base layer, not the dynamic keymap
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+            char name[16];
+            if (keymaps[0][r][c] == KC_NO) {
+                continue;
+            }
+            keycode_name(keymaps[0][r][c], name, sizeof(name));
+            if (strcmp(name, label) == 0) {
+                *key = (keypos_t){.col = c, .row = r};
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Trace Parsing
+// ============================================================================
+
+static int compare_events(const void *a, const void *b) {
+    const trace_event_t *ea = a;
+    const trace_event_t *eb = b;
+
+    if (ea->time != eb->time) {
+        return ea->time < eb->time ? -1 : 1;
+    }
+    // Keep file order for simultaneous events (qsort is not stable)
+    return ea->seq < eb->seq ? -1 : 1;
+}
+
+static trace_event_t *add_event(trace_t *trace, uint32_t time, keypos_t key, bool pressed) {
+    if (trace->event_count == trace->event_capacity) {
+        uint32_t       capacity = trace->event_capacity ? trace->event_capacity * 2 : 1024;
+        trace_event_t *events   = realloc(trace->events, capacity * sizeof(*events));
+        if (!events) {
+            return NULL;
+        }
+        trace->events         = events;
+        trace->event_capacity = capacity;
+    }
+    trace->events[trace->event_count] = (trace_event_t){
+        .time        = time,
+        .seq         = trace->event_count,
+        .key         = key,
+        .pressed     = pressed,
+        .report_time = -1,
+    };
+    return &trace->events[trace->event_count++];
+}
+
+static bool parse_expect(trace_t *trace, const char *args, int line_no) {
+    expect_t *expect = &trace->expects[trace->expect_count];
+    char      kind[32];
+    int       consumed;
+
+    if (trace->expect_count >= MAX_EXPECTS || sscanf(args, "%31s %n", kind, &consumed) != 1) {
+        fprintf(stderr, "%s:%d: malformed @expect\n", trace->path, line_no);
+        return false;
+    }
+
+    const char *value = args + consumed;
+    if (strcmp(kind, "text") == 0) {
+        size_t len = strcspn(value, "\r\n");
+        if (len >= 2 && value[0] == '"' && value[len - 1] == '"') {
+            value++;
+            len -= 2;
+        }
+        if (len >= sizeof(expect->text)) {
+            len = sizeof(expect->text) - 1;
+        }
+        expect->kind = EXPECT_TEXT;
+        memcpy(expect->text, value, len);
+        expect->text[len] = '\0';
+    } else if (strcmp(kind, "max-latency") == 0) {
+        expect->kind  = EXPECT_MAX_LATENCY;
+        expect->value = (uint32_t)strtoul(value, NULL, 10);
+    } else if (strcmp(kind, "lit") == 0) {
+        expect->kind  = EXPECT_LIT;
+        expect->value = (uint32_t)strtoul(value, NULL, 10);
+    } else if (strcmp(kind, "max-sync-us") == 0) {
+        expect->kind  = EXPECT_MAX_SYNC_US;
+        expect->value = (uint32_t)strtoul(value, NULL, 10);
+    } else if (strcmp(kind, "max-flash-writes") == 0) {
+        expect->kind  = EXPECT_MAX_FLASH_WRITES;
+        expect->value = (uint32_t)strtoul(value, NULL, 10);
+    } else if (strcmp(kind, "max-wake-latency") == 0) {
+        expect->kind  = EXPECT_MAX_WAKE_LATENCY;
+        expect->value = (uint32_t)strtoul(value, NULL, 10);
+    } else {
+        fprintf(stderr, "%s:%d: unknown expectation '%s'\n", trace->path, line_no, kind);
+        return false;
+    }
+    trace->expect_count++;
+    return true;
+}
+
+static bool parse_raw_hid(trace_t *trace, uint32_t time, const char *text, int line_no) {
+    trace_event_t *event = add_event(trace, time, (keypos_t){0}, false);
+    const char    *hex;
+    unsigned       byte;
+    int            used;
+
+    if (!event) {
+        return false;
+    }
+    event->kind = EVENT_RAW_HID;
+
+    sscanf(text, "%*u %*s %n", &used);
+    hex = text + used;
+    for (size_t i = 0; i < sizeof(event->packet) && sscanf(hex, "%2x%n", &byte, &used) == 1; i++) {
+        event->packet[i] = (uint8_t)byte;
+        hex += used;
+    }
+    if (*hex && !isspace((unsigned char)*hex)) {
+        fprintf(stderr, "%s:%d: bad raw HID packet '%s'\n", trace->path, line_no, text);
+        return false;
+    }
+    return true;
+}
+
+bool trace_load(trace_t *trace, const char *path) {
+    FILE *file = fopen(path, "r");
+    char  line[512];
+    int   line_no = 0;
+
+    memset(trace, 0, sizeof(*trace));
+    trace->path = path;
+    if (!file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), file)) {
+        char    *text = line;
+        char     verb[16], label[32];
+        unsigned time, hold, keycode;
+        keypos_t key;
+        int      fields;
+
+        line_no++;
+        while (isspace((unsigned char)*text)) {
+            text++;
+        }
+        if (*text == '\0' || *text == '#') {
+            continue;
+        }
+        if (strncmp(text, "@expect ", 8) == 0) {
+            if (!parse_expect(trace, text + 8, line_no)) {
+                fclose(file);
+                return false;
+            }
+            continue;
+        }
+
+        char *comment = strstr(text, " #");
+        if (comment) {
+            *comment = '\0';
+        }
+        fields = sscanf(text, "%u %15s %31s %u %i", &time, verb, label, &hold, &keycode);
+        if (fields >= 3 && strcmp(verb, "hid") == 0) {
+            if (!parse_raw_hid(trace, time, text, line_no)) {
+                fclose(file);
+                return false;
+            }
+            continue;
+        }
+        if (fields < 3 || !parse_key(label, &key)) {
+            fprintf(stderr, "%s:%d: cannot parse '%s'\n", path, line_no, text);
+            fclose(file);
+            return false;
+        }
+
+        bool ok;
+        if (strcmp(verb, "down") == 0) {
+            ok = add_event(trace, time, key, true);
+        } else if (strcmp(verb, "up") == 0) {
+            ok = add_event(trace, time, key, false);
+        } else if (strcmp(verb, "tap") == 0 && fields == 4) {
+            ok = add_event(trace, time, key, true) && add_event(trace, time + hold, key, false);
+        } else if (strcmp(verb, "vial") == 0 && fields == 5) {
+            trace_event_t *event = add_event(trace, time, key, false);
+            if ((ok = event != NULL)) {
+                event->kind    = EVENT_VIAL_SET;
+                event->layer   = (uint8_t)hold;
+                event->keycode = (uint16_t)keycode;
+            }
+        } else {
+            fprintf(stderr, "%s:%d: unknown verb '%s'\n", path, line_no, verb);
+            ok = false;
+        }
+        if (!ok) {
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+
+    qsort(trace->events, trace->event_count, sizeof(trace->events[0]), compare_events);
+    return true;
+}
+
+void trace_free(trace_t *trace) {
+    free(trace->events);
+    trace->events         = NULL;
+    trace->event_count    = 0;
+    trace->event_capacity = 0;
+}
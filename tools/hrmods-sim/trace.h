@@ -0,0 +1,66 @@
+/* Copyright 2024
+ * Trace Files - Header
+ *
+ * Timestamped key traces as read by the simulator and the tuner; see the
+ * header of sim.c for the format.
+ */
+
+#pragma once
+
+#include "qmk/sim.h"
+
+#define MAX_EXPECTS 16
+
+typedef enum {
+    EVENT_KEY,
+    EVENT_VIAL_SET,
+    EVENT_RAW_HID,
+} event_kind_t;
+
+typedef struct {
+    uint32_t     time;
+    uint32_t     seq;
+    event_kind_t kind;
+    keypos_t     key;
+    bool         pressed;
+    uint8_t      layer;    // EVENT_VIAL_SET only
+    uint16_t     keycode;  // EVENT_VIAL_SET only
+    uint8_t      packet[32];  // EVENT_RAW_HID only
+
+    // Filled in during replay
+    int32_t  report_time;  // -1 until the first report caused by this event
+    bool     woke;         // EVENT_KEY only: ended an idle sleep (power mode)
+    uint64_t cycles[SIM_HOOK_COUNT];
+} trace_event_t;
+
+typedef enum {
+    EXPECT_TEXT,
+    EXPECT_MAX_LATENCY,
+    EXPECT_LIT,
+    EXPECT_MAX_SYNC_US,
+    EXPECT_MAX_FLASH_WRITES,
+    EXPECT_MAX_WAKE_LATENCY,
+} expect_kind_t;
+
+typedef struct {
+    expect_kind_t kind;
+    char          text[256];
+    uint32_t      value;
+} expect_t;
+
+typedef struct {
+    const char    *path;
+    trace_event_t *events;
+    uint32_t       event_count;
+    uint32_t       event_capacity;
+    expect_t       expects[MAX_EXPECTS];
+    uint32_t       expect_count;
+} trace_t;
+
+// Read a trace file, events sorted by time (file order for ties)
+bool trace_load(trace_t *trace, const char *path);
+void trace_free(trace_t *trace);
+
+// Base layer names as used for <key> in traces ("a", "spc", "td1", "mo2")
+void basic_name(uint8_t kc, char *out, size_t size);
+void keycode_name(uint16_t kc, char *out, size_t size);
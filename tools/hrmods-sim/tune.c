@@ -0,0 +1,714 @@
+/* Copyright 2024
+ * Home row mod timing tuner for the custom_hrmods keymap
+ *
+ * Replays recorded traces through the keymap built for the host (the
+ * bilateral engine and the stand-in's hold/tap logic) once for every
+ * combination of a grid of timing settings:
+ *
+ *   --term        TAPPING_TERM
+ *   --pinky, --ring, --middle, --index
+ *                 extra term for the home row mods on that finger, both
+ *                 hands (layout.yaml tapping_term.home_row_mod)
+ *   --roll-min    BILATERAL_ROLL_MIN_MS
+ *   --roll-max    BILATERAL_ROLL_MAX_MS
+ *   --flow        BILATERAL_FLOW_MS, 0 = no typing flow
+ *   --permissive  PERMISSIVE_HOLD on (1) or off (0)
+ *
+ * each given as a value, a list "100,150" or a range "150:250:25". For
+ * every combination it reports how many home row mod presses came out as
+ * the wrong one of tap and hold, and the mean and p95 time from a key
+ * press to its first HID report. The combinations no other one beats on
+ * both counts (the Pareto front) are listed, and the config.h and
+ * layout.yaml lines for one of them printed, with the term of every home
+ * row mod.
+ *
+ * What the typist meant is read from the trace with hindsight the
+ * firmware doesn't have: a hold when a key of the other hand or a thumb
+ * key was pressed and released while the mod was down, or when the mod
+ * was held --lone-hold ms before any other key; a tap otherwise (rolls, and keys of
+ * the same hand, which this layout never chords with a mod). Presses
+ * while a MO() key is down are not counted. What the keyboard did is read
+ * from the hold/tap logic, or from the HID reports when the bilateral
+ * engine sends a settled hold as its letter instead.
+ *
+ * All traces replay back to back in one keyboard session, the way they
+ * were recorded. ADAPTIVE_TAPPING_TERM is off in this build (qmk/tune.h):
+ * learned terms would replace the swept ones after the first taps. Each
+ * combination runs in a process forked from the untouched parent, on all
+ * cores. Scans only run while something is pending (hold/tap, debounce,
+ * combos, tap dance, macros); between key events the clock jumps ahead,
+ * so the cost follows the number of events, not the length of the trace.
+ * --dense scans every millisecond instead and must give the same result.
+ */
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+#include "layout.gen.h"
+
+// layout.gen.c's own table, to derive the per-key offsets from
+#undef layout_tapping_term
+extern const uint16_t layout_tapping_term[MATRIX_ROWS][MATRIX_COLS];
+
+#define TRACE_GAP_MS 5000     // Idle time between two traces
+#define DEFAULT_LONE_HOLD 300  // A mod held alone this long was meant as a hold
+#define LATENCY_BUCKETS 1024   // ms, for the p95
+#define MAX_VALUES 32          // Per swept setting
+
+// ============================================================================
+// Settings
+// ============================================================================
+
+typedef enum {
+    SETTING_TERM = 0,
+    SETTING_PINKY,  // Home row mod offsets, in FINGERS order
+    SETTING_RING,
+    SETTING_MIDDLE,
+    SETTING_INDEX,
+    SETTING_ROLL_MIN,
+    SETTING_ROLL_MAX,
+    SETTING_FLOW,
+    SETTING_PERMISSIVE,
+    SETTING_COUNT
+} setting_t;
+
+typedef struct {
+    const char *option;
+    const char *label;
+    const char *grid;  // Default
+    uint16_t    values[MAX_VALUES];
+    uint8_t     count;
+} setting_axis_t;
+
+// clang-format off
+static setting_axis_t axes[SETTING_COUNT] = {
+    [SETTING_TERM]       = {"--term",       "term",     "150:225:25"},
+    [SETTING_PINKY]      = {"--pinky",      "pinky",    "0:50:25"},
+    [SETTING_RING]       = {"--ring",       "ring",     "0,25"},
+    [SETTING_MIDDLE]     = {"--middle",     "middle",   "0,25"},
+    [SETTING_INDEX]      = {"--index",      "index",    "0,25"},
+    [SETTING_ROLL_MIN]   = {"--roll-min",   "roll-min", "30:70:20"},
+    [SETTING_ROLL_MAX]   = {"--roll-max",   "roll-max", "80:140:30"},
+    [SETTING_FLOW]       = {"--flow",       "flow",     "0,100,150,200"},
+    [SETTING_PERMISSIVE] = {"--permissive", "perm",     "0,1"},
+};
+
+static const char *const fingers[] = {"pinky", "ring", "middle", "index"};
+
+_Static_assert(LAYOUT_HOME_ROW_MODS <= 8, "one offset per finger, mirrored on both hands");
+// clang-format on
+
+typedef struct {
+    uint16_t value[SETTING_COUNT];
+} combination_t;
+
+// Filled in by the child that ran the combination
+typedef struct {
+    bool     done;
+    uint32_t misfires;
+    uint32_t unresolved;  // Mod presses without a tap key or modifier in any report
+    uint32_t presses;     // Key presses that caused a report
+    uint64_t latency_total;
+    uint16_t latency_p95;
+    uint64_t scans;
+} result_t;
+
+static bool parse_axis(setting_axis_t *axis, const char *text) {
+    unsigned first, last, step;
+    int      used;
+
+    axis->count = 0;
+    if (sscanf(text, "%u:%u:%u%n", &first, &last, &step, &used) == 3 && !text[used]) {
+        if (step == 0 || last < first) {
+            return false;
+        }
+        for (unsigned value = first; value <= last; value += step) {
+            if (axis->count == MAX_VALUES) {
+                return false;
+            }
+            axis->values[axis->count++] = (uint16_t)value;
+        }
+        return true;
+    }
+    while (*text) {
+        if (axis->count == MAX_VALUES || sscanf(text, "%u%n", &first, &used) != 1) {
+            return false;
+        }
+        axis->values[axis->count++] = (uint16_t)first;
+        text += used;
+        if (*text == ',') {
+            text++;
+        } else if (*text) {
+            return false;
+        }
+    }
+    return axis->count > 0;
+}
+
+// Every valid combination, first setting slowest
+static uint32_t build_grid(combination_t **grid) {
+    uint32_t total = 1;
+
+    for (uint8_t s = 0; s < SETTING_COUNT; s++) {
+        total *= axes[s].count;
+    }
+    *grid = malloc(total * sizeof(**grid));
+
+    uint32_t count = 0;
+    for (uint32_t n = 0; n < total; n++) {
+        combination_t combination;
+        uint32_t      rest = n;
+
+        for (int s = SETTING_COUNT - 1; s >= 0; s--) {
+            combination.value[s] = axes[s].values[rest % axes[s].count];
+            rest /= axes[s].count;
+        }
+        if (combination.value[SETTING_ROLL_MIN] > combination.value[SETTING_ROLL_MAX]) {
+            continue;
+        }
+        (*grid)[count++] = combination;
+    }
+    return count;
+}
+
+// ============================================================================
+// Traces
+// ============================================================================
+
+typedef enum {
+    INTENT_NONE = 0,  // Not a home row mod press, or pressed on another layer
+    INTENT_TAP,
+    INTENT_HOLD,
+} intent_t;
+
+typedef struct {
+    uint32_t time;
+    uint8_t  row;
+    uint8_t  col;
+    bool     pressed;
+    uint8_t  intent;
+} key_event_t;
+
+static key_event_t *events;
+static uint32_t     event_count;
+static uint32_t     skipped_events;  // Vial writes and raw HID, not replayed
+
+static bool is_home_row_mod(uint8_t row, uint8_t col) {
+    return (layout_key_flags[row][col] & LAYOUT_KEY_HOME_ROW_MOD) && IS_QK_MOD_TAP(keymaps[0][row][col]);
+}
+
+// Pinky to index, mirrored on both hands like gen-layout.py's FINGERS
+static uint8_t finger_of(uint8_t row, uint8_t col) {
+    uint8_t index  = LAYOUT_KEY_HRM_INDEX(layout_key_flags[row][col]);
+    uint8_t mirror = LAYOUT_HOME_ROW_MODS - 1 - index;
+
+    return index < mirror ? index : mirror;
+}
+
+// The term a combination gives a key
+static uint16_t term_for(const combination_t *combination, uint8_t row, uint8_t col) {
+    if (is_home_row_mod(row, col)) {
+        return combination->value[SETTING_TERM] + combination->value[SETTING_PINKY + finger_of(row, col)];
+    }
+    return combination->value[SETTING_TERM] + layout_tapping_term[row][col] - TAPPING_TERM;
+}
+
+// Append one trace's key events, starting TRACE_GAP_MS after the last ones
+static bool add_trace(const char *path) {
+    trace_t  trace;
+    uint32_t offset = event_count ? events[event_count - 1].time + TRACE_GAP_MS : 0;
+
+    if (!trace_load(&trace, path)) {
+        return false;
+    }
+    events = realloc(events, (event_count + trace.event_count) * sizeof(*events));
+    for (uint32_t i = 0; i < trace.event_count; i++) {
+        trace_event_t *event = &trace.events[i];
+        if (event->kind != EVENT_KEY) {
+            skipped_events++;
+            continue;
+        }
+        events[event_count++] = (key_event_t){
+            .time    = offset + event->time,
+            .row     = event->key.row,
+            .col     = event->key.col,
+            .pressed = event->pressed,
+        };
+    }
+    trace_free(&trace);
+    return true;
+}
+
+// What each home row mod press was meant to be, from what followed it
+static void label_intents(uint16_t lone_hold) {
+    uint8_t layer_keys_down = 0;
+
+    for (uint32_t i = 0; i < event_count; i++) {
+        key_event_t *event = &events[i];
+        uint16_t     keycode = keymaps[0][event->row][event->col];
+
+        if (IS_QK_MOMENTARY(keycode)) {
+            layer_keys_down += event->pressed ? 1 : -1;
+            continue;
+        }
+        if (!event->pressed || layer_keys_down || !is_home_row_mod(event->row, event->col)) {
+            continue;
+        }
+
+        uint8_t  hand    = LAYOUT_KEY_HAND(layout_key_flags[event->row][event->col]);
+        uint32_t alone   = UINT32_MAX;  // Until the next key press
+        bool     chorded = false;
+        uint32_t release = event_count;
+
+        for (uint32_t j = i + 1; j < event_count; j++) {
+            key_event_t *next = &events[j];
+            if (next->row == event->row && next->col == event->col) {
+                release = j;
+                break;
+            }
+            if (!next->pressed) {
+                continue;
+            }
+            if (alone == UINT32_MAX) {
+                alone = next->time - event->time;
+            }
+
+            // Pressed and released inside the mod: a chord, if the other hand or a thumb
+            uint8_t next_hand = LAYOUT_KEY_HAND(layout_key_flags[next->row][next->col]);
+            for (uint32_t k = j + 1; k < event_count && next_hand != hand; k++) {
+                if (events[k].row == event->row && events[k].col == event->col) {
+                    break;
+                }
+                if (events[k].row == next->row && events[k].col == next->col) {
+                    chorded = true;
+                    break;
+                }
+            }
+        }
+
+        if (alone == UINT32_MAX) {
+            alone = release < event_count ? events[release].time - event->time : 0;
+        }
+        event->intent = chorded || alone >= lone_hold ? INTENT_HOLD : INTENT_TAP;
+    }
+}
+
+// ============================================================================
+// Replay
+// ============================================================================
+
+sim_tuning_t    sim_tuning;
+const uint16_t (*sim_tuned_terms)[MATRIX_ROWS][MATRIX_COLS];
+
+static uint16_t     tuned_terms[MATRIX_ROWS][MATRIX_COLS];
+static int32_t     *report_times;                      // Per event, -1 until its first report
+static int          last_event_for[MATRIX_ROWS][MATRIX_COLS][2];
+static int          last_press_seen;
+static int          open_mod[MATRIX_ROWS][MATRIX_COLS];  // Press whose outcome is still unseen
+static uint8_t      tap_keycodes[MATRIX_ROWS][MATRIX_COLS];
+static sim_report_t last_report;
+static result_t     result;
+
+bool get_permissive_hold(uint16_t keycode, keyrecord_t *record) {
+    return sim_tuning.permissive_hold;
+}
+
+int sim_origin_for(keypos_t key, bool pressed) {
+    int origin = last_event_for[key.row][key.col][pressed];
+
+    if (pressed) {
+        last_press_seen = origin;
+    }
+    return origin;
+}
+
+static void settle_mod(uint8_t row, uint8_t col, intent_t outcome) {
+    if (outcome != events[open_mod[row][col]].intent) {
+        result.misfires++;
+    }
+    open_mod[row][col] = -1;
+}
+
+void sim_on_mod_tap(keypos_t key, bool tap) {
+    if (open_mod[key.row][key.col] >= 0) {
+        settle_mod(key.row, key.col, tap ? INTENT_TAP : INTENT_HOLD);
+    }
+}
+
+// Its letter in a report settles a mod as a tap, whoever sent it
+void sim_on_report(const sim_report_t *report) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint8_t kc  = tap_keycodes[row][col];
+            uint8_t bit = (uint8_t)(1 << (kc & 7));
+
+            if (open_mod[row][col] < 0) {
+                continue;
+            }
+            if ((report->keys[kc >> 3] & bit) && !(last_report.keys[kc >> 3] & bit)) {
+                settle_mod(row, col, INTENT_TAP);
+            }
+        }
+    }
+    last_report = *report;
+
+    int origin = sim_current_origin >= 0 ? sim_current_origin : last_press_seen;
+    if (origin >= 0 && report_times[origin] < 0) {
+        report_times[origin] = (int32_t)sim_now;
+    }
+}
+
+void sim_on_hook(sim_hook_t hook, uint64_t cycles) {}
+
+void sim_on_raw_hid(const uint8_t *data, uint8_t length) {}
+
+#ifdef SPLIT_KEYBOARD
+bool sim_on_split_rpc(int8_t transaction_id, uint8_t length, const void *data) {
+    return true;
+}
+#endif
+
+static void apply_combination(const combination_t *combination) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            tuned_terms[row][col] = term_for(combination, row, col);
+        }
+    }
+    sim_tuned_terms             = &tuned_terms;
+    sim_tuning.roll_min_ms      = combination->value[SETTING_ROLL_MIN];
+    sim_tuning.roll_max_ms      = combination->value[SETTING_ROLL_MAX];
+    sim_tuning.flow_ms          = combination->value[SETTING_FLOW];
+    sim_tuning.permissive_hold  = combination->value[SETTING_PERMISSIVE] != 0;
+}
+
+static void replay(bool dense) {
+    matrix_row_t raw[MATRIX_ROWS] = {0};
+    uint32_t     next             = 0;
+    uint32_t     tick             = 0;
+
+    memset(last_event_for, 0xFF, sizeof(last_event_for));
+    memset(open_mod, 0xFF, sizeof(open_mod));
+    last_press_seen = -1;
+    sim_now         = 0;
+    sim_keyboard_init();
+
+    while (next < event_count || sim_keyboard_busy()) {
+        // Nothing pending: no scan can change anything before the next event
+        if (!dense && next < event_count && !sim_keyboard_busy() && events[next].time > tick) {
+            tick = events[next].time;
+        }
+        if (sim_now < tick) {
+            sim_now = tick;
+        }
+
+        while (next < event_count && events[next].time <= sim_now) {
+            key_event_t *event = &events[next];
+            matrix_row_t mask  = (matrix_row_t)1 << event->col;
+
+            raw[event->row] = event->pressed ? raw[event->row] | mask : raw[event->row] & ~mask;
+            last_event_for[event->row][event->col][event->pressed] = (int)next;
+            if (event->intent != INTENT_NONE) {
+                if (open_mod[event->row][event->col] >= 0) {
+                    result.unresolved++;
+                }
+                open_mod[event->row][event->col] = (int)next;
+            }
+            next++;
+        }
+        sim_keyboard_task(raw);
+        result.scans++;
+
+        tick = sim_now > tick ? sim_now : tick + 1;
+    }
+}
+
+static void run_combination(const combination_t *combination, bool dense, result_t *out) {
+    uint32_t histogram[LATENCY_BUCKETS] = {0};
+
+    report_times = malloc(event_count * sizeof(*report_times));
+    memset(report_times, 0xFF, event_count * sizeof(*report_times));
+    apply_combination(combination);
+    replay(dense);
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            result.unresolved += open_mod[row][col] >= 0;
+        }
+    }
+    for (uint32_t i = 0; i < event_count; i++) {
+        if (events[i].pressed && report_times[i] >= 0) {
+            uint32_t latency = (uint32_t)report_times[i] - events[i].time;
+            result.presses++;
+            result.latency_total += latency;
+            histogram[latency < LATENCY_BUCKETS ? latency : LATENCY_BUCKETS - 1]++;
+        }
+    }
+    for (uint32_t bucket = 0, seen = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += histogram[bucket];
+        if (seen * 100 >= result.presses * 95) {
+            result.latency_p95 = (uint16_t)bucket;
+            break;
+        }
+    }
+    result.done = true;
+    *out        = result;
+}
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+static uint32_t mod_presses;
+static uint32_t mod_holds;
+
+static double misfire_rate(const result_t *r) {
+    uint32_t judged = mod_presses - r->unresolved;
+    return judged ? 100.0 * r->misfires / judged : 0.0;
+}
+
+static double mean_latency(const result_t *r) {
+    return r->presses ? (double)r->latency_total / r->presses : 0.0;
+}
+
+static bool dominates(const result_t *a, const result_t *b) {
+    double ra = misfire_rate(a), rb = misfire_rate(b);
+    double la = mean_latency(a), lb = mean_latency(b);
+
+    return ra <= rb && la <= lb && (ra < rb || la < lb);
+}
+
+static bool same_point(const result_t *a, const result_t *b) {
+    return misfire_rate(a) == misfire_rate(b) && mean_latency(a) == mean_latency(b);
+}
+
+static const result_t *sort_results;
+
+static int compare_front(const void *a, const void *b) {
+    const result_t *ra = &sort_results[*(const uint32_t *)a];
+    const result_t *rb = &sort_results[*(const uint32_t *)b];
+
+    if (misfire_rate(ra) != misfire_rate(rb)) {
+        return misfire_rate(ra) < misfire_rate(rb) ? -1 : 1;
+    }
+    if (mean_latency(ra) != mean_latency(rb)) {
+        return mean_latency(ra) < mean_latency(rb) ? -1 : 1;
+    }
+    return *(const uint32_t *)a < *(const uint32_t *)b ? -1 : 1;
+}
+
+static void print_row(const combination_t *c, const result_t *r, uint32_t ties) {
+    printf("  %5u  %+5d  %+4d  %+6d  %+5d  %8u  %8u  %4u  %4s  %7.2f%%  %6.1f ms  %4u ms", c->value[SETTING_TERM],
+           c->value[SETTING_PINKY], c->value[SETTING_RING], c->value[SETTING_MIDDLE], c->value[SETTING_INDEX], c->value[SETTING_ROLL_MIN],
+           c->value[SETTING_ROLL_MAX], c->value[SETTING_FLOW], c->value[SETTING_PERMISSIVE] ? "yes" : "no", misfire_rate(r),
+           mean_latency(r), r->latency_p95);
+    printf(ties ? "  (+%u equivalent)\n" : "\n", ties);
+}
+
+static void print_config(const combination_t *c, const result_t *r) {
+    printf("// %.2f%% home row mod misfires, mean press latency %.1f ms\n", misfire_rate(r), mean_latency(r));
+    printf("#define TAPPING_TERM %u\n", c->value[SETTING_TERM]);
+    printf(c->value[SETTING_PERMISSIVE] ? "#define PERMISSIVE_HOLD\n" : "// no PERMISSIVE_HOLD\n");
+    printf("#define BILATERAL_ROLL_MIN_MS %u\n", c->value[SETTING_ROLL_MIN]);
+    printf("#define BILATERAL_ROLL_MAX_MS %u\n", c->value[SETTING_ROLL_MAX]);
+    if (c->value[SETTING_FLOW]) {
+        printf("#define BILATERAL_FLOW_MS %u\n", c->value[SETTING_FLOW]);
+    } else {
+        printf("// no BILATERAL_FLOW_MS\n");
+    }
+
+    printf("\n# layout.yaml\ntapping_term:\n  default: TAPPING_TERM\n  home_row_mod:");
+    for (uint8_t finger = 0; finger < 4; finger++) {
+        printf("%s%s: TAPPING_TERM + %u", finger ? ", " : " {", fingers[finger], c->value[SETTING_PINKY + finger]);
+    }
+    printf("}\n\n");
+
+    // Every home row mod in LAYOUT order, the way the firmware sees it
+    printf("Home row mod terms:");
+    for (uint8_t index = 0; index < LAYOUT_HOME_ROW_MODS; index++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                if (is_home_row_mod(row, col) && LAYOUT_KEY_HRM_INDEX(layout_key_flags[row][col]) == index) {
+                    printf("  %c %u ms", 'A' + tap_keycodes[row][col] - KC_A, term_for(c, row, col));
+                }
+            }
+        }
+    }
+    printf("\n");
+}
+
+static void print_report(const combination_t *grid, const result_t *results, uint32_t count, double max_misfires) {
+    uint32_t *front      = malloc(count * sizeof(*front));
+    uint32_t  front_size = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        bool beaten = false;
+        for (uint32_t j = 0; j < count && !beaten; j++) {
+            beaten = dominates(&results[j], &results[i]);
+        }
+        if (!beaten) {
+            front[front_size++] = i;
+        }
+    }
+    sort_results = results;
+    qsort(front, front_size, sizeof(*front), compare_front);
+
+    printf("== %u key events, %u home row mod presses (%u meant as holds)", event_count, mod_presses, mod_holds);
+    if (skipped_events) {
+        printf(", %u Vial/raw HID events skipped", skipped_events);
+    }
+    printf("\n%u combinations, %u on the Pareto front (misfires vs mean press latency):\n", count, front_size);
+    printf("  %5s  %5s  %4s  %6s  %5s  %8s  %8s  %4s  %4s  %8s  %9s  %7s\n", "term", "pinky", "ring", "middle", "index", "roll-min",
+           "roll-max", "flow", "perm", "misfire", "mean", "p95");
+    // Combinations on the same point are listed once, the first in grid order
+    uint32_t pick = front[0];
+    for (uint32_t i = 0, ties; i < front_size; i += ties + 1) {
+        for (ties = 0; i + ties + 1 < front_size && same_point(&results[front[i]], &results[front[i + ties + 1]]); ties++) {
+        }
+        print_row(&grid[front[i]], &results[front[i]], ties);
+
+        // Fastest point within the misfire budget, else the most accurate one
+        if (misfire_rate(&results[front[i]]) <= max_misfires) {
+            pick = front[i];
+        }
+    }
+    printf("\n");
+    print_config(&grid[pick], &results[pick]);
+    free(front);
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [options] trace...\n", argv0);
+    for (uint8_t s = 0; s < SETTING_COUNT; s++) {
+        fprintf(stderr, "  %-13s values to sweep (default %s)\n", axes[s].option, axes[s].grid);
+    }
+    fprintf(stderr, "  --lone-hold   ms a mod held alone must last to count as a hold (default %u)\n", DEFAULT_LONE_HOLD);
+    fprintf(stderr, "  --max-misfire percent; print config.h for the fastest front entry within it (default 0)\n");
+    fprintf(stderr, "  --dense       scan every millisecond (slow; must match the default)\n");
+    fprintf(stderr, "  -j            parallel combinations (default: all cores)\n");
+}
+
+int main(int argc, char **argv) {
+    long     jobs         = sysconf(_SC_NPROCESSORS_ONLN);
+    uint16_t lone_hold    = DEFAULT_LONE_HOLD;
+    double   max_misfires = 0.0;
+    bool     dense        = false;
+    int      first        = 1;
+
+    for (uint8_t s = 0; s < SETTING_COUNT; s++) {
+        parse_axis(&axes[s], axes[s].grid);
+    }
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        const char *arg   = argv[first];
+        bool        known = false;
+
+        for (uint8_t s = 0; s < SETTING_COUNT && !known; s++) {
+            if (strcmp(arg, axes[s].option) == 0) {
+                known = first + 1 < argc && parse_axis(&axes[s], argv[++first]);
+                if (!known) {
+                    fprintf(stderr, "bad values for %s\n", arg);
+                    return 2;
+                }
+            }
+        }
+        if (known) {
+            continue;
+        }
+        if (strcmp(arg, "--lone-hold") == 0 && first + 1 < argc) {
+            lone_hold = (uint16_t)strtoul(argv[++first], NULL, 10);
+        } else if (strcmp(arg, "--max-misfire") == 0 && first + 1 < argc) {
+            max_misfires = strtod(argv[++first], NULL);
+        } else if (strcmp(arg, "--dense") == 0) {
+            dense = true;
+        } else if (strcmp(arg, "-j") == 0 && first + 1 < argc) {
+            jobs = strtol(argv[++first], NULL, 10);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (first >= argc || jobs < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    for (int i = first; i < argc; i++) {
+        if (!add_trace(argv[i])) {
+            return 2;
+        }
+    }
+    label_intents(lone_hold);
+    for (uint32_t i = 0; i < event_count; i++) {
+        mod_presses += events[i].intent != INTENT_NONE;
+        mod_holds += events[i].intent == INTENT_HOLD;
+    }
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (is_home_row_mod(row, col)) {
+                tap_keycodes[row][col] = QK_MOD_TAP_GET_TAP_KEYCODE(keymaps[0][row][col]);
+            }
+        }
+    }
+
+    combination_t *grid;
+    uint32_t       count = build_grid(&grid);
+
+    // Children write their results straight into shared memory
+    result_t *results = mmap(NULL, count * sizeof(*results), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (results == MAP_FAILED) {
+        perror("mmap");
+        return 2;
+    }
+
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    uint32_t next    = 0;
+    long     running = 0;
+    fflush(stdout);
+    while (next < count || running) {
+        if (next < count && running < jobs) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                run_combination(&grid[next], dense, &results[next]);
+                _exit(0);
+            }
+            if (pid < 0) {
+                perror("fork");
+                return 2;
+            }
+            next++;
+            running++;
+            continue;
+        }
+        wait(NULL);
+        running--;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    double   seconds = (double)(stop.tv_sec - start.tv_sec) + (double)(stop.tv_nsec - start.tv_nsec) / 1e9;
+    uint64_t scans   = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!results[i].done) {
+            fprintf(stderr, "combination %u did not finish\n", i);
+            return 2;
+        }
+        scans += results[i].scans;
+    }
+
+    print_report(grid, results, count, max_misfires);
+    // Timing on stderr keeps stdout identical across runs, -j and --dense
+    fprintf(stderr, "%u combinations on %ld cores in %.2f s: %.0f events/s, %.1f scans per event\n", count, jobs, seconds,
+            seconds > 0 ? (double)event_count * count / seconds : 0.0, event_count ? (double)scans / ((double)event_count * count) : 0.0);
+    return 0;
+}
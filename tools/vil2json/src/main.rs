@@ -1,17 +1,23 @@
-use anyhow::{Context, Result};
+use anyhow::{bail, Context, Result};
 use clap::Parser;
+use serde::de::{self, Deserializer, SeqAccess, Visitor};
 use serde::{Deserialize, Serialize};
-use serde_json::Value;
-use std::path::PathBuf;
+use std::collections::HashMap;
+use std::fmt;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Mutex;
+use std::thread;
 
 /// Convert VIAL .vil keyboard layout files to QMK keymap.json format
 #[derive(Parser, Debug)]
 #[command(author, version, about, long_about = None)]
 struct Args {
-    /// Input VIAL .vil file path
-    input: PathBuf,
+    /// Input VIAL .vil files, or directories whose .vil files are all converted
+    #[arg(required = true)]
+    inputs: Vec<PathBuf>,
 
-    /// Output keymap.json file path (defaults to input with .json extension)
+    /// Output keymap.json file path (defaults to input with .json extension; single input only)
     #[arg(short, long)]
     output: Option<PathBuf>,
 
@@ -30,11 +36,19 @@ struct Args {
     /// Skip completely empty layers (all KC_TRNS or KC_NO)
     #[arg(short = 'f', long)]
     filter_empty: bool,
+
+    /// Content hash cache file; inputs whose hash and output are unchanged are skipped
+    #[arg(short, long)]
+    cache: Option<PathBuf>,
+
+    /// Number of files converted in parallel (defaults to all cores)
+    #[arg(short, long)]
+    jobs: Option<usize>,
 }
 
 #[derive(Debug, Deserialize)]
 struct VialData {
-    layout: Vec<Vec<Vec<Value>>>, // 3D: layers[rows[keys]]
+    layout: Layers, // Flattened while parsing, see Layers
     #[serde(default)]
     #[allow(dead_code)]
     version: u32,
@@ -51,18 +65,160 @@ struct QmkKeymap {
     layers: Vec<Vec<String>>,
 }
 
+/// What happened to one input file
+enum Outcome {
+    Converted { layers: usize, keys: usize },
+    Unchanged,
+}
+
+/// Content hashes of an input (with the conversion options) and of the output it produced
+#[derive(Clone, Copy)]
+struct CacheEntry {
+    input: u64,
+    output: u64,
+}
+
+type Conversion = Result<(Outcome, CacheEntry)>;
+
 fn main() -> Result<()> {
     let args = Args::parse();
 
-    // Read VIAL file
-    let vil_content = std::fs::read_to_string(&args.input)
-        .with_context(|| format!("Failed to read VIAL file: {}", args.input.display()))?;
+    let inputs = expand_inputs(&args.inputs)?;
+    if args.output.is_some() && inputs.len() != 1 {
+        bail!(
+            "--output needs exactly one input file, got {}",
+            inputs.len()
+        );
+    }
+
+    let cache = match &args.cache {
+        Some(path) => load_cache(path)?,
+        None => HashMap::new(),
+    };
+
+    // Workers pull the next file off a shared index; results keep input order
+    let jobs = args
+        .jobs
+        .unwrap_or_else(|| thread::available_parallelism().map_or(1, |n| n.get()))
+        .clamp(1, inputs.len().max(1));
+    let next = AtomicUsize::new(0);
+    let results: Vec<Mutex<Option<Conversion>>> = inputs.iter().map(|_| Mutex::new(None)).collect();
+
+    thread::scope(|scope| {
+        for _ in 0..jobs {
+            scope.spawn(|| loop {
+                let i = next.fetch_add(1, Ordering::Relaxed);
+                if i >= inputs.len() {
+                    break;
+                }
+                let output = output_path(&args, &inputs[i]);
+                let result = convert(&args, &inputs[i], &output, cache.get(&output).copied());
+                *results[i].lock().unwrap() = Some(result);
+            });
+        }
+    });
+
+    let mut cache = cache;
+    let (mut converted, mut unchanged, mut failed) = (0, 0, 0);
+    for (input, result) in inputs.iter().zip(results) {
+        let output = output_path(&args, input);
+        match result
+            .into_inner()
+            .unwrap()
+            .expect("every input is converted")
+        {
+            Ok((Outcome::Converted { layers, keys }, entry)) => {
+                println!("✓ Converted {} layers with {} keys each", layers, keys);
+                println!("✓ Saved to {}", output.display());
+                cache.insert(output, entry);
+                converted += 1;
+            }
+            Ok((Outcome::Unchanged, _)) => {
+                println!("✓ Unchanged: {}", output.display());
+                unchanged += 1;
+            }
+            Err(err) => {
+                eprintln!("✗ {}: {:#}", input.display(), err);
+                failed += 1;
+            }
+        }
+    }
+
+    if let Some(path) = &args.cache {
+        save_cache(path, &cache)?;
+    }
+    if inputs.len() > 1 {
+        println!(
+            "✓ {} converted, {} unchanged, {} failed",
+            converted, unchanged, failed
+        );
+    }
+    if failed > 0 {
+        bail!("{} of {} conversions failed", failed, inputs.len());
+    }
+
+    Ok(())
+}
+
+/// Replace directories by the .vil files in them, sorted by name
+fn expand_inputs(inputs: &[PathBuf]) -> Result<Vec<PathBuf>> {
+    let mut files = Vec::new();
+
+    for input in inputs {
+        if !input.is_dir() {
+            files.push(input.clone());
+            continue;
+        }
+        let mut found: Vec<PathBuf> = std::fs::read_dir(input)
+            .with_context(|| format!("Failed to read directory: {}", input.display()))?
+            .filter_map(|entry| entry.ok().map(|entry| entry.path()))
+            .filter(|path| path.is_file() && path.extension().is_some_and(|ext| ext == "vil"))
+            .collect();
+        found.sort();
+        files.extend(found);
+    }
+
+    if files.is_empty() {
+        bail!("No .vil files found");
+    }
+    Ok(files)
+}
+
+/// Output path for an input: --output, or the input with a .json extension
+fn output_path(args: &Args, input: &Path) -> PathBuf {
+    args.output
+        .clone()
+        .unwrap_or_else(|| input.with_extension("json"))
+}
+
+/// Convert one file, unless the cache shows its output is already up to date
+fn convert(args: &Args, input: &Path, output: &Path, cached: Option<CacheEntry>) -> Conversion {
+    let vil_content = std::fs::read(input)
+        .with_context(|| format!("Failed to read VIAL file: {}", input.display()))?;
+
+    // The options change the output as much as the file does
+    let options = format!(
+        "{}\0{}\0{:?}\0{}\0{}",
+        args.keyboard,
+        args.layout,
+        args.max_layers,
+        args.filter_empty,
+        env!("CARGO_PKG_VERSION")
+    );
+    let input_hash = content_hash(&[&vil_content, options.as_bytes()]);
+
+    if let Some(entry) = cached.filter(|entry| entry.input == input_hash) {
+        if let Ok(existing) = std::fs::read(output) {
+            if content_hash(&[&existing]) == entry.output {
+                return Ok((Outcome::Unchanged, entry));
+            }
+        }
+    }
 
     let vil_data: VialData =
-        serde_json::from_str(&vil_content).context("Failed to parse VIAL JSON")?;
+        serde_json::from_slice(&vil_content).context("Failed to parse VIAL JSON")?;
 
-    // Flatten layers and filter
-    let mut layers: Vec<Vec<String>> = vil_data.layout.into_iter().map(flatten_layer).collect();
+    let mut layers = vil_data.layout.0;
 
     // Apply max_layers limit
     if let Some(max) = args.max_layers {
@@ -84,62 +240,192 @@ fn main() -> Result<()> {
     // Build QMK keymap structure
     let qmk_keymap = QmkKeymap {
         version: 1,
-        keyboard: args.keyboard,
-        layout: args.layout,
+        keyboard: args.keyboard.clone(),
+        layout: args.layout.clone(),
         layers,
     };
 
-    // Determine output path
-    let output_path = args.output.unwrap_or_else(|| {
-        let mut path = args.input.clone();
-        path.set_extension("json");
-        path
-    });
-
     // Write output
     let output_json =
         serde_json::to_string_pretty(&qmk_keymap).context("Failed to serialize QMK keymap")?;
 
-    std::fs::write(&output_path, output_json)
-        .with_context(|| format!("Failed to write output file: {}", output_path.display()))?;
+    std::fs::write(output, &output_json)
+        .with_context(|| format!("Failed to write output file: {}", output.display()))?;
 
-    println!(
-        "✓ Converted {} layers with {} keys each",
-        layer_count, key_count
-    );
-    println!("✓ Saved to {}", output_path.display());
+    let entry = CacheEntry {
+        input: input_hash,
+        output: content_hash(&[output_json.as_bytes()]),
+    };
+    Ok((
+        Outcome::Converted {
+            layers: layer_count,
+            keys: key_count,
+        },
+        entry,
+    ))
+}
 
-    Ok(())
+/// 64-bit FNV-1a over the given byte strings, for change detection only
+fn content_hash(parts: &[&[u8]]) -> u64 {
+    let mut hash: u64 = 0xcbf2_9ce4_8422_2325;
+    for part in parts {
+        for &byte in *part {
+            hash ^= u64::from(byte);
+            hash = hash.wrapping_mul(0x0000_0100_0000_01b3);
+        }
+    }
+    hash
+}
+
+/// Read the cache, one "<input hash> <output hash> <output path>" line per output
+fn load_cache(path: &Path) -> Result<HashMap<PathBuf, CacheEntry>> {
+    let text = match std::fs::read_to_string(path) {
+        Ok(text) => text,
+        Err(err) if err.kind() == std::io::ErrorKind::NotFound => return Ok(HashMap::new()),
+        Err(err) => {
+            return Err(err).with_context(|| format!("Failed to read cache: {}", path.display()))
+        }
+    };
+
+    let mut cache = HashMap::new();
+    for line in text.lines() {
+        let mut fields = line.splitn(3, ' ');
+        let (Some(input), Some(output), Some(file)) = (fields.next(), fields.next(), fields.next())
+        else {
+            continue;
+        };
+        if let (Ok(input), Ok(output)) = (
+            u64::from_str_radix(input, 16),
+            u64::from_str_radix(output, 16),
+        ) {
+            cache.insert(PathBuf::from(file), CacheEntry { input, output });
+        }
+    }
+    Ok(cache)
+}
+
+fn save_cache(path: &Path, cache: &HashMap<PathBuf, CacheEntry>) -> Result<()> {
+    let mut entries: Vec<_> = cache.iter().collect();
+    entries.sort_by(|a, b| a.0.cmp(b.0));
+    let lines: Vec<String> = entries
+        .into_iter()
+        .map(|(file, entry)| {
+            format!(
+                "{:016x} {:016x} {}",
+                entry.input,
+                entry.output,
+                file.display()
+            )
+        })
+        .collect();
+
+    if let Some(dir) = path.parent().filter(|dir| !dir.as_os_str().is_empty()) {
+        std::fs::create_dir_all(dir)
+            .with_context(|| format!("Failed to create cache directory: {}", dir.display()))?;
+    }
+    // Write next to it and rename, so an interrupted run never leaves half a cache
+    let tmp = path.with_extension("tmp");
+    std::fs::write(&tmp, lines.join("\n") + "\n")
+        .and_then(|_| std::fs::rename(&tmp, path))
+        .with_context(|| format!("Failed to write cache: {}", path.display()))
+}
+
+/// Layers of a .vil file, flattened one layer at a time as they are parsed
+///
+/// Only the keycode strings of one layer's rows are held before flattening;
+/// the rest of the file (macros, tap dances, settings) is skipped unparsed.
+#[derive(Debug)]
+struct Layers(Vec<Vec<String>>);
+
+impl<'de> Deserialize<'de> for Layers {
+    fn deserialize<D: Deserializer<'de>>(deserializer: D) -> Result<Self, D::Error> {
+        struct LayersVisitor;
+
+        impl<'de> Visitor<'de> for LayersVisitor {
+            type Value = Layers;
+
+            fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+                f.write_str("an array of layers")
+            }
+
+            fn visit_seq<A: SeqAccess<'de>>(self, mut seq: A) -> Result<Layers, A::Error> {
+                let mut layers = Vec::new();
+                while let Some(rows) = seq.next_element::<Vec<Vec<Key>>>()? {
+                    if rows.len() < 8 {
+                        return Err(de::Error::custom(format_args!(
+                            "layer {} has {} rows, expected 8",
+                            layers.len(),
+                            rows.len()
+                        )));
+                    }
+                    layers.push(flatten_layer(rows));
+                }
+                Ok(Layers(layers))
+            }
+        }
+
+        deserializer.deserialize_seq(LayersVisitor)
+    }
+}
+
+/// One matrix position of a .vil layer: a keycode, or None for -1 placeholders
+#[derive(Debug)]
+struct Key(Option<String>);
+
+impl<'de> Deserialize<'de> for Key {
+    fn deserialize<D: Deserializer<'de>>(deserializer: D) -> Result<Self, D::Error> {
+        struct KeyVisitor;
+
+        impl<'de> Visitor<'de> for KeyVisitor {
+            type Value = Key;
+
+            fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+                f.write_str("a keycode string or -1")
+            }
+
+            fn visit_str<E: de::Error>(self, value: &str) -> Result<Key, E> {
+                Ok(Key(Some(value.to_owned())))
+            }
+
+            fn visit_string<E: de::Error>(self, value: String) -> Result<Key, E> {
+                Ok(Key(Some(value)))
+            }
+
+            fn visit_i64<E: de::Error>(self, _: i64) -> Result<Key, E> {
+                Ok(Key(None))
+            }
+
+            fn visit_u64<E: de::Error>(self, _: u64) -> Result<Key, E> {
+                Ok(Key(None))
+            }
+
+            fn visit_f64<E: de::Error>(self, _: f64) -> Result<Key, E> {
+                Ok(Key(None))
+            }
+        }
+
+        deserializer.deserialize_any(KeyVisitor)
+    }
 }
 
 /// Flatten a 2D layer matrix into a 1D array, removing -1 placeholders
 /// VIAL stores split keyboards as 8 rows: left side (0-3), right side (4-7)
 /// QMK expects keys ordered by physical rows: row0_left + row0_right, row1_left + row1_right, etc.
-fn flatten_layer(layer_matrix: Vec<Vec<Value>>) -> Vec<String> {
+fn flatten_layer(layer_matrix: Vec<Vec<Key>>) -> Vec<String> {
     // Split into left (rows 0-3) and right (rows 4-7) sides
-    let (left_rows, right_rows) = layer_matrix.split_at(4);
+    let mut rows = layer_matrix.into_iter();
+    let left_rows: Vec<Vec<Key>> = rows.by_ref().take(4).collect();
+    let right_rows: Vec<Vec<Key>> = rows.collect();
 
     let mut result = Vec::new();
 
     // For each row index, take left row then corresponding right row
-    for i in 0..4 {
+    for (left, right) in left_rows.into_iter().zip(right_rows) {
         // Add left row keys (left-to-right, filter -1 placeholders)
-        for key in &left_rows[i] {
-            match key {
-                Value::Number(n) if n.as_i64() == Some(-1) => {}
-                Value::String(s) => result.push(s.clone()),
-                _ => {}
-            }
-        }
+        result.extend(left.into_iter().filter_map(|key| key.0));
 
         // Add right row keys in REVERSE (split keyboard is mirrored, filter -1 placeholders)
-        for key in right_rows[i].iter().rev() {
-            match key {
-                Value::Number(n) if n.as_i64() == Some(-1) => {}
-                Value::String(s) => result.push(s.clone()),
-                _ => {}
-            }
-        }
+        result.extend(right.into_iter().rev().filter_map(|key| key.0));
     }
 
     result
@@ -164,20 +450,20 @@ mod tests {
         // Right side: row0=[Y,U], row1=[O,I], row2=[slash], row3=[]
         // Expected: row0_left + row0_right_reversed, row1_left + row1_right_reversed, ...
         // Result: [Q, W, U, Y, A, S, I, O, Z, slash]
-        let layer = vec![
+        let layer = json!([
             // Left rows (0-3)
-            vec![json!("KC_Q"), json!("KC_W"), json!(-1)],
-            vec![json!("KC_A"), json!(-1), json!("KC_S")],
-            vec![json!("KC_Z")],
-            vec![],
+            ["KC_Q", "KC_W", -1],
+            ["KC_A", -1, "KC_S"],
+            ["KC_Z"],
+            [],
             // Right rows (4-7) - stored inner-to-outer, will be reversed
-            vec![json!("KC_Y"), json!("KC_U"), json!(-1)],
-            vec![json!("KC_O"), json!(-1), json!("KC_I")],
-            vec![json!("KC_SLASH")],
-            vec![],
-        ];
+            ["KC_Y", "KC_U", -1],
+            ["KC_O", -1, "KC_I"],
+            ["KC_SLASH"],
+            [],
+        ]);
 
-        let flattened = flatten_layer(layer);
+        let flattened = flatten_layer(serde_json::from_value(layer).unwrap());
         assert_eq!(
             flattened,
             vec![
@@ -186,6 +472,32 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_parse_vial_skips_other_sections() {
+        let row = json!(["KC_A", -1]);
+        let vil = json!({
+            "version": 1,
+            "uid": 42,
+            "layout": [[row, row, row, row, row, row, row, row]],
+            "macro": [[["tap", "KC_X"]]],
+            "settings": {"7": 175},
+        });
+
+        let data: VialData = serde_json::from_slice(vil.to_string().as_bytes()).unwrap();
+        assert_eq!(data.layout.0, vec![vec!["KC_A"; 8]]);
+
+        let short = json!({"layout": [[row, row]]});
+        assert!(serde_json::from_slice::<VialData>(short.to_string().as_bytes()).is_err());
+    }
+
+    #[test]
+    fn test_content_hash() {
+        assert_eq!(content_hash(&[]), 0xcbf2_9ce4_8422_2325);
+        assert_eq!(content_hash(&[b"a"]), 0xaf63_dc4c_8601_ec8c);
+        assert_eq!(content_hash(&[b"ab", b"c"]), content_hash(&[b"abc"]));
+        assert_ne!(content_hash(&[b"abc"]), content_hash(&[b"abd"]));
+    }
+
     #[test]
     fn test_is_layer_empty() {
         assert!(is_layer_empty(&vec![